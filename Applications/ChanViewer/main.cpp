@@ -1,6 +1,6 @@
 #include "BoardListModel.h"
 #include "ThreadCatalogModel.h"
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GApplication.h>
 #include <LibGUI/GBoxLayout.h>
 #include <LibGUI/GComboBox.h>
@@ -15,7 +15,7 @@ int main(int argc, char** argv)
     auto window = GWindow::construct();
     window->set_title("ChanViewer");
     window->set_rect(100, 100, 800, 500);
-    window->set_icon(load_png("/res/icons/16x16/app-chanviewer.png"));
+    window->set_icon(GraphicsBitmap::load_from_file("/res/icons/16x16/app-chanviewer.png"));
 
     auto widget = GWidget::construct();
     window->set_main_widget(widget);
@@ -1,5 +1,5 @@
 #include "DisplayProperties.h"
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GApplication.h>
 #include <LibGUI/GBoxLayout.h>
 #include <LibGUI/GWidget.h>
@@ -15,7 +15,7 @@ int main(int argc, char** argv)
     window->resize(400, 448);
     window->set_resizable(false);
     window->set_main_widget(instance.root_widget());
-    window->set_icon(load_png("/res/icons/16x16/app-display-properties.png"));
+    window->set_icon(GraphicsBitmap::load_from_file("/res/icons/16x16/app-display-properties.png"));
 
     window->show();
     return app.exec();
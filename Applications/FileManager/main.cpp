@@ -5,7 +5,7 @@
 #include <AK/StringBuilder.h>
 #include <LibCore/CConfigFile.h>
 #include <LibCore/CUserInfo.h>
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GAction.h>
 #include <LibGUI/GActionGroup.h>
 #include <LibGUI/GApplication.h>
@@ -439,7 +439,7 @@ int main(int argc, char** argv)
     window->set_main_widget(widget);
     window->show();
 
-    window->set_icon(load_png("/res/icons/16x16/filetype-folder.png"));
+    window->set_icon(GraphicsBitmap::load_from_file("/res/icons/16x16/filetype-folder.png"));
 
     // Read direcory read mode from config.
     auto dir_view_mode = config->read_entry("DirectoryView", "ViewMode", "Icon");
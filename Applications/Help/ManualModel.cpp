@@ -2,7 +2,7 @@
 #include "ManualNode.h"
 #include "ManualPageNode.h"
 #include "ManualSectionNode.h"
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 
 static ManualSectionNode s_sections[] = {
     { "1", "Command-line programs" },
@@ -18,8 +18,8 @@ static ManualSectionNode s_sections[] = {
 ManualModel::ManualModel()
 {
     // FIXME: need some help from the icon fairy ^)
-    m_section_icon.set_bitmap_for_size(16, load_png("/res/icons/16x16/book.png"));
-    m_page_icon.set_bitmap_for_size(16, load_png("/res/icons/16x16/filetype-unknown.png"));
+    m_section_icon.set_bitmap_for_size(16, GraphicsBitmap::load_from_file("/res/icons/16x16/book.png"));
+    m_page_icon.set_bitmap_for_size(16, GraphicsBitmap::load_from_file("/res/icons/16x16/filetype-unknown.png"));
 }
 
 String ManualModel::page_path(const GModelIndex& index) const
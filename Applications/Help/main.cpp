@@ -1,7 +1,7 @@
 #include "History.h"
 #include "ManualModel.h"
 #include <LibCore/CFile.h>
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GAboutDialog.h>
 #include <LibGUI/GAction.h>
 #include <LibGUI/GApplication.h>
@@ -131,7 +131,7 @@ int main(int argc, char* argv[])
 
     auto app_menu = make<GMenu>("Help");
     app_menu->add_action(GAction::create("About", [&](const GAction&) {
-        GAboutDialog::show("Help", load_png("/res/icons/16x16/book.png"), window);
+        GAboutDialog::show("Help", GraphicsBitmap::load_from_file("/res/icons/16x16/book.png"), window);
     }));
     app_menu->add_separator();
     app_menu->add_action(GCommonActions::make_quit_action([](auto&) {
@@ -149,7 +149,7 @@ int main(int argc, char* argv[])
     window->set_main_widget(widget);
     window->show();
 
-    window->set_icon(load_png("/res/icons/16x16/book.png"));
+    window->set_icon(GraphicsBitmap::load_from_file("/res/icons/16x16/book.png"));
 
     return app.exec();
 }
@@ -2,7 +2,7 @@
 #include <AK/Optional.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/CFile.h>
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GAboutDialog.h>
 #include <LibGUI/GAction.h>
 #include <LibGUI/GBoxLayout.h>
@@ -176,7 +176,7 @@ HexEditorWidget::HexEditorWidget()
 
     auto help_menu = make<GMenu>("Help");
     help_menu->add_action(GAction::create("About", [&](const GAction&) {
-        GAboutDialog::show("Hex Editor", load_png("/res/icons/32x32/app-hexeditor.png"), window());
+        GAboutDialog::show("Hex Editor", GraphicsBitmap::load_from_file("/res/icons/32x32/app-hexeditor.png"), window());
     }));
     menubar->add_menu(move(help_menu));
 
@@ -1,5 +1,5 @@
 #include "HexEditorWidget.h"
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 
 int main(int argc, char** argv)
 {
@@ -19,7 +19,7 @@ int main(int argc, char** argv)
     };
 
     window->show();
-    window->set_icon(load_png("/res/icons/16x16/app-hexeditor.png"));
+    window->set_icon(GraphicsBitmap::load_from_file("/res/icons/16x16/app-hexeditor.png"));
 
     if (argc >= 2)
         hex_editor_widget->open_file(argv[1]);
@@ -2,7 +2,7 @@
 #include "IRCChannel.h"
 #include "IRCWindow.h"
 #include "IRCWindowListModel.h"
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GAboutDialog.h>
 #include <LibGUI/GAction.h>
 #include <LibGUI/GApplication.h>
@@ -29,7 +29,7 @@ IRCAppWindow::IRCAppWindow()
     ASSERT(!s_the);
     s_the = this;
 
-    set_icon(load_png("/res/icons/16x16/app-irc-client.png"));
+    set_icon(GraphicsBitmap::load_from_file("/res/icons/16x16/app-irc-client.png"));
 
     update_title();
     set_rect(200, 200, 600, 400);
@@ -144,7 +144,7 @@ void IRCAppWindow::setup_menus()
 
     auto help_menu = make<GMenu>("Help");
     help_menu->add_action(GAction::create("About", [this](const GAction&) {
-        GAboutDialog::show("IRC Client", load_png("/res/icons/32x32/app-irc-client.png"), this);
+        GAboutDialog::show("IRC Client", GraphicsBitmap::load_from_file("/res/icons/32x32/app-irc-client.png"), this);
     }));
     menubar->add_menu(move(help_menu));
 
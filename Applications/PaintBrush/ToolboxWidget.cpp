@@ -5,9 +5,9 @@
 #include "PenTool.h"
 #include "PickerTool.h"
 #include "EraseTool.h"
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GBoxLayout.h>
 #include <LibGUI/GButton.h>
-#include <LibDraw/PNGLoader.h>
 
 class ToolButton final : public GButton {
     C_OBJECT(ToolButton)
@@ -54,7 +54,7 @@ ToolboxWidget::ToolboxWidget(GWidget* parent)
         button->set_checkable(true);
         button->set_exclusive(true);
 
-        button->set_icon(load_png(String::format("/res/icons/paintbrush/%s.png", String(icon_name).characters())));
+        button->set_icon(GraphicsBitmap::load_from_file(String::format("/res/icons/paintbrush/%s.png", String(icon_name).characters())));
 
         button->on_checked = [button = button.ptr()](auto checked) {
             if (checked)
@@ -19,7 +19,7 @@ int main(int argc, char** argv)
     auto window = GWindow::construct();
     window->set_title("PaintBrush");
     window->set_rect(100, 100, 640, 480);
-    window->set_icon(load_png("/res/icons/16x16/app-paintbrush.png"));
+    window->set_icon(GraphicsBitmap::load_from_file("/res/icons/16x16/app-paintbrush.png"));
 
     auto horizontal_container = GWidget::construct();
     window->set_main_widget(horizontal_container);
@@ -66,7 +66,7 @@ int main(int argc, char** argv)
 
     auto help_menu = make<GMenu>("Help");
     help_menu->add_action(GAction::create("About", [&](auto&) {
-        GAboutDialog::show("PaintBrush", load_png("/res/icons/32x32/app-paintbrush.png"), window);
+        GAboutDialog::show("PaintBrush", GraphicsBitmap::load_from_file("/res/icons/32x32/app-paintbrush.png"), window);
     }));
     menubar->add_menu(move(help_menu));
 
@@ -2,7 +2,7 @@
 #include "PianoWidget.h"
 #include <LibAudio/AClientConnection.h>
 #include <LibCore/CFile.h>
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GAction.h>
 #include <LibGUI/GApplication.h>
 #include <LibGUI/GMenu.h>
@@ -23,7 +23,7 @@ int main(int argc, char** argv)
     auto piano_widget = PianoWidget::construct();
     window->set_main_widget(piano_widget);
     window->show();
-    window->set_icon(load_png("/res/icons/16x16/app-piano.png"));
+    window->set_icon(GraphicsBitmap::load_from_file("/res/icons/16x16/app-piano.png"));
 
     LibThread::Thread sound_thread([piano_widget = piano_widget.ptr()] {
         auto audio = CFile::construct("/dev/audio");
@@ -8,7 +8,7 @@
 #include "ProcessStacksWidget.h"
 #include "ProcessTableView.h"
 #include <LibCore/CTimer.h>
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GAboutDialog.h>
 #include <LibGUI/GAction.h>
 #include <LibGUI/GApplication.h>
@@ -158,7 +158,7 @@ int main(int argc, char** argv)
 
     auto help_menu = make<GMenu>("Help");
     help_menu->add_action(GAction::create("About", [&](const GAction&) {
-        GAboutDialog::show("SystemMonitor", load_png("/res/icons/32x32/app-system-monitor.png"), window);
+        GAboutDialog::show("SystemMonitor", GraphicsBitmap::load_from_file("/res/icons/32x32/app-system-monitor.png"), window);
     }));
     menubar->add_menu(move(help_menu));
 
@@ -183,7 +183,7 @@ int main(int argc, char** argv)
 
     window->show();
 
-    window->set_icon(load_png("/res/icons/16x16/app-system-monitor.png"));
+    window->set_icon(GraphicsBitmap::load_from_file("/res/icons/16x16/app-system-monitor.png"));
 
     return app.exec();
 }
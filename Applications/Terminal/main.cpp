@@ -1,7 +1,7 @@
 #include <Kernel/KeyCode.h>
 #include <LibCore/CArgsParser.h>
 #include <LibCore/CUserInfo.h>
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GAboutDialog.h>
 #include <LibGUI/GAction.h>
 #include <LibGUI/GApplication.h>
@@ -173,7 +173,7 @@ int main(int argc, char** argv)
     window->move_to(300, 300);
     terminal->apply_size_increments_to_window(*window);
     window->show();
-    window->set_icon(load_png("/res/icons/16x16/app-terminal.png"));
+    window->set_icon(GraphicsBitmap::load_from_file("/res/icons/16x16/app-terminal.png"));
     terminal->set_should_beep(config->read_bool_entry("Window", "AudibleBeep", false));
 
     RefPtr<GWindow> settings_window;
@@ -191,7 +191,7 @@ int main(int argc, char** argv)
             exit(1);
         }
     }));
-    app_menu->add_action(GAction::create("Settings...", load_png("/res/icons/gear16.png"),
+    app_menu->add_action(GAction::create("Settings...", GraphicsBitmap::load_from_file("/res/icons/gear16.png"),
         [&](const GAction&) {
             if (!settings_window) {
                 settings_window = create_settings_window(*terminal, config);
@@ -230,7 +230,7 @@ int main(int argc, char** argv)
 
     auto help_menu = make<GMenu>("Help");
     help_menu->add_action(GAction::create("About", [&](const GAction&) {
-        GAboutDialog::show("Terminal", load_png("/res/icons/32x32/app-terminal.png"), window);
+        GAboutDialog::show("Terminal", GraphicsBitmap::load_from_file("/res/icons/32x32/app-terminal.png"), window);
     }));
     menubar->add_menu(move(help_menu));
 
@@ -2,7 +2,7 @@
 #include <AK/Optional.h>
 #include <AK/StringBuilder.h>
 #include <LibCore/CFile.h>
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GAboutDialog.h>
 #include <LibGUI/GAction.h>
 #include <LibGUI/GBoxLayout.h>
@@ -106,7 +106,7 @@ TextEditorWidget::TextEditorWidget()
         m_editor->set_focus(true);
     };
 
-    m_find_action = GAction::create("Find...", { Mod_Ctrl, Key_F }, load_png("/res/icons/16x16/find.png"), [this](auto&) {
+    m_find_action = GAction::create("Find...", { Mod_Ctrl, Key_F }, GraphicsBitmap::load_from_file("/res/icons/16x16/find.png"), [this](auto&) {
         m_find_widget->set_visible(true);
         m_find_textbox->set_focus(true);
         m_find_textbox->select_all();
@@ -229,7 +229,7 @@ TextEditorWidget::TextEditorWidget()
 
     auto help_menu = make<GMenu>("Help");
     help_menu->add_action(GAction::create("About", [&](const GAction&) {
-        GAboutDialog::show("TextEditor", load_png("/res/icons/32x32/app-texteditor.png"), window());
+        GAboutDialog::show("TextEditor", GraphicsBitmap::load_from_file("/res/icons/32x32/app-texteditor.png"), window());
     }));
     menubar->add_menu(move(help_menu));
 
@@ -1,5 +1,5 @@
 #include "TextEditorWidget.h"
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 
 int main(int argc, char** argv)
 {
@@ -22,7 +22,7 @@ int main(int argc, char** argv)
         text_widget->open_sesame(argv[1]);
 
     window->show();
-    window->set_icon(load_png("/res/icons/TextEditor16.png"));
+    window->set_icon(GraphicsBitmap::load_from_file("/res/icons/TextEditor16.png"));
 
     return app.exec();
 }
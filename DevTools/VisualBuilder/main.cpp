@@ -2,7 +2,7 @@
 #include "VBPropertiesWindow.h"
 #include "VBWidget.h"
 #include "VBWidgetPropertyModel.h"
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GAboutDialog.h>
 #include <LibGUI/GAction.h>
 #include <LibGUI/GApplication.h>
@@ -56,7 +56,7 @@ int main(int argc, char** argv)
 
     auto help_menu = make<GMenu>("Help");
     help_menu->add_action(GAction::create("About", [&](const GAction&) {
-        GAboutDialog::show("Visual Builder", load_png("/res/icons/32x32/app-visual-builder.png"), window);
+        GAboutDialog::show("Visual Builder", GraphicsBitmap::load_from_file("/res/icons/32x32/app-visual-builder.png"), window);
     }));
     menubar->add_menu(move(help_menu));
 
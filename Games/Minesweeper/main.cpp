@@ -1,6 +1,6 @@
 #include "Field.h"
 #include <LibCore/CConfigFile.h>
-#include <LibDraw/PNGLoader.h>
+#include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GAction.h>
 #include <LibGUI/GApplication.h>
 #include <LibGUI/GBoxLayout.h>
@@ -98,7 +98,7 @@ int main(int argc, char** argv)
 
     window->show();
 
-    window->set_icon(load_png("/res/icons/minesweeper/mine.png"));
+    window->set_icon(GraphicsBitmap::load_from_file("/res/icons/minesweeper/mine.png"));
 
     return app.exec();
 }
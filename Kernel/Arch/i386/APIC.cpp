@@ -2,13 +2,19 @@
 #include <AK/Types.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Arch/i386/APIC.h>
+#include <Kernel/Arch/i386/PIT.h>
+#include <Kernel/Arch/i386/Processor.h>
+#include <Kernel/Heap/kmalloc.h>
 #include <Kernel/IO.h>
+#include <Kernel/Scheduler.h>
 #include <Kernel/VM/MemoryManager.h>
 
 #define IRQ_APIC_SPURIOUS 0x1f
 
 #define APIC_BASE_MSR 0x1b
 
+#define APIC_REG_ID 0x20
+#define APIC_REG_EOI 0xb0
 #define APIC_REG_LD 0xd0
 #define APIC_REG_DF 0xe0
 #define APIC_REG_SIV 0xf0
@@ -20,6 +26,11 @@
 #define APIC_REG_LVT_LINT0 0x350
 #define APIC_REG_LVT_LINT1 0x360
 #define APIC_REG_LVT_ERR 0x370
+#define APIC_REG_TIMER_INITIAL_COUNT 0x380
+#define APIC_REG_TIMER_CURRENT_COUNT 0x390
+#define APIC_REG_TIMER_DIVIDE_CONFIG 0x3e0
+
+#define APIC_TIMER_DIVIDE_BY_16 0x3
 
 extern "C" void apic_spurious_interrupt_entry();
 
@@ -28,6 +39,49 @@ asm(
     "apic_spurious_interrupt_entry: \n"
     "    iret\n");
 
+extern "C" void apic_timer_interrupt_entry();
+extern "C" void apic_timer_interrupt_handler(RegisterDump);
+
+asm(
+    ".globl apic_timer_interrupt_entry \n"
+    "apic_timer_interrupt_entry: \n"
+    "    pushl $0x0\n"
+    "    pusha\n"
+    "    pushw %ds\n"
+    "    pushw %es\n"
+    "    pushw %fs\n"
+    "    pushw %gs\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    popw %ds\n"
+    "    popw %es\n"
+    "    popw %fs\n"
+    "    popw %gs\n"
+    "    cld\n"
+    "    call apic_timer_interrupt_handler\n"
+    "    popw %gs\n"
+    "    popw %gs\n"
+    "    popw %fs\n"
+    "    popw %es\n"
+    "    popw %ds\n"
+    "    popa\n"
+    "    add $0x4, %esp\n"
+    "    iret\n");
+
+void apic_timer_interrupt_handler(RegisterDump regs)
+{
+    // Like the PIT tick, acknowledge first since we may not return here.
+    APIC::eoi();
+    KernelLocker locker;
+    if (Processor::local().is_bsp())
+        Scheduler::timer_deadline(regs);
+    else
+        Scheduler::timer_tick(regs);
+}
+
 namespace APIC {
 
 class ICRReg
@@ -46,7 +100,7 @@ public:
     enum DestinationMode
     {
         Physical = 0x0,
-        Logical = 0x0,
+        Logical = 0x1,
     };
     enum Level
     {
@@ -66,16 +120,21 @@ public:
         AllExcludingSelf = 0x3,
     };
 
-    ICRReg(u8 vector, DeliveryMode delivery_mode, DestinationMode destination_mode, Level level, TriggerMode trigger_mode, DestinationShorthand destination):
-        m_reg(vector | (delivery_mode << 8) | (destination_mode << 11) | (level << 14) | (static_cast<u32>(trigger_mode) << 15) | (destination << 18))
+    ICRReg(u8 vector, DeliveryMode delivery_mode, DestinationMode destination_mode, Level level, TriggerMode trigger_mode, DestinationShorthand destination, u8 destination_field = 0):
+        m_reg(vector | (delivery_mode << 8) | (destination_mode << 11) | (level << 14) | (static_cast<u32>(trigger_mode) << 15) | (destination << 18)),
+        m_destination(destination_field)
     {
     }
 
     u32 low() const { return m_reg; }
-    u32 high() const { return 0; }
+    u32 high() const { return m_destination << 24; }
+
+private:
+    u8 m_destination { 0 };
 };
 
 static volatile u8* g_apic_base = nullptr;
+static u32 s_timer_ticks_per_ms;
 
 static PhysicalAddress get_base()
 {
@@ -103,22 +162,87 @@ static void apic_write(u32 off, u32 val)
     *reinterpret_cast<volatile u32*>(&g_apic_base[off]) = val;
 }
 
+#define APIC_ICR_DELIVERY_PENDING (1 << 12)
+
 static void apic_write_icr(const ICRReg& icr)
 {
+    while (apic_read(APIC_REG_ICR_LOW) & APIC_ICR_DELIVERY_PENDING)
+        asm volatile("pause");
     apic_write(APIC_REG_ICR_HIGH, icr.high());
     apic_write(APIC_REG_ICR_LOW, icr.low());
 }
 
 #define APIC_LVT_MASKED (1 << 15)
+#define APIC_LVT_TIMER_PERIODIC (1 << 17)
 #define APIC_LVT_TRIGGER_LEVEL (1 << 14)
 #define APIC_LVT(iv, dm) ((iv & 0xff) | ((dm & 0x7) << 8))
 
+// Application processors start here in real mode, with CS:IP = 0800:0000.
+// We switch to protected mode with a minimal flat GDT, turn on paging with
+// the kernel page directory, claim a processor index and the stack that goes
+// with it, and enter init_ap(index). The fields at the end are filled in by
+// boot_application_processors() in the copy at P8000.
 asm(
     ".globl apic_ap_start \n"
     ".type apic_ap_start, @function \n"
     "apic_ap_start: \n"
     ".set begin_apic_ap_start, . \n"
-    "    jmp apic_ap_start\n" // TODO: implement
+    ".code16 \n"
+    "    cli \n"
+    "    cld \n"
+    "    mov %cs, %ax \n"
+    "    mov %ax, %ds \n"
+    "    lgdtl (apic_ap_start_gdtr - begin_apic_ap_start) \n"
+    "    mov %cr0, %eax \n"
+    "    orl $0x1, %eax \n"
+    "    mov %eax, %cr0 \n"
+    "    ljmpl $0x8, $(0x8000 + apic_ap_start32 - begin_apic_ap_start) \n"
+    ".code32 \n"
+    "apic_ap_start32: \n"
+    "    mov $0x10, %ax \n"
+    "    mov %ax, %ds \n"
+    "    mov %ax, %es \n"
+    "    mov %ax, %fs \n"
+    "    mov %ax, %gs \n"
+    "    mov %ax, %ss \n"
+    "    movl $0x1, %eax \n"
+    "    lock xaddl %eax, (0x8000 + apic_ap_start_next_index - begin_apic_ap_start) \n"
+    "    cmpl $8, %eax \n" // Processor::max_count
+    "    jae 1f \n"
+    "    movl %cr4, %ebx \n"
+    "    orl $0x10, %ebx \n"
+    "    movl %ebx, %cr4 \n"
+    "    movl (0x8000 + apic_ap_start_cr3 - begin_apic_ap_start), %ebx \n"
+    "    movl %ebx, %cr3 \n"
+    "    movl %cr0, %ebx \n"
+    "    orl $0x80000001, %ebx \n"
+    "    movl %ebx, %cr0 \n"
+    "    movl (0x8000 + apic_ap_start_stacks - begin_apic_ap_start), %ebx \n"
+    "    movl (%ebx,%eax,4), %esp \n"
+    "    pushl %eax \n"
+    "    movl $init_ap, %ebx \n"
+    "    call *%ebx \n"
+    "1: \n"
+    "    cli \n"
+    "    hlt \n"
+    "    jmp 1b \n"
+    ".align 8 \n"
+    "apic_ap_start_gdt: \n"
+    "    .quad 0x0000000000000000 \n"
+    "    .quad 0x00cf9a000000ffff \n"
+    "    .quad 0x00cf92000000ffff \n"
+    "apic_ap_start_gdtr: \n"
+    "    .word apic_ap_start_gdtr - apic_ap_start_gdt - 1 \n"
+    "    .long 0x8000 + apic_ap_start_gdt - begin_apic_ap_start \n"
+    ".globl apic_ap_start_next_index \n"
+    "apic_ap_start_next_index: \n"
+    "    .long 1 \n"
+    ".globl apic_ap_start_cr3 \n"
+    "apic_ap_start_cr3: \n"
+    "    .long 0 \n"
+    ".globl apic_ap_start_stacks \n"
+    "apic_ap_start_stacks: \n"
+    "    .long 0 \n"
     ".set end_apic_ap_start, . \n"
     "\n"
     ".globl apic_ap_start_size \n"
@@ -127,6 +251,17 @@ asm(
 
 extern "C" void apic_ap_start(void);
 extern "C" u16 apic_ap_start_size;
+extern "C" u32 apic_ap_start_next_index;
+extern "C" u32 apic_ap_start_cr3;
+extern "C" u32 apic_ap_start_stacks;
+
+static constexpr size_t ap_stack_size = 16 * KB;
+
+static u32& trampoline_field(u32& field)
+{
+    auto offset = reinterpret_cast<u8*>(&field) - reinterpret_cast<u8*>(apic_ap_start);
+    return *reinterpret_cast<u32*>(0x8000 + offset);
+}
 
 bool init()
 {
@@ -159,7 +294,7 @@ void enable(u32 cpu)
     apic_write(APIC_REG_SIV, apic_read(APIC_REG_SIV) | 0x100);
     
     // local destination mode (flat mode)
-    apic_write(APIC_REG_DF, 0xf000000);
+    apic_write(APIC_REG_DF, 0xffffffff);
     
     // set destination id (note that this limits it to 8 cpus)
     apic_write(APIC_REG_LD, (1 << cpu) << 24);
@@ -172,22 +307,120 @@ void enable(u32 cpu)
     apic_write(APIC_REG_LVT_LINT0, APIC_LVT(0x1f, 7) | APIC_LVT_MASKED);
     apic_write(APIC_REG_LVT_LINT1, APIC_LVT(0xff, 4) | APIC_LVT_TRIGGER_LEVEL); // nmi
     apic_write(APIC_REG_LVT_ERR, APIC_LVT(0xe3, 0) | APIC_LVT_MASKED);
-    
-    if (cpu == 0) {
-        static volatile u32 foo = 0;
-        
-        // INIT
-        apic_write_icr(ICRReg(0, ICRReg::INIT, ICRReg::Physical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::AllExcludingSelf));
+}
+
+void boot_application_processors()
+{
+    ASSERT(g_apic_base);
+
+    static u32 s_ap_stack_tops[Processor::max_count];
+    for (u32 i = 1; i < Processor::max_count; ++i) {
+        auto* stack = reinterpret_cast<u8*>(kmalloc_eternal(ap_stack_size));
+        s_ap_stack_tops[i] = reinterpret_cast<u32>(stack + ap_stack_size) & ~15u;
+    }
+    // No process has been scheduled yet, so we're still on the kernel page directory.
+    trampoline_field(apic_ap_start_cr3) = cpu_cr3();
+    trampoline_field(apic_ap_start_stacks) = reinterpret_cast<u32>(s_ap_stack_tops);
+
+    // INIT
+    apic_write_icr(ICRReg(0, ICRReg::INIT, ICRReg::Physical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::AllExcludingSelf));
 
-        for (foo = 0; foo < 0x800000; foo++); // TODO: 10 millisecond delay
+    // 10 millisecond delay
+    for (int i = 0; i < 3334; ++i)
+        IO::delay();
 
-        for (int i = 0; i < 2; i++) {
-            // SIPI
-            apic_write_icr(ICRReg(0x08, ICRReg::StartUp, ICRReg::Physical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::AllExcludingSelf)); // start execution at P8000
+    for (int i = 0; i < 2; i++) {
+        // SIPI
+        apic_write_icr(ICRReg(0x08, ICRReg::StartUp, ICRReg::Physical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::AllExcludingSelf)); // start execution at P8000
 
-            for (foo = 0; foo < 0x80000; foo++); // TODO: 200 microsecond delay
-        }
+        // 200 microsecond delay
+        for (int j = 0; j < 67; ++j)
+            IO::delay();
     }
+
+    // We don't know how many processors there are, so give them ~10 ms to check in.
+    for (int i = 0; i < 3334; ++i)
+        IO::delay();
+    kprintf("APIC: %u processor(s) online\n", Processor::count());
+}
+
+u8 current_apic_id()
+{
+    if (!g_apic_base)
+        return 0;
+    return apic_read(APIC_REG_ID) >> 24;
+}
+
+void eoi()
+{
+    apic_write(APIC_REG_EOI, 0);
+}
+
+void send_ipi(u8 vector, u8 logical_destinations)
+{
+    apic_write_icr(ICRReg(vector, ICRReg::Fixed, ICRReg::Logical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::NoShorthand, logical_destinations));
+}
+
+bool calibrate_timer()
+{
+    if (!g_apic_base)
+        return false;
+
+    InterruptDisabler disabler;
+    apic_write(APIC_REG_TIMER_DIVIDE_CONFIG, APIC_TIMER_DIVIDE_BY_16);
+    apic_write(APIC_REG_LVT_TIMER, APIC_LVT(timer_vector, 0) | APIC_LVT_MASKED);
+    apic_write(APIC_REG_TIMER_INITIAL_COUNT, 0xffffffff);
+    PIT::wait_using_channel2(10000);
+    u32 elapsed = 0xffffffff - apic_read(APIC_REG_TIMER_CURRENT_COUNT);
+    apic_write(APIC_REG_TIMER_INITIAL_COUNT, 0);
+
+    if (elapsed < 10)
+        return false;
+    s_timer_ticks_per_ms = elapsed / 10;
+    kprintf("APIC: Timer runs at %u kHz\n", s_timer_ticks_per_ms);
+
+    register_interrupt_handler(timer_vector, apic_timer_interrupt_entry);
+    apic_write(APIC_REG_LVT_TIMER, APIC_LVT(timer_vector, 0));
+    return true;
+}
+
+bool has_timer()
+{
+    return s_timer_ticks_per_ms;
+}
+
+void arm_timer(u64 nanoseconds_from_now)
+{
+    ASSERT(s_timer_ticks_per_ms);
+    // Longer waits just fire early and get rearmed by the TimerQueue.
+    static constexpr u64 max_nanoseconds = 1000000000;
+    if (nanoseconds_from_now > max_nanoseconds)
+        nanoseconds_from_now = max_nanoseconds;
+    u64 count = nanoseconds_from_now / 1000 * s_timer_ticks_per_ms / 1000;
+    if (count == 0)
+        count = 1;
+    if (count > 0xffffffff)
+        count = 0xffffffff;
+    apic_write(APIC_REG_TIMER_INITIAL_COUNT, count);
+}
+
+void disarm_timer()
+{
+    if (s_timer_ticks_per_ms)
+        apic_write(APIC_REG_TIMER_INITIAL_COUNT, 0);
+}
+
+void start_tick()
+{
+    ASSERT(s_timer_ticks_per_ms);
+    apic_write(APIC_REG_TIMER_DIVIDE_CONFIG, APIC_TIMER_DIVIDE_BY_16);
+    apic_write(APIC_REG_LVT_TIMER, APIC_LVT(timer_vector, 0) | APIC_LVT_TIMER_PERIODIC);
+    apic_write(APIC_REG_TIMER_INITIAL_COUNT, s_timer_ticks_per_ms * 1000 / TICKS_PER_SECOND);
+}
+
+void stop_tick()
+{
+    apic_write(APIC_REG_TIMER_INITIAL_COUNT, 0);
 }
 
 }
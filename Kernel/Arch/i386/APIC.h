@@ -4,7 +4,32 @@
 
 namespace APIC {
 
+static constexpr u8 ipi_tlb_shootdown_vector = 0xf1;
+static constexpr u8 ipi_reschedule_vector = 0xf2;
+static constexpr u8 timer_vector = 0xf3;
+
 bool init();
 void enable(u32 cpu);
+void boot_application_processors();
+
+u8 current_apic_id();
+void eoi();
+
+// Sends a fixed IPI to every processor whose bit is set in logical_destinations.
+void send_ipi(u8 vector, u8 logical_destinations);
+
+// Measures the local APIC timer against the PIT. Until this has succeeded,
+// has_timer() returns false and the PIT tick is the only clock event source.
+bool calibrate_timer();
+bool has_timer();
+
+// Programs a one-shot timer interrupt on this processor.
+void arm_timer(u64 nanoseconds_from_now);
+void disarm_timer();
+
+// Runs the timer periodically at TICKS_PER_SECOND instead, as an application
+// processor's scheduler tick.
+void start_tick();
+void stop_tick();
 
 }
@@ -6,6 +6,7 @@
 #include "SharedIRQHandler.h"
 #include <AK/Types.h>
 #include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Arch/i386/Processor.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <LibC/mallocdefs.h>
@@ -188,18 +189,21 @@ void handle_crash(RegisterDump& regs, const char* description, int signal)
 EH_ENTRY_NO_CODE(6);
 void exception_6_handler(RegisterDump regs)
 {
+    KernelLocker locker;
     handle_crash(regs, "Illegal instruction", SIGILL);
 }
 
 EH_ENTRY_NO_CODE(0);
 void exception_0_handler(RegisterDump regs)
 {
+    KernelLocker locker;
     handle_crash(regs, "Division by zero", SIGFPE);
 }
 
 EH_ENTRY(13);
 void exception_13_handler(RegisterDump regs)
 {
+    KernelLocker locker;
     handle_crash(regs, "General protection fault", SIGSEGV);
 }
 
@@ -208,17 +212,27 @@ EH_ENTRY_NO_CODE(7);
 void exception_7_handler(RegisterDump regs)
 {
     (void)regs;
+    KernelLocker locker;
 
     asm volatile("clts");
-    if (g_last_fpu_thread == current)
+    auto& fpu_owner = Processor::local().fpu_owner();
+    if (fpu_owner == current)
         return;
-    if (g_last_fpu_thread) {
-        asm volatile("fxsave %0"
-                     : "=m"(g_last_fpu_thread->fpu_state()));
-    } else {
+    if (!fpu_owner) {
         asm volatile("fnclex");
+    } else if (Processor::count() == 1) {
+        // With more processors, threads save their state as soon as they're
+        // switched out instead, see Scheduler::context_switch().
+        asm volatile("fxsave %0"
+                     : "=m"(fpu_owner->fpu_state()));
     }
-    g_last_fpu_thread = current;
+    // Another processor may still have an older copy of our state in its
+    // registers; make sure we never go back to that one.
+    Processor::for_each([](Processor& processor) {
+        if (processor.fpu_owner() == current)
+            processor.fpu_owner() = nullptr;
+    });
+    fpu_owner = current;
 
     if (current->has_used_fpu()) {
         asm volatile("fxrstor %0" ::"m"(current->fpu_state()));
@@ -240,6 +254,7 @@ EH_ENTRY(14);
 void exception_14_handler(RegisterDump regs)
 {
     ASSERT(current);
+    KernelLocker locker;
 
     u32 fault_address;
     asm("movl %%cr2, %%eax"
@@ -354,7 +369,8 @@ void write_gdt_entry(u16 selector, Descriptor& descriptor)
 Descriptor& get_gdt_entry(u16 selector)
 {
     u16 i = (selector & 0xfffc) >> 3;
-    return *(Descriptor*)(&s_gdt[i]);
+    auto* gdt = Processor::local().gdt();
+    return gdt ? gdt[i] : s_gdt[i];
 }
 
 void flush_gdt()
@@ -365,6 +381,18 @@ void flush_gdt()
         : "memory");
 }
 
+Descriptor* load_private_gdt()
+{
+    auto* gdt = (Descriptor*)kmalloc_eternal(sizeof(s_gdt));
+    memcpy(gdt, s_gdt, sizeof(s_gdt));
+    DescriptorTablePointer gdtr;
+    gdtr.address = gdt;
+    gdtr.limit = (s_gdt_length * 8) - 1;
+    asm("lgdt %0" ::"m"(gdtr)
+        : "memory");
+    return gdt;
+}
+
 void gdt_init()
 {
     s_gdt_length = 5;
@@ -532,6 +560,7 @@ void load_task_register(u16 selector)
 
 void handle_irq()
 {
+    KernelLocker locker;
     u16 isr = PIC::get_isr();
     if (!isr) {
         kprintf("Spurious IRQ\n");
@@ -207,6 +207,9 @@ void register_device_irq_handler(u8 number, DeviceIRQHandler&);
 void unregister_device_irq_handler(u8 number, DeviceIRQHandler&);
 void flush_idt();
 void flush_gdt();
+// Loads a copy of the GDT for the calling processor alone, so that entries it
+// rewrites while switching threads don't change under the others.
+Descriptor* load_private_gdt();
 void prepare_for_poweroff();
 void load_task_register(u16 selector);
 u16 gdt_alloc_entry();
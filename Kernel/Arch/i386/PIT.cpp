@@ -2,9 +2,10 @@
 #include <Kernel/Arch/i386/PIC.h>
 #include <Kernel/Arch/i386/PIT.h>
 #include <Kernel/IO.h>
+#include <Kernel/RTC.h>
 #include <Kernel/Scheduler.h>
-
-#define IRQ_TIMER 0
+#include <Kernel/TimePage.h>
+#include <Kernel/VM/MemoryManager.h>
 
 extern "C" void timer_interrupt_entry();
 extern "C" void timer_interrupt_handler(RegisterDump);
@@ -38,30 +39,122 @@ asm(
     "    add $0x4, %esp\n"
     "    iret\n");
 
-static u32 s_ticks_this_second;
-static u32 s_seconds_since_boot;
+#define PIT_CHANNEL2_PORT 0x61
+#define PIT_CHANNEL2_GATE 0x01
+#define PIT_CHANNEL2_SPEAKER 0x02
+#define PIT_CHANNEL2_OUT 0x20
+
+static u64 s_boot_tsc;
+static u64 s_tsc_ticks_per_ms;
+static Region* s_time_page_region;
 
 void timer_interrupt_handler(RegisterDump regs)
 {
-    IRQHandlerScope scope(IRQ_TIMER);
-    if (++s_ticks_this_second >= TICKS_PER_SECOND) {
-        // FIXME: Synchronize with the RTC somehow to prevent drifting apart.
-        ++s_seconds_since_boot;
-        s_ticks_this_second = 0;
-    }
+    // Acknowledge the tick up front, since Scheduler::timer_tick() may switch
+    // to another thread and never come back here.
+    PIC::eoi(IRQ_TIMER);
+    KernelLocker locker;
     Scheduler::timer_tick(regs);
 }
 
+static u64 read_tsc()
+{
+    u32 lsw;
+    u32 msw;
+    ::read_tsc(lsw, msw);
+    return ((u64)msw << 32) | lsw;
+}
+
 namespace PIT {
 
 u32 ticks_this_second()
 {
-    return s_ticks_this_second;
+    return g_uptime % TICKS_PER_SECOND;
 }
 
 u32 seconds_since_boot()
 {
-    return s_seconds_since_boot;
+    // FIXME: Synchronize with the RTC somehow to prevent drifting apart.
+    return g_uptime / TICKS_PER_SECOND;
+}
+
+bool has_high_resolution_clock()
+{
+    return s_tsc_ticks_per_ms;
+}
+
+u64 nanoseconds_since_boot()
+{
+    if (!s_tsc_ticks_per_ms)
+        return g_uptime * 1000000;
+    u64 elapsed = read_tsc() - s_boot_tsc;
+    // Split the conversion so the multiplication can't overflow.
+    return (elapsed / s_tsc_ticks_per_ms) * 1000000 + (elapsed % s_tsc_ticks_per_ms) * 1000000 / s_tsc_ticks_per_ms;
+}
+
+VirtualAddress time_page_address()
+{
+    return s_time_page_region->vaddr();
+}
+
+void update_time_page()
+{
+    if (!s_time_page_region)
+        return;
+    // Userspace can't write to the page, but we can, since CR0.WP is clear.
+    auto& page = *(TimePage*)s_time_page_region->vaddr().as_ptr();
+    ++page.sequence;
+    asm volatile("" ::: "memory");
+    page.boot_time = RTC::boot_time();
+    page.uptime_ms = g_uptime;
+    page.boot_tsc = s_boot_tsc;
+    page.tsc_ticks_per_ms = s_tsc_ticks_per_ms;
+    asm volatile("" ::: "memory");
+    ++page.sequence;
+}
+
+static void create_time_page()
+{
+    // NOTE: We leak this region.
+    s_time_page_region = MM.allocate_user_accessible_kernel_region(PAGE_SIZE, "Time page").leak_ptr();
+    update_time_page();
+    s_time_page_region->set_writable(false);
+    s_time_page_region->remap();
+}
+
+void wait_using_channel2(u32 microseconds)
+{
+    u32 count = (u64)BASE_FREQUENCY * microseconds / 1000000;
+    ASSERT(count > 0 && count <= 0xffff);
+
+    // Gate channel 2 on with the speaker disconnected, and count down once.
+    // OUT2 goes high when the count reaches zero.
+    u8 old_control = IO::in8(PIT_CHANNEL2_PORT);
+    IO::out8(PIT_CHANNEL2_PORT, (old_control & ~PIT_CHANNEL2_SPEAKER) | PIT_CHANNEL2_GATE);
+    IO::out8(PIT_CTL, TIMER2_SELECT | WRITE_WORD | MODE_COUNTDOWN);
+    IO::out8(TIMER2_CTL, LSB(count));
+    IO::out8(TIMER2_CTL, MSB(count));
+    while (!(IO::in8(PIT_CHANNEL2_PORT) & PIT_CHANNEL2_OUT))
+        asm volatile("pause");
+    IO::out8(PIT_CHANNEL2_PORT, old_control);
+}
+
+static void calibrate_tsc()
+{
+    CPUID id(1);
+    if (!(id.edx() & (1 << 4)))
+        return;
+
+    InterruptDisabler disabler;
+    u64 start = read_tsc();
+    wait_using_channel2(10000);
+    u64 ticks_per_ms = (read_tsc() - start) / 10;
+    if (!ticks_per_ms)
+        return;
+
+    s_boot_tsc = read_tsc() - g_uptime * ticks_per_ms;
+    s_tsc_ticks_per_ms = ticks_per_ms;
+    kprintf("PIT: TSC runs at %u kHz\n", (u32)ticks_per_ms);
 }
 
 void initialize()
@@ -80,6 +173,9 @@ void initialize()
     register_interrupt_handler(IRQ_VECTOR_BASE + IRQ_TIMER, timer_interrupt_entry);
 
     PIC::enable(IRQ_TIMER);
+
+    calibrate_tsc();
+    create_time_page();
 }
 
 }
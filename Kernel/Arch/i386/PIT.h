@@ -1,7 +1,9 @@
 #pragma once
 
 #include <AK/Types.h>
+#include <Kernel/VM/VirtualAddress.h>
 
+#define IRQ_TIMER 0
 #define TICKS_PER_SECOND 1000
 /* Timer related ports */
 #define TIMER0_CTL 0x40
@@ -29,4 +31,18 @@ void initialize();
 u32 ticks_this_second();
 u32 seconds_since_boot();
 
+// Monotonic time since boot. This has TSC resolution once the TSC has been
+// calibrated against the PIT, and tick resolution otherwise.
+u64 nanoseconds_since_boot();
+bool has_high_resolution_clock();
+
+// The shared TimePage that LibC reads the time from. It is refreshed on
+// every timer tick.
+VirtualAddress time_page_address();
+void update_time_page();
+
+// Busy-waits on PIT channel 2, for calibrating other clocks against it.
+// Only usable for intervals of up to ~54 ms.
+void wait_using_channel2(u32 microseconds);
+
 }
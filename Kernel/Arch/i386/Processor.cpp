@@ -0,0 +1,216 @@
+#include <AK/Assertions.h>
+#include <Kernel/Arch/i386/APIC.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Arch/i386/Processor.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/StdLib.h>
+
+//#define PROCESSOR_DEBUG
+
+Processor Processor::s_processors[Processor::max_count];
+Processor* Processor::s_processors_by_tss_selector[256];
+Atomic<u32> Processor::s_online_count { 1 };
+Atomic<u8> Processor::s_online_mask { 1 };
+
+static SpinLock s_tlb_shootdown_lock;
+static Atomic<u8> s_tlb_shootdown_targets;
+static VirtualAddress s_tlb_shootdown_vaddr;
+static bool s_tlb_shootdown_entire;
+
+extern "C" void handle_tlb_shootdown_ipi();
+extern "C" void tlb_shootdown_ipi_entry();
+extern "C" void handle_reschedule_ipi(RegisterDump);
+extern "C" void reschedule_ipi_entry();
+
+asm(
+    ".globl tlb_shootdown_ipi_entry\n"
+    "tlb_shootdown_ipi_entry: \n"
+    "    pusha\n"
+    "    pushw %ds\n"
+    "    pushw %es\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    popw %ds\n"
+    "    popw %es\n"
+    "    cld\n"
+    "    call handle_tlb_shootdown_ipi\n"
+    "    popw %es\n"
+    "    popw %ds\n"
+    "    popa\n"
+    "    iret\n");
+
+// The reschedule IPI may switch threads, so it saves a full RegisterDump like
+// the timer interrupts do.
+asm(
+    ".globl reschedule_ipi_entry\n"
+    "reschedule_ipi_entry: \n"
+    "    pushl $0x0\n"
+    "    pusha\n"
+    "    pushw %ds\n"
+    "    pushw %es\n"
+    "    pushw %fs\n"
+    "    pushw %gs\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    pushw %ss\n"
+    "    popw %ds\n"
+    "    popw %es\n"
+    "    popw %fs\n"
+    "    popw %gs\n"
+    "    cld\n"
+    "    call handle_reschedule_ipi\n"
+    "    popw %gs\n"
+    "    popw %gs\n"
+    "    popw %fs\n"
+    "    popw %es\n"
+    "    popw %ds\n"
+    "    popa\n"
+    "    add $0x4, %esp\n"
+    "    iret\n");
+
+// Both the IPI and processors spinning on a lock with interrupts off end up
+// here, so whichever gets to a request first clears our bit and the other
+// finds nothing to do.
+static void flush_tlb_if_requested()
+{
+    u8 self_mask = 1 << Processor::local().index();
+    if (!(s_tlb_shootdown_targets.load(AK::memory_order_acquire) & self_mask))
+        return;
+    if (s_tlb_shootdown_entire) {
+        asm volatile(
+            "mov %%cr3, %%eax\n"
+            "mov %%eax, %%cr3\n" ::
+                : "%eax", "memory");
+    } else {
+        asm volatile("invlpg %0"
+                     :
+                     : "m"(*(char*)s_tlb_shootdown_vaddr.get())
+                     : "memory");
+    }
+    s_tlb_shootdown_targets.fetch_and(~self_mask, AK::memory_order_release);
+}
+
+void handle_tlb_shootdown_ipi()
+{
+    flush_tlb_if_requested();
+    APIC::eoi();
+}
+
+void handle_reschedule_ipi(RegisterDump regs)
+{
+    // Like the timer interrupts, acknowledge first since we may not return here.
+    APIC::eoi();
+    KernelLocker locker;
+    Scheduler::reschedule(regs);
+}
+
+void Processor::wait_for_lock()
+{
+    flush_tlb_if_requested();
+    asm volatile("pause");
+}
+
+void Processor::initialize_bsp()
+{
+    // The GDT allocator isn't safe to use from several processors at once,
+    // so hand out every processor's TSS descriptor up front.
+    for (u32 i = 0; i < max_count; ++i) {
+        auto& processor = s_processors[i];
+        processor.m_index = i;
+        memset(&processor.m_tss, 0, sizeof(TSS32));
+        processor.m_tss.ss0 = 0x10;
+        processor.m_tss.iomapbase = sizeof(TSS32);
+
+        processor.m_tss_selector = gdt_alloc_entry();
+        auto& descriptor = get_gdt_entry(processor.m_tss_selector);
+        descriptor.set_base(&processor.m_tss);
+        descriptor.set_limit(sizeof(TSS32) - 1);
+        descriptor.dpl = 0;
+        descriptor.segment_present = 1;
+        descriptor.granularity = 0;
+        descriptor.zero = 0;
+        descriptor.operation_size = 1;
+        descriptor.descriptor_type = 0;
+        descriptor.type = 9;
+        s_processors_by_tss_selector[processor.m_tss_selector >> 3] = &processor;
+    }
+    flush_gdt();
+
+    auto& bsp = s_processors[0];
+    bsp.m_apic_id = APIC::current_apic_id();
+    load_task_register(bsp.m_tss_selector);
+
+    register_interrupt_handler(APIC::ipi_tlb_shootdown_vector, tlb_shootdown_ipi_entry);
+    register_interrupt_handler(APIC::ipi_reschedule_vector, reschedule_ipi_entry);
+}
+
+Processor& Processor::initialize_ap(u32 index)
+{
+    ASSERT(index > 0 && index < max_count);
+    auto& processor = s_processors[index];
+    processor.m_apic_id = APIC::current_apic_id();
+    load_task_register(processor.m_tss_selector);
+    return processor;
+}
+
+void Processor::use_private_gdt()
+{
+    ASSERT(&Processor::local() == this);
+    ASSERT(!is_bsp());
+    m_gdt = load_private_gdt();
+}
+
+void Processor::set_online()
+{
+    // Publish ourselves in the mask before bumping the count; the count going
+    // above one is what switches local() over to the APIC ID lookup.
+    s_online_mask.fetch_or(1 << m_index, AK::memory_order_release);
+    s_online_count.fetch_add(1, AK::memory_order_release);
+#ifdef PROCESSOR_DEBUG
+    dbgprintf("Processor: CPU #%u (APIC ID %u) online\n", m_index, m_apic_id);
+#endif
+}
+
+static void flush_tlb_on_other_processors_impl(VirtualAddress vaddr, bool entire)
+{
+    u8 self_mask = 1 << Processor::local().index();
+    ScopedSpinLock lock(s_tlb_shootdown_lock);
+    u8 targets = Processor::online_mask() & ~self_mask;
+    if (!targets)
+        return;
+
+    s_tlb_shootdown_vaddr = vaddr;
+    s_tlb_shootdown_entire = entire;
+    s_tlb_shootdown_targets.store(targets, AK::memory_order_release);
+    APIC::send_ipi(APIC::ipi_tlb_shootdown_vector, targets);
+    while (s_tlb_shootdown_targets.load(AK::memory_order_acquire))
+        asm volatile("pause");
+}
+
+void Processor::flush_tlb_on_other_processors(VirtualAddress vaddr)
+{
+    flush_tlb_on_other_processors_impl(vaddr, false);
+}
+
+void Processor::flush_entire_tlb_on_other_processors()
+{
+    flush_tlb_on_other_processors_impl({}, true);
+}
+
+void Processor::send_reschedule_ipi()
+{
+    if (&Processor::local() == this)
+        return;
+    APIC::send_ipi(APIC::ipi_reschedule_vector, 1 << m_index);
+}
+
+void Processor::idle_loop()
+{
+    ASSERT(&Processor::local() == this);
+    sti();
+    for (;;)
+        asm volatile("hlt");
+}
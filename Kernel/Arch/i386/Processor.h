@@ -0,0 +1,92 @@
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Types.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/VM/VirtualAddress.h>
+
+class Thread;
+
+// Per-CPU state. The bootstrap processor is always index 0; application
+// processors get the next free index as they come online.
+// Each processor runs with its own TSS loaded, so the task register tells
+// us which processor we're on without touching the APIC.
+class Processor {
+public:
+    // Flat logical APIC destinations give us one bit per processor.
+    static constexpr u32 max_count = 8;
+
+    static void initialize_bsp();
+    static Processor& initialize_ap(u32 index);
+
+    [[gnu::always_inline]] static inline Processor& local()
+    {
+        if (s_online_count.load(AK::memory_order_relaxed) <= 1)
+            return s_processors[0];
+        u16 selector;
+        asm volatile("str %0"
+                     : "=r"(selector));
+        auto* processor = s_processors_by_tss_selector[selector >> 3];
+        return processor ? *processor : s_processors[0];
+    }
+
+    static Processor& for_index(u32 index) { return s_processors[index]; }
+    static u32 count() { return s_online_count.load(AK::memory_order_acquire); }
+    static u8 online_mask() { return s_online_mask.load(AK::memory_order_acquire); }
+
+    template<typename Callback>
+    static void for_each(Callback callback)
+    {
+        u8 mask = online_mask();
+        for (u32 i = 0; i < max_count; ++i) {
+            if (mask & (1 << i))
+                callback(s_processors[i]);
+        }
+    }
+
+    u32 index() const { return m_index; }
+    u8 apic_id() const { return m_apic_id; }
+    bool is_bsp() const { return m_index == 0; }
+
+    Thread*& current_thread() { return m_current_thread; }
+    TSS32& tss() { return m_tss; }
+
+    // The thread whose FPU state is in this processor's registers, if any.
+    Thread*& fpu_owner() { return m_fpu_owner; }
+
+    // This processor's copy of the GDT, or null while it still runs on the
+    // one it booted with.
+    Descriptor* gdt() { return m_gdt; }
+    void use_private_gdt();
+
+    // Make every other online processor drop its TLB entry for the given
+    // address (or its whole TLB), and wait until they have done so.
+    static void flush_tlb_on_other_processors(VirtualAddress);
+    static void flush_entire_tlb_on_other_processors();
+
+    // What to do in every spin lock's busy loop. Whoever holds the lock may be
+    // waiting for us to flush our TLB, and we're spinning with interrupts off.
+    static void wait_for_lock();
+
+    // Kick another processor so it looks at its run queue, or at the
+    // TimerQueue if it's the bootstrap processor.
+    void send_reschedule_ipi();
+
+    void set_online();
+    [[noreturn]] void idle_loop();
+
+private:
+
+    u32 m_index { 0 };
+    u8 m_apic_id { 0 };
+    u16 m_tss_selector { 0 };
+    Thread* m_current_thread { nullptr };
+    Thread* m_fpu_owner { nullptr };
+    Descriptor* m_gdt { nullptr };
+    TSS32 m_tss;
+
+    static Processor s_processors[max_count];
+    static Processor* s_processors_by_tss_selector[256];
+    static Atomic<u32> s_online_count;
+    static Atomic<u8> s_online_mask;
+};
@@ -1,4 +1,7 @@
+#include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Devices/DiskDevice.h>
+#include <Kernel/Thread.h>
+#include <Kernel/kstdio.h>
 
 DiskDevice::DiskDevice(int major, int minor, size_t block_size)
     : BlockDevice(major, minor, block_size)
@@ -28,3 +31,73 @@ bool DiskDevice::write(DiskOffset offset, unsigned length, const u8* in)
     ASSERT(end_block <= 0xffffffff);
     return write_blocks(first_block, end_block - first_block, in);
 }
+
+// Set whenever a device may have something to dispatch.
+static volatile bool s_io_task_should_run;
+
+void DiskDevice::submit(NonnullRefPtr<DiskRequest> request)
+{
+    ASSERT(request->block_count() > 0);
+    m_request_queue.enqueue(move(request));
+    s_io_task_should_run = true;
+}
+
+bool DiskDevice::dispatch_next_request()
+{
+    {
+        InterruptDisabler disabler;
+        if (m_active_entry || m_request_queue.is_empty())
+            return false;
+        m_active_entry = m_request_queue.take_next();
+    }
+
+    auto& entry = *m_active_entry;
+    if (!m_bounce_buffer)
+        m_bounce_buffer = make<KBuffer>(KBuffer::create_with_size(SeekQueue::max_merged_blocks * block_size()));
+    u8* buffer = entry.prepare_transfer(m_bounce_buffer->data(), block_size());
+
+    if (start_request(entry.type(), entry.block_index(), entry.block_count(), buffer))
+        return true;
+
+    bool success;
+    if (entry.type() == DiskRequest::Type::Read)
+        success = read_blocks(entry.block_index(), entry.block_count(), buffer);
+    else
+        success = write_blocks(entry.block_index(), entry.block_count(), buffer);
+    complete_active_request(success);
+    return true;
+}
+
+void DiskDevice::complete_active_request(bool success)
+{
+    InterruptDisabler disabler;
+    ASSERT(m_active_entry);
+    if (!success)
+        kprintf("%s: %s of %u blocks at %u failed\n", class_name(), m_active_entry->type() == DiskRequest::Type::Read ? "Read" : "Write", m_active_entry->block_count(), m_active_entry->block_index());
+    m_active_entry->complete(success, block_size());
+    m_active_entry = nullptr;
+    s_io_task_should_run = true;
+}
+
+void DiskDevice::io_task_main()
+{
+    for (;;) {
+        s_io_task_should_run = false;
+        // Transfers may yield, so don't hold on to the device table meanwhile.
+        Vector<DiskDevice*> disks;
+        {
+            InterruptDisabler disabler;
+            Device::for_each([&disks](Device& device) {
+                if (device.is_disk_device())
+                    disks.append(static_cast<DiskDevice*>(&device));
+            });
+        }
+        for (auto* disk : disks) {
+            while (disk->dispatch_next_request())
+                ;
+        }
+        (void)current->block_until("DiskIO", [] {
+            return s_io_task_should_run;
+        });
+    }
+}
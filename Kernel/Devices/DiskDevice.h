@@ -3,6 +3,8 @@
 #include <AK/RefCounted.h>
 #include <AK/Types.h>
 #include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/SeekQueue.h>
 
 // FIXME: Support 64-bit DiskOffset
 typedef u32 DiskOffset;
@@ -19,8 +21,28 @@ public:
     virtual bool read_blocks(unsigned index, u16 count, u8*) = 0;
     virtual bool write_blocks(unsigned index, u16 count, const u8*) = 0;
 
+    // Queues a request and returns right away. Requests are carried out by
+    // the DiskIO task; use DiskRequest::wait() to block until one is done.
+    void submit(NonnullRefPtr<DiskRequest>);
+
+    [[noreturn]] static void io_task_main();
+
     virtual bool is_disk_device() const override { return true; };
 
 protected:
     DiskDevice(int major, int minor, size_t block_size = 512);
+
+    // Drivers that can finish a transfer from their IRQ handler override this
+    // to program the controller and return true, and then call
+    // complete_active_request() from the handler. Returning false makes the
+    // DiskIO task do the transfer with read_blocks()/write_blocks() instead.
+    virtual bool start_request(DiskRequest::Type, u32, u16, u8*) { return false; }
+    void complete_active_request(bool success);
+
+private:
+    bool dispatch_next_request();
+
+    SeekQueue m_request_queue;
+    OwnPtr<SeekQueueEntry> m_active_entry;
+    OwnPtr<KBuffer> m_bounce_buffer;
 };
@@ -15,6 +15,11 @@ const u16 DSP_WRITE = 0x22C;
 const u16 DSP_STATUS = 0x22E;
 const u16 DSP_R_ACK = 0x22F;
 
+// 32 KB is ~186 ms of 44.1 kHz 16-bit stereo. The card interrupts after every
+// 4 KB period (~23 ms), and that's how much room each interrupt makes.
+static const u32 dma_ring_size = 32 * KB;
+static const u32 dma_period_size = 4 * KB;
+
 /* Write a value to the DSP write register */
 void SB16::dsp_write(u8 value)
 {
@@ -94,11 +99,16 @@ ssize_t SB16::read(FileDescription&, u8*, ssize_t)
     return 0;
 }
 
+bool SB16::can_write(const FileDescription&) const
+{
+    return m_queued_bytes < dma_ring_size;
+}
+
 void SB16::dma_start(uint32_t length)
 {
-    const auto addr = m_dma_buffer_page->paddr().get();
+    const auto addr = m_dma_ring_pages.first().paddr().get();
     const u8 channel = 5; // 16-bit samples use DMA channel 5 (on the master DMA controller)
-    const u8 mode = 0;
+    const u8 mode = 0x58; // Single transfers from memory, restarting at the end of the buffer
 
     // Disable the DMA channel
     IO::out8(0xd4, 4 + (channel % 4));
@@ -114,9 +124,10 @@ void SB16::dma_start(uint32_t length)
     IO::out8(0xc4, (u8)offset);
     IO::out8(0xc4, (u8)(offset >> 8));
 
-    // Write the transfer length
-    IO::out8(0xc6, (u8)(length - 1));
-    IO::out8(0xc6, (u8)((length - 1) >> 8));
+    // Write the transfer length, in 16-bit words
+    u16 word_count = length / 2 - 1;
+    IO::out8(0xc6, (u8)word_count);
+    IO::out8(0xc6, (u8)(word_count >> 8));
 
     // Write the buffer
     IO::out8(0x8b, addr >> 16);
@@ -125,66 +136,98 @@ void SB16::dma_start(uint32_t length)
     IO::out8(0xd4, (channel % 4));
 }
 
-void SB16::handle_irq()
+void SB16::start_playback()
 {
-    // Stop sound output ready for the next block.
+    ASSERT(!m_playing);
+
+    const int sample_rate = 44100;
+    set_sample_rate(sample_rate);
+    dma_start(dma_ring_size);
+
+    // 16-bit auto-initialized output, with the FIFO on. The block size is one
+    // period, so we get an interrupt every time a period has been played.
+    u8 command = 0xb6;
+    u8 mode = (u8)SampleFormat::Signed | (u8)SampleFormat::Stereo;
+
+    // The block size counts 16-bit samples of either channel.
+    u16 sample_count = dma_period_size / sizeof(i16) - 1;
+
+    dsp_write(command);
+    dsp_write(mode);
+    dsp_write((u8)sample_count);
+    dsp_write((u8)(sample_count >> 8));
+
+    m_playing = true;
+}
+
+void SB16::stop_playback()
+{
+    // Pause 16-bit output and mask the DMA channel. start_playback() sets
+    // both up from scratch.
     dsp_write(0xd5);
+    IO::out8(0xd4, 4 + (5 % 4));
+    m_playing = false;
+}
 
+void SB16::handle_irq()
+{
     IO::in8(DSP_STATUS); // 8 bit interrupt
     if (m_major_version >= 4)
         IO::in8(DSP_R_ACK); // 16 bit interrupt
 
-    m_interrupted = true;
-}
+    if (!m_playing)
+        return;
 
-void SB16::wait_for_irq()
-{
-    // Well, we have no way of knowing how much got written. So just hope all of
-    // it did, even if we're interrupted.
-    (void)current->block_until("Interrupting", [this] {
-        return m_interrupted;
-    });
+    // The period at m_play_offset has been played. Silence it, so that if we
+    // run dry before it comes around again, the card plays silence rather
+    // than stale samples.
+    memset(ring() + m_play_offset, 0, dma_period_size);
+    m_play_offset = (m_play_offset + dma_period_size) % dma_ring_size;
+    if (m_queued_bytes > dma_period_size) {
+        m_queued_bytes -= dma_period_size;
+        return;
+    }
+
+    // Everything that was written has been played, and the whole ring is
+    // silent again. Stop until the next write.
+    stop_playback();
+    m_queued_bytes = 0;
+    m_play_offset = 0;
+    m_write_offset = 0;
 }
 
 ssize_t SB16::write(FileDescription&, const u8* data, ssize_t length)
 {
-    if (!m_dma_buffer_page)
-        m_dma_buffer_page = MM.allocate_supervisor_physical_page();
+    if (m_dma_ring_pages.is_empty()) {
+        m_dma_ring_pages = MM.allocate_contiguous_supervisor_physical_pages(dma_ring_size / PAGE_SIZE);
+        if (m_dma_ring_pages.is_empty())
+            return -ENOMEM;
+    }
 
 #ifdef SB16_DEBUG
     kprintf("SB16: Writing buffer of %d bytes\n", length);
 #endif
-    ASSERT(length <= PAGE_SIZE);
-    const int BLOCK_SIZE = 32 * 1024;
-    if (length > BLOCK_SIZE) {
-        return -ENOSPC;
-    }
-
-    u8 mode = (u8)SampleFormat::Signed | (u8)SampleFormat::Stereo;
 
-    disable_irq();
-    const int sample_rate = 44100;
-    set_sample_rate(sample_rate);
-    memcpy(m_dma_buffer_page->paddr().as_ptr(), data, length);
-    dma_start(length);
-
-    // 16-bit single-cycle output.
-    // FIXME: Implement auto-initialized output.
-    u8 command = 0xb0;
-
-    u16 sample_count = length / sizeof(i16);
-    if (mode & (u8)SampleFormat::Stereo)
-        sample_count /= 2;
-
-    sample_count -= 1;
-
-    dsp_write(command);
-    dsp_write(mode);
-    dsp_write((u8)sample_count);
-    dsp_write((u8)(sample_count >> 8));
-
-    m_interrupted = false;
-    enable_irq();
-    wait_for_irq();
-    return length;
+    ssize_t nwritten = 0;
+    while (nwritten < length) {
+        auto result = current->block_until("SB16", [this] {
+            return m_queued_bytes < dma_ring_size;
+        });
+        if (result != Thread::BlockResult::WokeNormally)
+            return nwritten ? nwritten : -EINTR;
+
+        InterruptDisabler disabler;
+        size_t chunk_size = min((size_t)(length - nwritten), (size_t)(dma_ring_size - m_queued_bytes));
+        chunk_size = min(chunk_size, (size_t)(dma_ring_size - m_write_offset));
+        memcpy(ring() + m_write_offset, data + nwritten, chunk_size);
+        m_write_offset = (m_write_offset + chunk_size) % dma_ring_size;
+        m_queued_bytes += chunk_size;
+        nwritten += chunk_size;
+
+        // Whatever comes after what we've written is silence, so there's no
+        // need to wait for a full period before starting.
+        if (!m_playing)
+            start_playback();
+    }
+    return nwritten;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <AK/CircularQueue.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <Kernel/DeviceIRQHandler.h>
 #include <Kernel/Devices/CharacterDevice.h>
 #include <Kernel/VM/PhysicalAddress.h>
@@ -20,7 +21,7 @@ public:
     virtual bool can_read(const FileDescription&) const override;
     virtual ssize_t read(FileDescription&, u8*, ssize_t) override;
     virtual ssize_t write(FileDescription&, const u8*, ssize_t) override;
-    virtual bool can_write(const FileDescription&) const override { return true; }
+    virtual bool can_write(const FileDescription&) const override;
 
 private:
     // ^IRQHandler
@@ -30,13 +31,22 @@ private:
     virtual const char* class_name() const override { return "SB16"; }
 
     void initialize();
-    void wait_for_irq();
     void dma_start(uint32_t length);
+    void start_playback();
+    void stop_playback();
     void set_sample_rate(uint16_t hz);
     void dsp_write(u8 value);
     u8 dsp_read();
 
-    RefPtr<PhysicalPage> m_dma_buffer_page;
-    bool m_interrupted { false };
+    u8* ring() { return m_dma_ring_pages.first().paddr().as_ptr(); }
+
+    // Samples are played from a ring of DMA memory with auto-initialized
+    // DMA, and the card interrupts after every period. write() only has to
+    // copy into the ring, and blocks while it is full.
+    NonnullRefPtrVector<PhysicalPage> m_dma_ring_pages;
+    u32 m_play_offset { 0 };
+    u32 m_write_offset { 0 };
+    u32 m_queued_bytes { 0 };
+    bool m_playing { false };
     int m_major_version { 0 };
 };
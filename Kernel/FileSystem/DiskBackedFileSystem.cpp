@@ -3,15 +3,23 @@
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/Process.h>
+#include <Kernel/SeekQueue.h>
 
 //#define DBFS_DEBUG
 
+// How many blocks to fetch ahead of a sequential reader, and how many such
+// windows to keep around at most.
+static const unsigned readahead_block_count = 16;
+static const int max_readahead_windows = 4;
+
 struct CacheEntry {
     u32 timestamp { 0 };
     u32 block_index { 0 };
     u8* data { nullptr };
     bool has_data { false };
     bool is_dirty { false };
+    // Set while the disk may still be reading from data. Owned by DiskBackedFS::m_pending_writes.
+    DiskRequest* pending_write { nullptr };
 };
 
 class DiskCache {
@@ -42,7 +50,7 @@ public:
                 entry.timestamp = now;
                 return entry;
             }
-            if (!entry.is_dirty) {
+            if (!entry.is_dirty && !(entry.pending_write && !entry.pending_write->is_complete())) {
                 if (!oldest_clean_entry)
                     oldest_clean_entry = &entry;
                 else if (entry.timestamp < oldest_clean_entry->timestamp)
@@ -50,22 +58,47 @@ public:
             }
         }
         if (!oldest_clean_entry) {
-            // Not a single clean entry! Flush writes and try again.
-            // NOTE: We want to make sure we only call DiskBackedFS flush here,
+            // Not a single clean entry! Wait for one to be written back and try again.
+            // NOTE: We want to make sure we only start DiskBackedFS writeback here,
             //       not some DiskBackedFS subclass flush!
-            m_fs.flush_writes_impl();
+            wait_for_any_writeback();
             return get(block_index);
         }
 
         // Replace the oldest clean entry.
         auto& new_entry = *oldest_clean_entry;
+        // A readahead window may have been fetched while this block was dirty,
+        // so it can't be trusted once the cached copy is gone.
+        if (new_entry.has_data)
+            m_fs.discard_readahead(new_entry.block_index);
         new_entry.timestamp = now;
         new_entry.block_index = block_index;
         new_entry.has_data = false;
         new_entry.is_dirty = false;
+        new_entry.pending_write = nullptr;
         return new_entry;
     }
 
+    void wait_for_any_writeback() const
+    {
+        if (m_dirty)
+            m_fs.start_writeback();
+
+        RefPtr<DiskRequest> oldest_write;
+        u32 oldest_timestamp = 0;
+        for (size_t i = 0; i < m_entry_count; ++i) {
+            auto& entry = entries()[i];
+            if (!entry.pending_write || entry.pending_write->is_complete())
+                continue;
+            if (!oldest_write || entry.timestamp < oldest_timestamp) {
+                oldest_write = entry.pending_write;
+                oldest_timestamp = entry.timestamp;
+            }
+        }
+        if (oldest_write)
+            oldest_write->wait();
+    }
+
     const CacheEntry* entries() const { return (const CacheEntry*)m_entries.data(); }
     CacheEntry* entries() { return (CacheEntry*)m_entries.data(); }
 
@@ -91,6 +124,21 @@ DiskBackedFS::DiskBackedFS(NonnullRefPtr<DiskDevice>&& device)
 
 DiskBackedFS::~DiskBackedFS()
 {
+    // The disk may still be reading from our cache.
+    wait_for_writeback();
+}
+
+NonnullRefPtr<DiskRequest> DiskBackedFS::submit(DiskRequest::Type type, unsigned index, unsigned count, u8* buffer, DiskRequest::Priority priority) const
+{
+    unsigned device_blocks_per_block = block_size() / device().block_size();
+    auto request = DiskRequest::create(type, index * device_blocks_per_block, count * device_blocks_per_block, buffer, priority);
+    const_cast<DiskDevice&>(device()).submit(request);
+    return request;
+}
+
+bool DiskBackedFS::transfer(DiskRequest::Type type, unsigned index, unsigned count, u8* buffer) const
+{
+    return submit(type, index, count, buffer, DiskRequest::Priority::Foreground)->wait();
 }
 
 bool DiskBackedFS::write_block(unsigned index, const u8* data, FileDescription* description)
@@ -101,14 +149,17 @@ bool DiskBackedFS::write_block(unsigned index, const u8* data, FileDescription*
 
     bool allow_cache = !description || !description->is_direct();
 
+    discard_readahead(index);
+
     if (!allow_cache) {
         flush_specific_block_if_needed(index);
-        DiskOffset base_offset = static_cast<DiskOffset>(index) * static_cast<DiskOffset>(block_size());
-        device().write(base_offset, block_size(), data);
+        transfer(DiskRequest::Type::Write, index, 1, const_cast<u8*>(data));
         return true;
     }
 
     auto& entry = cache().get(index);
+    if (entry.pending_write)
+        entry.pending_write->wait();
     memcpy(entry.data, data, block_size());
     entry.is_dirty = true;
     entry.has_data = true;
@@ -137,23 +188,110 @@ bool DiskBackedFS::read_block(unsigned index, u8* buffer, FileDescription* descr
 
     if (!allow_cache) {
         const_cast<DiskBackedFS*>(this)->flush_specific_block_if_needed(index);
-        DiskOffset base_offset = static_cast<DiskOffset>(index) * static_cast<DiskOffset>(block_size());
-        bool success = device().read(base_offset, block_size(), buffer);
+        bool success = transfer(DiskRequest::Type::Read, index, 1, buffer);
         ASSERT(success);
         return true;
     }
 
+    bool is_sequential;
+    {
+        LOCKER(m_lock);
+        is_sequential = index == m_last_read_index + 1;
+        m_last_read_index = index;
+    }
+
     auto& entry = cache().get(index);
     if (!entry.has_data) {
-        DiskOffset base_offset = static_cast<DiskOffset>(index) * static_cast<DiskOffset>(block_size());
-        bool success = device().read(base_offset, block_size(), entry.data);
+        if (!read_from_readahead(index, entry.data)) {
+            bool success = transfer(DiskRequest::Type::Read, index, 1, entry.data);
+            ASSERT(success);
+        }
         entry.has_data = true;
-        ASSERT(success);
+        if (is_sequential)
+            start_readahead(index + 1);
     }
     memcpy(buffer, entry.data, block_size());
     return true;
 }
 
+bool DiskBackedFS::read_from_readahead(unsigned index, u8* buffer) const
+{
+    RefPtr<DiskRequest> request;
+    unsigned offset = 0;
+    bool is_last_block = false;
+    {
+        LOCKER(m_lock);
+        for (auto& window : m_readahead_windows) {
+            if (index < window.first_block || index >= window.first_block + window.block_count)
+                continue;
+            // Waiting may let someone else touch the windows, so hang on to the request.
+            request = window.request;
+            offset = index - window.first_block;
+            is_last_block = offset == window.block_count - 1;
+            break;
+        }
+    }
+    if (!request)
+        return false;
+
+    bool success = request->wait();
+    if (success)
+        memcpy(buffer, request->buffer() + offset * block_size(), block_size());
+    if (!success || is_last_block) {
+        LOCKER(m_lock);
+        m_readahead_windows.remove_first_matching([&](auto& it) {
+            return it.request.ptr() == request.ptr();
+        });
+    }
+    return success;
+}
+
+void DiskBackedFS::start_readahead(unsigned index) const
+{
+    // Don't read past the end of the file system.
+    unsigned total_blocks = total_block_count();
+    if (index >= total_blocks)
+        return;
+
+    LOCKER(m_lock);
+
+    // Stay one window ahead of the reader: start after whatever is already
+    // being fetched, unless that's already a full window away.
+    unsigned first_block = index;
+    for (bool extended = true; extended;) {
+        extended = false;
+        for (auto& window : m_readahead_windows) {
+            if (first_block >= window.first_block && first_block < window.first_block + window.block_count) {
+                first_block = window.first_block + window.block_count;
+                extended = true;
+            }
+        }
+    }
+    if (first_block >= index + readahead_block_count || first_block >= total_blocks)
+        return;
+    unsigned block_count = min(readahead_block_count, total_blocks - first_block);
+
+    unsigned device_blocks_per_block = block_size() / device().block_size();
+    auto request = DiskRequest::create_with_buffer(DiskRequest::Type::Read, first_block * device_blocks_per_block, block_count * device_blocks_per_block, device().block_size());
+    const_cast<DiskDevice&>(device()).submit(request);
+
+    if (m_readahead_windows.size() == max_readahead_windows)
+        m_readahead_windows.take_first();
+    m_readahead_windows.append({ first_block, block_count, move(request) });
+}
+
+void DiskBackedFS::discard_readahead(unsigned index) const
+{
+    LOCKER(m_lock);
+    for (int i = 0; i < m_readahead_windows.size();) {
+        auto& window = m_readahead_windows[i];
+        if (index >= window.first_block && index < window.first_block + window.block_count)
+            m_readahead_windows.remove(i);
+        else
+            ++i;
+    }
+}
+
 bool DiskBackedFS::read_blocks(unsigned index, unsigned count, u8* buffer, FileDescription* description) const
 {
     if (!count)
@@ -174,38 +312,74 @@ bool DiskBackedFS::read_blocks(unsigned index, unsigned count, u8* buffer, FileD
 void DiskBackedFS::flush_specific_block_if_needed(unsigned index)
 {
     LOCKER(m_lock);
-    if (!cache().is_dirty())
-        return;
     cache().for_each_entry([&](CacheEntry& entry) {
-        if (entry.is_dirty && entry.block_index == index) {
-            DiskOffset base_offset = static_cast<DiskOffset>(entry.block_index) * static_cast<DiskOffset>(block_size());
-            device().write(base_offset, block_size(), entry.data);
+        if (entry.block_index != index)
+            return;
+        if (entry.pending_write)
+            entry.pending_write->wait();
+        if (entry.is_dirty) {
+            transfer(DiskRequest::Type::Write, entry.block_index, 1, entry.data);
             entry.is_dirty = false;
         }
     });
 }
 
-void DiskBackedFS::flush_writes_impl()
+void DiskBackedFS::start_writeback()
 {
     LOCKER(m_lock);
+
+    // Forget about writes that have finished. Only drop requests that were
+    // complete before we looked at the entries, so no entry is left pointing at one.
+    NonnullRefPtrVector<DiskRequest> finished_writes;
+    NonnullRefPtrVector<DiskRequest> unfinished_writes;
+    for (auto& request : m_pending_writes) {
+        if (request.is_complete())
+            finished_writes.append(request);
+        else
+            unfinished_writes.append(request);
+    }
+    cache().for_each_entry([](CacheEntry& entry) {
+        if (entry.pending_write && entry.pending_write->is_complete())
+            entry.pending_write = nullptr;
+    });
+    m_pending_writes = move(unfinished_writes);
+
     if (!cache().is_dirty())
         return;
     u32 count = 0;
     cache().for_each_entry([&](CacheEntry& entry) {
         if (!entry.is_dirty)
             return;
-        DiskOffset base_offset = static_cast<DiskOffset>(entry.block_index) * static_cast<DiskOffset>(block_size());
-        device().write(base_offset, block_size(), entry.data);
-        ++count;
+        auto request = submit(DiskRequest::Type::Write, entry.block_index, 1, entry.data, DiskRequest::Priority::Background);
+        entry.pending_write = request.ptr();
+        m_pending_writes.append(move(request));
         entry.is_dirty = false;
+        ++count;
     });
     cache().set_dirty(false);
-    dbg() << class_name() << ": Flushed " << count << " blocks to disk";
+    dbg() << class_name() << ": Queued " << count << " blocks for writeback";
+}
+
+void DiskBackedFS::wait_for_writeback()
+{
+    // Don't hold up the whole file system while the disk gets to it.
+    NonnullRefPtrVector<DiskRequest> pending_writes;
+    {
+        LOCKER(m_lock);
+        pending_writes = m_pending_writes;
+    }
+    for (auto& request : pending_writes)
+        request.wait();
 }
 
 void DiskBackedFS::flush_writes()
 {
-    flush_writes_impl();
+    start_writeback();
+}
+
+void DiskBackedFS::wait_for_writes()
+{
+    wait_for_writeback();
 }
 
 DiskCache& DiskBackedFS::cache() const
@@ -2,6 +2,8 @@
 
 #include "FileSystem.h"
 #include <AK/ByteBuffer.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <Kernel/SeekQueue.h>
 
 class DiskCache;
 
@@ -14,9 +16,9 @@ public:
     DiskDevice& device() { return *m_device; }
     const DiskDevice& device() const { return *m_device; }
 
+    // Queues dirty blocks for writeback in the background priority class.
     virtual void flush_writes() override;
-
-    void flush_writes_impl();
+    virtual void wait_for_writes() override;
 
 protected:
     explicit DiskBackedFS(NonnullRefPtr<DiskDevice>&&);
@@ -28,9 +30,29 @@ protected:
     bool write_blocks(unsigned index, unsigned count, const u8*, FileDescription* = nullptr);
 
 private:
+    friend class DiskCache;
+
+    struct ReadaheadWindow {
+        unsigned first_block { 0 };
+        unsigned block_count { 0 };
+        NonnullRefPtr<DiskRequest> request;
+    };
+
     DiskCache& cache() const;
     void flush_specific_block_if_needed(unsigned index);
+    void start_writeback();
+    void wait_for_writeback();
+
+    NonnullRefPtr<DiskRequest> submit(DiskRequest::Type, unsigned index, unsigned count, u8* buffer, DiskRequest::Priority) const;
+    bool transfer(DiskRequest::Type, unsigned index, unsigned count, u8* buffer) const;
+
+    bool read_from_readahead(unsigned index, u8* buffer) const;
+    void start_readahead(unsigned index) const;
+    void discard_readahead(unsigned index) const;
 
     NonnullRefPtr<DiskDevice> m_device;
     mutable OwnPtr<DiskCache> m_cache;
+    mutable Vector<ReadaheadWindow> m_readahead_windows;
+    mutable unsigned m_last_read_index { 0 };
+    NonnullRefPtrVector<DiskRequest> m_pending_writes;
 };
@@ -506,16 +506,29 @@ void Ext2FS::flush_writes()
     // FIXME: It would be better to keep a capped number of Inodes around.
     //        The problem is that they are quite heavy objects, and use a lot of heap memory
     //        for their (child name lookup) and (block list) caches.
-    Vector<InodeIndex> unused_inodes;
-    for (auto& it : m_inode_cache) {
-        if (it.value->ref_count() != 1)
-            continue;
-        if (it.value->has_watchers())
-            continue;
-        unused_inodes.append(it.key);
+    //
+    // get_inode() takes new references to cached Inodes while holding the cache
+    // lock shared, so the scan and the removal have to happen under one
+    // exclusive hold. Otherwise an Inode could pick up a user in between and
+    // be uncached while in use, and the next lookup would load a second one.
+    // The removed Inodes are destroyed after we let go of the cache lock.
+    Vector<RefPtr<Ext2FSInode>> unused_inodes;
+    {
+        Locker cache_locker(m_inode_cache_lock);
+        Vector<InodeIndex> unused_indices;
+        for (auto& it : m_inode_cache) {
+            if (it.value->ref_count() != 1)
+                continue;
+            if (it.value->has_watchers())
+                continue;
+            unused_indices.append(it.key);
+        }
+        for (auto index : unused_indices) {
+            auto it = m_inode_cache.find(index);
+            unused_inodes.append(move((*it).value));
+            m_inode_cache.remove(it);
+        }
     }
-    for (auto index : unused_inodes)
-        uncache_inode(index);
 }
 
 Ext2FSInode::Ext2FSInode(Ext2FS& fs, unsigned index)
@@ -575,16 +588,27 @@ void Ext2FSInode::flush_metadata()
 
 RefPtr<Inode> Ext2FS::get_inode(InodeIdentifier inode) const
 {
-    LOCKER(m_lock);
     ASSERT(inode.fsid() == fsid());
 
-    {
+    auto find_in_cache = [&]() -> Optional<RefPtr<Inode>> {
+        LOCKER(m_inode_cache_lock, Lock::Mode::Shared);
         auto it = m_inode_cache.find(inode.index());
-        if (it != m_inode_cache.end())
-            return (*it).value;
-    }
+        if (it == m_inode_cache.end())
+            return {};
+        return RefPtr<Inode>((*it).value);
+    };
+
+    if (auto cached_inode = find_in_cache(); cached_inode.has_value())
+        return cached_inode.value();
+
+    LOCKER(m_lock);
+
+    // Someone else may have loaded it while we were waiting for the lock.
+    if (auto cached_inode = find_in_cache(); cached_inode.has_value())
+        return cached_inode.value();
 
     if (!get_inode_allocation_state(inode.index())) {
+        LOCKER(m_inode_cache_lock);
         m_inode_cache.set(inode.index(), nullptr);
         return nullptr;
     }
@@ -597,6 +621,7 @@ RefPtr<Inode> Ext2FS::get_inode(InodeIdentifier inode) const
 
     auto new_inode = adopt(*new Ext2FSInode(const_cast<Ext2FS&>(*this), inode.index()));
     memcpy(&new_inode->m_raw_inode, reinterpret_cast<ext2_inode*>(block + offset), sizeof(ext2_inode));
+    Locker cache_locker(m_inode_cache_lock);
     m_inode_cache.set(inode.index(), new_inode);
     return new_inode;
 }
@@ -1403,7 +1428,10 @@ RefPtr<Inode> Ext2FS::create_inode(InodeIdentifier parent_id, const String& name
     ASSERT(success);
 
     // We might have cached the fact that this inode didn't exist. Wipe the slate.
-    m_inode_cache.remove(inode_id);
+    {
+        LOCKER(m_inode_cache_lock);
+        m_inode_cache.remove(inode_id);
+    }
 
     auto inode = get_inode({ fsid(), inode_id });
     // If we've already computed a block list, no sense in throwing it away.
@@ -1500,6 +1528,7 @@ int Ext2FSInode::decrement_link_count()
 void Ext2FS::uncache_inode(InodeIndex index)
 {
     LOCKER(m_lock);
+    Locker cache_locker(m_inode_cache_lock);
     m_inode_cache.remove(index);
 }
 
@@ -1571,6 +1600,7 @@ unsigned Ext2FS::free_inode_count() const
 KResult Ext2FS::prepare_to_unmount() const
 {
     LOCKER(m_lock);
+    Locker cache_locker(m_inode_cache_lock);
 
     for (auto& it : m_inode_cache) {
         if (it.value->ref_count() > 1)
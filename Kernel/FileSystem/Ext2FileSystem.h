@@ -134,6 +134,8 @@ private:
     mutable ext2_super_block m_super_block;
     mutable Optional<KBuffer> m_cached_group_descriptor_table;
 
+    // Lookups vastly outnumber changes, so this has its own lock that readers can share.
+    mutable Lock m_inode_cache_lock { "Ext2FS:InodeCache" };
     mutable HashMap<InodeIndex, RefPtr<Ext2FSInode>> m_inode_cache;
 
     bool m_super_block_dirty { false };
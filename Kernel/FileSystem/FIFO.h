@@ -1,7 +1,7 @@
 #pragma once
 
-#include <Kernel/DoubleBuffer.h>
 #include <Kernel/FileSystem/File.h>
+#include <Kernel/RingBuffer.h>
 #include <Kernel/UnixTypes.h>
 
 class FileDescription;
@@ -40,7 +40,7 @@ private:
 
     unsigned m_writers { 0 };
     unsigned m_readers { 0 };
-    DoubleBuffer m_buffer;
+    RingBuffer m_buffer { 64 * KB };
 
     uid_t m_uid { 0 };
 };
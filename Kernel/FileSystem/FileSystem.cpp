@@ -56,21 +56,31 @@ FS::DirectoryEntry::DirectoryEntry(const char* n, int nl, InodeIdentifier i, u8
     name[nl] = '\0';
 }
 
-void FS::sync()
+static NonnullRefPtrVector<FS, 32> all_fses_snapshot()
 {
-    Inode::sync();
-
     NonnullRefPtrVector<FS, 32> fses;
-    {
-        InterruptDisabler disabler;
-        for (auto& it : all_fses())
-            fses.append(*it.value);
-    }
+    InterruptDisabler disabler;
+    for (auto& it : all_fses())
+        fses.append(*it.value);
+    return fses;
+}
 
-    for (auto& fs : fses)
+void FS::start_sync()
+{
+    Inode::sync();
+
+    for (auto& fs : all_fses_snapshot())
         fs.flush_writes();
 }
 
+void FS::sync()
+{
+    start_sync();
+
+    for (auto& fs : all_fses_snapshot())
+        fs.wait_for_writes();
+}
+
 void FS::lock_all()
 {
     for (auto& it : all_fses()) {
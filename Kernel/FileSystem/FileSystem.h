@@ -32,6 +32,7 @@ public:
     unsigned fsid() const { return m_fsid; }
     static FS* from_fsid(u32);
     static void sync();
+    static void start_sync();
     static void lock_all();
 
     virtual bool initialize() = 0;
@@ -62,7 +63,9 @@ public:
 
     virtual RefPtr<Inode> get_inode(InodeIdentifier) const = 0;
 
+    // Starts writing back dirty data. wait_for_writes() waits until it's done.
     virtual void flush_writes() {}
+    virtual void wait_for_writes() {}
 
     int block_size() const { return m_block_size; }
 
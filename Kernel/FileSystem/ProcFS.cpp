@@ -4,6 +4,7 @@
 #include "Process.h"
 #include "Scheduler.h"
 #include "StdLib.h"
+#include <AK/HashMap.h>
 #include <AK/JsonArraySerializer.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonObjectSerializer.h>
@@ -21,9 +22,11 @@
 #include <Kernel/Net/TCPSocket.h>
 #include <Kernel/Net/UDPSocket.h>
 #include <Kernel/PCI.h>
+#include <Kernel/ProfileBuffer.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/Heap/kmalloc.h>
 #include <LibC/errno_numbers.h>
+#include <LibELF/ELFLoader.h>
 
 enum ProcParentDirectory {
     PDI_AbstractRoot = 0,
@@ -52,6 +55,7 @@ enum ProcFileType {
     FI_Root_devices,
     FI_Root_uptime,
     FI_Root_cmdline,
+    FI_Root_locks,
     FI_Root_self, // symlink
     FI_Root_sys,  // directory
     FI_Root_net,  // directory
@@ -73,6 +77,7 @@ enum ProcFileType {
     FI_PID_stack,
     FI_PID_regs,
     FI_PID_fds,
+    FI_PID_profile,
     FI_PID_exe, // symlink
     FI_PID_cwd, // symlink
     FI_PID_fd,  // directory
@@ -325,6 +330,26 @@ Optional<KBuffer> procfs$cmdline(InodeIdentifier)
     return builder.build();
 }
 
+Optional<KBuffer> procfs$locks(InodeIdentifier)
+{
+    KBufferBuilder builder;
+    JsonArraySerializer array { builder };
+    Lock::for_each([&array](Lock& lock) {
+        auto statistics = lock.statistics();
+        if (!statistics.acquisitions)
+            return;
+        auto lock_object = array.add_object();
+        lock_object.add("name", lock.name() ? lock.name() : "");
+        lock_object.add("address", String::format("%p", &lock));
+        lock_object.add("acquisitions", statistics.acquisitions);
+        lock_object.add("waits", statistics.waits);
+        lock_object.add("total_wait_time_us", statistics.total_wait_time / 1000);
+        lock_object.add("max_wait_time_us", statistics.max_wait_time / 1000);
+    });
+    array.finish();
+    return builder.build();
+}
+
 Optional<KBuffer> procfs$net_adapters(InodeIdentifier)
 {
     KBufferBuilder builder;
@@ -480,6 +505,63 @@ Optional<KBuffer> procfs$pid_regs(InodeIdentifier identifier)
     return builder.build();
 }
 
+Optional<KBuffer> procfs$pid_profile(InodeIdentifier identifier)
+{
+    auto handle = ProcessInspectionHandle::from_pid(to_pid(identifier));
+    if (!handle)
+        return {};
+    auto& process = handle->process();
+
+    // A full buffer of deep stacks doesn't fit in the default 1 MB.
+    KBufferBuilder builder(8 * MB);
+    JsonObjectSerializer<KBufferBuilder> json { builder };
+    json.add("pid", process.pid());
+    json.add("executable", process.executable() ? process.executable()->absolute_path() : String(""));
+    json.add("profiling", process.is_profiling());
+
+    // Profiling may be restarted, replacing the buffer, while we're in here.
+    RefPtr<ProfileBuffer> profile_buffer = process.profile();
+    if (!profile_buffer) {
+        json.add_array("samples").finish();
+        json.add_object("symbols").finish();
+        json.finish();
+        return builder.build();
+    }
+
+    auto profile = profile_buffer->snapshot();
+    json.add("dropped_samples", profile->dropped_sample_count());
+
+    // Samples refer to frames by address, and each distinct address is
+    // symbolicated once in the "symbols" table.
+    HashMap<u32, String> symbols;
+    {
+        ProcessPagingScope paging_scope(process);
+        auto samples_array = json.add_array("samples");
+        profile->for_each_sample([&](auto& sample) {
+            auto sample_object = samples_array.add_object();
+            sample_object.add("tid", sample.tid);
+            sample_object.add("timestamp", sample.timestamp);
+            auto frames_array = sample_object.add_array("frames");
+            for (u32 i = 0; i < sample.frame_count; ++i) {
+                u32 address = sample.frames[i];
+                frames_array.add(address);
+                if (symbols.contains(address))
+                    continue;
+                auto symbol = symbolicate(process, address);
+                symbols.set(address, symbol.is_empty() ? String("??") : symbol);
+            }
+        });
+    }
+
+    auto symbols_object = json.add_object("symbols");
+    for (auto& it : symbols)
+        symbols_object.add(String::number(it.key), it.value);
+    symbols_object.finish();
+
+    json.finish();
+    return builder.build();
+}
+
 Optional<KBuffer> procfs$pid_exe(InodeIdentifier identifier)
 {
     auto handle = ProcessInspectionHandle::from_pid(to_pid(identifier));
@@ -1284,6 +1366,7 @@ ProcFS::ProcFS()
     m_entries[FI_Root_devices] = { "devices", FI_Root_devices, procfs$devices };
     m_entries[FI_Root_uptime] = { "uptime", FI_Root_uptime, procfs$uptime };
     m_entries[FI_Root_cmdline] = { "cmdline", FI_Root_cmdline, procfs$cmdline };
+    m_entries[FI_Root_locks] = { "locks", FI_Root_locks, procfs$locks };
     m_entries[FI_Root_sys] = { "sys", FI_Root_sys };
     m_entries[FI_Root_net] = { "net", FI_Root_net };
 
@@ -1298,6 +1381,7 @@ ProcFS::ProcFS()
     m_entries[FI_PID_stack] = { "stack", FI_PID_stack, procfs$pid_stack };
     m_entries[FI_PID_regs] = { "regs", FI_PID_regs, procfs$pid_regs };
     m_entries[FI_PID_fds] = { "fds", FI_PID_fds, procfs$pid_fds };
+    m_entries[FI_PID_profile] = { "profile", FI_PID_profile, procfs$pid_profile };
     m_entries[FI_PID_exe] = { "exe", FI_PID_exe, procfs$pid_exe };
     m_entries[FI_PID_cwd] = { "cwd", FI_PID_cwd, procfs$pid_cwd };
     m_entries[FI_PID_fd] = { "fd", FI_PID_fd };
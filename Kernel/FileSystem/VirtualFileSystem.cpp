@@ -628,6 +628,11 @@ void VFS::sync()
     FS::sync();
 }
 
+void VFS::start_sync()
+{
+    FS::start_sync();
+}
+
 Custody& VFS::root_custody()
 {
     if (!m_root_custody)
@@ -86,6 +86,7 @@ public:
     InodeIdentifier root_inode_id() const;
 
     void sync();
+    void start_sync();
 
     Custody& root_custody();
     KResultOr<NonnullRefPtr<Custody>> resolve_path(StringView path, Custody& base, RefPtr<Custody>* parent = nullptr, int options = 0);
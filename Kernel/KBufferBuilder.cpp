@@ -16,8 +16,8 @@ KBuffer KBufferBuilder::build()
     return m_buffer;
 }
 
-KBufferBuilder::KBufferBuilder()
-    : m_buffer(KBuffer::create_with_size(1048576))
+KBufferBuilder::KBufferBuilder(size_t capacity)
+    : m_buffer(KBuffer::create_with_size(capacity))
 {
 }
 
@@ -1,3 +1,4 @@
+#include <AK/QuickSort.h>
 #include <AK/TemporaryChange.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/KSyms.h>
@@ -19,15 +20,51 @@ static u8 parse_hex_digit(char nibble)
     return 10 + (nibble - 'a');
 }
 
+// Backtraces keep hitting the same handful of return addresses, so remember
+// recent lookups in a small direct-mapped cache in front of the binary search.
+static constexpr size_t ksym_cache_size = 256;
+static struct {
+    u32 address;
+    const KSym* ksym;
+} s_ksym_cache[ksym_cache_size];
+
 const KSym* ksymbolicate(u32 address)
 {
     if (address < ksym_lowest_address || address > ksym_highest_address)
         return nullptr;
-    for (unsigned i = 0; i < ksym_count; ++i) {
-        if (address < s_ksyms[i + 1].address)
-            return &s_ksyms[i];
+
+    auto& cache_entry = s_ksym_cache[(address >> 2) % ksym_cache_size];
+    if (cache_entry.ksym && cache_entry.address == address)
+        return cache_entry.ksym;
+
+    // Find the last symbol at or below the address.
+    u32 low = 0;
+    u32 high = ksym_count;
+    while (high - low > 1) {
+        u32 middle = low + (high - low) / 2;
+        if (s_ksyms[middle].address <= address)
+            low = middle;
+        else
+            high = middle;
     }
-    return nullptr;
+
+    cache_entry.address = address;
+    cache_entry.ksym = &s_ksyms[low];
+    return &s_ksyms[low];
+}
+
+String symbolicate(Process& process, u32 address)
+{
+    if (auto* ksym = ksymbolicate(address)) {
+        u32 offset = address - ksym->address;
+        // Past the last kernel symbol we can't really tell what this is.
+        if (ksym->address == ksym_highest_address && offset > 4096)
+            return {};
+        return String::format("%s +%u", ksym->name, offset);
+    }
+    if (process.elf_loader() && process.elf_loader()->has_symbols())
+        return process.elf_loader()->symbolicate(address);
+    return {};
 }
 
 static void load_ksyms_from_data(const ByteBuffer& buffer)
@@ -72,6 +109,18 @@ static void load_ksyms_from_data(const ByteBuffer& buffer)
         ++bufptr;
         ++current_ksym_index;
     }
+    ksym_count = current_ksym_index;
+
+    // kernel.map comes out of "nm -n", but ksymbolicate() depends on the order,
+    // so don't take that for granted.
+    bool is_sorted = true;
+    for (u32 i = 1; i < ksym_count && is_sorted; ++i)
+        is_sorted = s_ksyms[i - 1].address <= s_ksyms[i].address;
+    if (!is_sorted) {
+        quick_sort(s_ksyms, s_ksyms + ksym_count, [](auto& a, auto& b) {
+            return a.address < b.address;
+        });
+    }
     kprintf("ok\n");
     ksyms_ready = true;
 }
@@ -8,7 +8,15 @@ struct KSym {
     const char* name;
 };
 
+class Process;
+
 const KSym* ksymbolicate(u32 address);
+
+// Symbolicates kernel addresses with ksyms, and anything else with the
+// process's own ELF symbols, as "name +offset". Userspace symbols live in the
+// process's address space, so this has to run inside its paging scope.
+// Returns an empty string if the address can't be symbolicated.
+String symbolicate(Process&, u32 address);
 void load_ksyms();
 
 extern bool ksyms_ready;
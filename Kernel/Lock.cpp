@@ -1,6 +1,74 @@
+#include <Kernel/Arch/i386/PIT.h>
 #include <Kernel/Lock.h>
+#include <Kernel/Process.h>
+#include <Kernel/Thread.h>
 
-void Lock::lock()
+// How many times to retry before waiting in line, while the holder is
+// running on another processor and will likely let go soon.
+static const int max_spin_count = 1000;
+
+Lock* Lock::s_all_locks;
+
+Lock::Lock(const char* name)
+    : m_name(name)
+{
+    InterruptDisabler disabler;
+    m_next_lock = s_all_locks;
+    if (s_all_locks)
+        s_all_locks->m_prev_lock = this;
+    s_all_locks = this;
+}
+
+Lock::~Lock()
+{
+    InterruptDisabler disabler;
+    if (m_prev_lock)
+        m_prev_lock->m_next_lock = m_next_lock;
+    else
+        s_all_locks = m_next_lock;
+    if (m_next_lock)
+        m_next_lock->m_prev_lock = m_prev_lock;
+}
+
+Lock::Statistics Lock::statistics() const
+{
+    ScopedSpinLock guard(const_cast<SpinLock&>(m_spin_lock));
+    return m_statistics;
+}
+
+bool Lock::try_lock_without_waiting(Thread& thread, Mode mode)
+{
+    if (m_holder == &thread) {
+        ++m_level;
+        return true;
+    }
+    if (mode == Mode::Shared) {
+        // Someone who already holds it shared can't wait behind a writer that's waiting for them.
+        if (!m_holder && (!m_first_waiter || m_shared_holders.contains_slow(&thread))) {
+            m_shared_holders.append(&thread);
+            return true;
+        }
+        return false;
+    }
+    if (m_shared_holders.contains_slow(&thread)) {
+        kprintf("Thread %s(%u) can't upgrade shared Lock{%s} to exclusive\n", thread.process().name().characters(), thread.tid(), m_name);
+        dump_backtrace();
+        hang();
+    }
+    if (!m_holder && m_shared_holders.is_empty() && !m_first_waiter) {
+        m_holder = &thread;
+        m_level = 1;
+        return true;
+    }
+    return false;
+}
+
+bool Lock::holder_is_running_elsewhere() const
+{
+    return m_holder && m_holder != current && m_holder->state() == Thread::Running;
+}
+
+void Lock::lock(Mode mode)
 {
     ASSERT(!Scheduler::is_active());
     if (!are_interrupts_enabled()) {
@@ -8,63 +76,111 @@ void Lock::lock()
         dump_backtrace();
         hang();
     }
-    for (;;) {
-        bool expected = false;
-        if (m_lock.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-            if (!m_holder || m_holder == current) {
-                m_holder = current;
-                ++m_level;
-                m_lock.store(false, AK::memory_order_release);
+
+    auto& thread = *current;
+    Waiter waiter;
+    for (int spin_count = 0;; ++spin_count) {
+        {
+            ScopedSpinLock guard(m_spin_lock);
+            if (try_lock_without_waiting(thread, mode)) {
+                ++m_statistics.acquisitions;
                 return;
             }
-            m_lock.store(false, AK::memory_order_release);
+            if (spin_count >= max_spin_count || !holder_is_running_elsewhere()) {
+                ++m_statistics.acquisitions;
+                ++m_statistics.waits;
+                waiter.thread = &thread;
+                waiter.mode = mode;
+                if (m_last_waiter)
+                    m_last_waiter->next = &waiter;
+                else
+                    m_first_waiter = &waiter;
+                m_last_waiter = &waiter;
+                break;
+            }
+        }
+        // The holder can't get anywhere while we sit on the kernel lock.
+        u32 depth = g_kernel_lock.unlock_all();
+        asm volatile("pause");
+        g_kernel_lock.relock(depth);
+    }
+
+    u64 wait_start = PIT::nanoseconds_since_boot();
+    while (!waiter.granted) {
+        // Re-taking the big lock on the way out of Thread::block() can't block again.
+        if (thread.has_blocker()) {
+            if (auto* holder = m_holder)
+                Scheduler::donate_to(holder, m_name);
+            else
+                Scheduler::yield();
+            continue;
         }
-        Scheduler::donate_to(m_holder, m_name);
+        (void)thread.block_until(m_name ? m_name : "Lock", [&waiter] {
+            return waiter.granted;
+        });
     }
+    u64 wait_time = PIT::nanoseconds_since_boot() - wait_start;
+
+    ScopedSpinLock guard(m_spin_lock);
+    m_statistics.total_wait_time += wait_time;
+    if (wait_time > m_statistics.max_wait_time)
+        m_statistics.max_wait_time = wait_time;
 }
 
-void Lock::unlock()
+void Lock::hand_off_to_waiters()
 {
-    for (;;) {
-        bool expected = false;
-        if (m_lock.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-            ASSERT(m_holder == current);
-            ASSERT(m_level);
-            --m_level;
-            if (m_level) {
-                m_lock.store(false, AK::memory_order_release);
-                return;
-            }
-            m_holder = nullptr;
-            m_lock.store(false, AK::memory_order_release);
-            return;
+    // The lock is free. Give it to the first waiter, and if that's a reader,
+    // to all readers queued up right behind it.
+    while (m_first_waiter) {
+        auto* waiter = m_first_waiter;
+        if (waiter->mode == Mode::Exclusive && !m_shared_holders.is_empty())
+            break;
+        m_first_waiter = waiter->next;
+        if (!m_first_waiter)
+            m_last_waiter = nullptr;
+        if (waiter->mode == Mode::Exclusive) {
+            m_holder = waiter->thread;
+            m_level = 1;
+            waiter->granted = true;
+            break;
         }
-        Scheduler::donate_to(m_holder, m_name);
+        m_shared_holders.append(waiter->thread);
+        waiter->granted = true;
     }
 }
 
-bool Lock::unlock_if_locked()
+void Lock::unlock()
 {
-    for (;;) {
-        bool expected = false;
-        if (m_lock.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-            if (m_level == 0) {
-                m_lock.store(false, AK::memory_order_release);
-                return false;
-            }
-            if (m_holder != current) {
-                m_lock.store(false, AK::memory_order_release);
-                return false;
-            }
-            ASSERT(m_level);
-            --m_level;
-            if (m_level) {
-                m_lock.store(false, AK::memory_order_release);
-                return false;
+    ScopedSpinLock guard(m_spin_lock);
+    if (m_holder == current) {
+        ASSERT(m_level);
+        if (--m_level)
+            return;
+        m_holder = nullptr;
+    } else {
+        bool found = false;
+        for (int i = 0; i < m_shared_holders.size(); ++i) {
+            if (m_shared_holders[i] == current) {
+                m_shared_holders.remove(i);
+                found = true;
+                break;
             }
-            m_holder = nullptr;
-            m_lock.store(false, AK::memory_order_release);
-            return true;
         }
+        ASSERT(found);
+        if (!m_shared_holders.is_empty())
+            return;
     }
+    hand_off_to_waiters();
+}
+
+bool Lock::unlock_if_locked()
+{
+    ScopedSpinLock guard(m_spin_lock);
+    if (m_level == 0 || m_holder != current)
+        return false;
+    if (--m_level)
+        return false;
+    m_holder = nullptr;
+    hand_off_to_waiters();
+    return true;
 }
@@ -1,53 +1,104 @@
 #pragma once
 
 #include <AK/Assertions.h>
-#include <AK/Types.h>
 #include <AK/Atomic.h>
+#include <AK/Noncopyable.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Scheduler.h>
+#include <Kernel/SpinLock.h>
 
 class Thread;
-extern Thread* current;
 
+// A sleeping, recursive lock. Threads that can't get it right away spin for
+// a little while if the holder is running on another processor, and then
+// wait in line: the lock is handed directly to the longest waiting thread.
+//
+// Shared mode lets any number of readers in at once. A reader arriving while
+// a writer is waiting gets in line behind it, so writers can't starve.
+// Taking the lock in shared mode while holding it exclusively just nests the
+// exclusive hold; the opposite (upgrading) would deadlock and isn't allowed.
 class Lock {
+    AK_MAKE_NONCOPYABLE(Lock)
 public:
-    Lock(const char* name = nullptr)
-        : m_name(name)
-    {
-    }
-    ~Lock() {}
+    enum class Mode {
+        Exclusive,
+        Shared,
+    };
+
+    Lock(const char* name = nullptr);
+    ~Lock();
 
-    void lock();
+    void lock(Mode = Mode::Exclusive);
     void unlock();
     bool unlock_if_locked();
 
     const char* name() const { return m_name; }
 
+    // Counts every acquisition, how many of them had to wait, and for how long.
+    struct Statistics {
+        u32 acquisitions { 0 };
+        u32 waits { 0 };
+        u64 total_wait_time { 0 };
+        u64 max_wait_time { 0 };
+    };
+    Statistics statistics() const;
+
+    // Calls back with interrupts disabled for every Lock in the system.
+    template<typename Callback>
+    static void for_each(Callback callback)
+    {
+        InterruptDisabler disabler;
+        for (auto* lock = s_all_locks; lock; lock = lock->m_next_lock)
+            callback(*lock);
+    }
+
 private:
-    Atomic<bool> m_lock { false };
+    struct Waiter {
+        Thread* thread { nullptr };
+        Mode mode { Mode::Exclusive };
+        volatile bool granted { false };
+        Waiter* next { nullptr };
+    };
+
+    bool try_lock_without_waiting(Thread&, Mode);
+    bool holder_is_running_elsewhere() const;
+    void hand_off_to_waiters();
+
+    SpinLock m_spin_lock;
     u32 m_level { 0 };
     Thread* m_holder { nullptr };
+    Vector<Thread*, 4> m_shared_holders;
+    Waiter* m_first_waiter { nullptr };
+    Waiter* m_last_waiter { nullptr };
     const char* m_name { nullptr };
+    Statistics m_statistics;
+
+    static Lock* s_all_locks;
+    Lock* m_prev_lock { nullptr };
+    Lock* m_next_lock { nullptr };
 };
 
 class Locker {
 public:
-    [[gnu::always_inline]] inline explicit Locker(Lock& l)
+    [[gnu::always_inline]] inline explicit Locker(Lock& l, Lock::Mode mode = Lock::Mode::Exclusive)
         : m_lock(l)
+        , m_mode(mode)
     {
         lock();
     }
     [[gnu::always_inline]] inline ~Locker() { unlock(); }
     [[gnu::always_inline]] inline void unlock() { m_lock.unlock(); }
-    [[gnu::always_inline]] inline void lock() { m_lock.lock(); }
+    [[gnu::always_inline]] inline void lock() { m_lock.lock(m_mode); }
 
 private:
     Lock& m_lock;
+    Lock::Mode m_mode { Lock::Mode::Exclusive };
 };
 
-
-#define LOCKER(lock) Locker locker(lock)
+#define LOCKER(...) Locker locker(__VA_ARGS__)
 
 template<typename T>
 class Lockable {
@@ -70,3 +121,24 @@ private:
     T m_resource;
     Lock m_lock;
 };
+
+// A set of independently locked buckets, for tables where every operation only
+// touches one bucket and a single lock would serialize unrelated users.
+template<typename T, size_t bucket_count>
+class LockableBuckets {
+public:
+    Lockable<T>& bucket_for(u32 hash) { return m_buckets[hash % bucket_count]; }
+
+    // The buckets are only locked in shared mode, so the callback must not modify them.
+    template<typename Callback>
+    void for_each_bucket(Callback callback)
+    {
+        for (auto& bucket : m_buckets) {
+            LOCKER(bucket.lock(), Lock::Mode::Shared);
+            callback(bucket.resource());
+        }
+    }
+
+private:
+    Lockable<T> m_buckets[bucket_count];
+};
@@ -24,6 +24,7 @@
 #define REG_RADV 0x282C             // RX Int. Absolute Delay Timer
 #define REG_RSRPD 0x2C00            // RX Small Packet Detect Interrupt
 #define REG_TIPG 0x0410             // Transmit Inter Packet Gap
+#define REG_RXCSUM 0x5000           // RX Checksum Control
 #define ECTRL_SLU 0x40              //set link up
 #define RCTL_EN (1 << 1)            // Receiver Enable
 #define RCTL_SBP (1 << 2)           // Store Bad Packets
@@ -47,6 +48,20 @@
 #define RCTL_PMCF (1 << 23)         // Pass MAC Control Frames
 #define RCTL_SECRC (1 << 26)        // Strip Ethernet CRC
 
+// RXCSUM Register
+
+#define RXCSUM_IPOFL (1 << 8) // IP Checksum Offload Enable
+#define RXCSUM_TUOFL (1 << 9) // TCP/UDP Checksum Offload Enable
+
+// Receive Descriptor Status/Errors
+
+#define RDESC_STA_DD (1 << 0)    // Descriptor Done
+#define RDESC_STA_IXSM (1 << 2)  // Ignore Checksum Indication
+#define RDESC_STA_TCPCS (1 << 5) // TCP Checksum Calculated
+#define RDESC_STA_IPCS (1 << 6)  // IP Checksum Calculated
+#define RDESC_ERR_TCPE (1 << 5)  // TCP/UDP Checksum Error
+#define RDESC_ERR_IPE (1 << 6)   // IP Checksum Error
+
 // Buffer Sizes
 #define RCTL_BSIZE_256 (3 << 16)
 #define RCTL_BSIZE_512 (2 << 16)
@@ -141,6 +156,10 @@ E1000NetworkAdapter::E1000NetworkAdapter(PCI::Address pci_address, u8 irq)
     initialize_rx_descriptors();
     initialize_tx_descriptors();
 
+    // The legacy TX descriptor can insert one checksum per packet, which we use for TCP.
+    // The IPv4 header is only 20 bytes, so we keep summing that in software.
+    set_offload_capabilities(TCPChecksumTX | IPv4ChecksumRX | TCPChecksumRX);
+
     out32(REG_IMASK, 0x1f6dc);
     out32(REG_IMASK, 0xff & ~4);
     in32(0xc0);
@@ -242,6 +261,7 @@ void E1000NetworkAdapter::initialize_rx_descriptors()
     out32(REG_RXDESCHEAD, 0);
     out32(REG_RXDESCTAIL, number_of_rx_descriptors - 1);
 
+    out32(REG_RXCSUM, in32(REG_RXCSUM) | RXCSUM_IPOFL | RXCSUM_TUOFL);
     out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_8192);
 }
 
@@ -320,6 +340,17 @@ u32 E1000NetworkAdapter::in32(u16 address)
 }
 
 void E1000NetworkAdapter::send_raw(const u8* data, int length)
+{
+    send_with_descriptor(data, length, 0, 0, 0);
+}
+
+void E1000NetworkAdapter::send_raw_with_checksum_offload(const u8* data, int length, u16 checksum_start, u16 checksum_offset)
+{
+    ASSERT(checksum_start <= 0xff && checksum_offset <= 0xff);
+    send_with_descriptor(data, length, CMD_IC, checksum_start, checksum_offset);
+}
+
+void E1000NetworkAdapter::send_with_descriptor(const u8* data, int length, u8 extra_cmd, u8 checksum_start, u8 checksum_offset)
 {
     u32 tx_current = in32(REG_TXDESCTAIL);
 #ifdef E1000_DEBUG
@@ -330,7 +361,9 @@ void E1000NetworkAdapter::send_raw(const u8* data, int length)
     memcpy((void*)descriptor.addr, data, length);
     descriptor.length = length;
     descriptor.status = 0;
-    descriptor.cmd = CMD_EOP | CMD_IFCS | CMD_RS;
+    descriptor.css = checksum_start;
+    descriptor.cso = checksum_offset;
+    descriptor.cmd = CMD_EOP | CMD_IFCS | CMD_RS | extra_cmd;
 #ifdef E1000_DEBUG
     kprintf("E1000: Using tx descriptor %d (head is at %d)\n", tx_current, in32(REG_TXDESCHEAD));
 #endif
@@ -351,14 +384,23 @@ void E1000NetworkAdapter::receive()
         if (rx_current == in32(REG_RXDESCHEAD))
             return;
         rx_current = (rx_current + 1) % number_of_rx_descriptors;
-        if (!(m_rx_descriptors[rx_current].status & 1))
+        auto& descriptor = m_rx_descriptors[rx_current];
+        if (!(descriptor.status & RDESC_STA_DD))
             break;
-        auto* buffer = (u8*)m_rx_descriptors[rx_current].addr;
-        u16 length = m_rx_descriptors[rx_current].length;
+        auto* buffer = (u8*)descriptor.addr;
+        u16 length = descriptor.length;
 #ifdef E1000_DEBUG
         kprintf("E1000: Received 1 packet @ %p (%u) bytes!\n", buffer, length);
 #endif
-        did_receive(buffer, length);
+        // Bad checksums are left for the stack to find and drop, we only vouch for the good ones.
+        u32 verified_checksums = 0;
+        if (!(descriptor.status & RDESC_STA_IXSM)) {
+            if ((descriptor.status & RDESC_STA_IPCS) && !(descriptor.errors & RDESC_ERR_IPE))
+                verified_checksums |= IPv4ChecksumRX;
+            if ((descriptor.status & RDESC_STA_TCPCS) && !(descriptor.errors & RDESC_ERR_TCPE))
+                verified_checksums |= TCPChecksumRX;
+        }
+        did_receive(buffer, length, verified_checksums);
         m_rx_descriptors[rx_current].status = 0;
         out32(REG_RXDESCTAIL, rx_current);
     }
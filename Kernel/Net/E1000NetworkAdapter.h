@@ -14,6 +14,7 @@ public:
     virtual ~E1000NetworkAdapter() override;
 
     virtual void send_raw(const u8*, int) override;
+    virtual void send_raw_with_checksum_offload(const u8*, int, u16 checksum_start, u16 checksum_offset) override;
     virtual bool link_up() override;
 
 private:
@@ -58,6 +59,7 @@ private:
     u16 in16(u16 address);
     u32 in32(u16 address);
 
+    void send_with_descriptor(const u8*, int, u8 extra_cmd, u8 checksum_start, u8 checksum_offset);
     void receive();
 
     PCI::Address m_pci_address;
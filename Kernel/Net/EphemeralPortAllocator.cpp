@@ -0,0 +1,47 @@
+#include <Kernel/Devices/RandomDevice.h>
+#include <Kernel/Net/EphemeralPortAllocator.h>
+
+EphemeralPortAllocator::EphemeralPortAllocator(const char* name)
+    : m_lock(name)
+    , m_in_use(Bitmap::create(port_count, false))
+{
+}
+
+u16 EphemeralPortAllocator::allocate(Function<bool(u16)> is_usable)
+{
+    LOCKER(m_lock);
+    if (m_in_use_count == port_count)
+        return 0;
+
+    // Start at a random place so ports aren't trivially predictable, then skip over
+    // fully used bytes of the bitmap eight ports at a time.
+    int start = RandomDevice::random_value() % port_count;
+    int index = start;
+    for (int scanned = 0; scanned < port_count;) {
+        if ((index % 8) == 0 && index + 8 <= port_count && m_in_use.data()[index / 8] == 0xff) {
+            scanned += 8;
+            index = (index + 8) % port_count;
+            continue;
+        }
+        if (!m_in_use.get(index)) {
+            u16 port = first_port + index;
+            if (!is_usable || is_usable(port)) {
+                m_in_use.set(index, true);
+                ++m_in_use_count;
+                return port;
+            }
+        }
+        ++scanned;
+        index = (index + 1) % port_count;
+    }
+    return 0;
+}
+
+void EphemeralPortAllocator::release(u16 port)
+{
+    ASSERT(port >= first_port && port <= last_port);
+    LOCKER(m_lock);
+    ASSERT(m_in_use.get(port - first_port));
+    m_in_use.set(port - first_port, false);
+    --m_in_use_count;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <AK/Bitmap.h>
+#include <AK/Function.h>
+#include <AK/Types.h>
+#include <Kernel/Lock.h>
+
+// Hands out ports from the ephemeral range, with one bit per port to track which ones are in use.
+class EphemeralPortAllocator {
+public:
+    static const u16 first_port = 32768;
+    static const u16 last_port = 60999;
+    static const u16 port_count = last_port - first_port + 1;
+
+    explicit EphemeralPortAllocator(const char* name);
+
+    // Returns 0 if the range is exhausted. The callback can veto ports that are
+    // in use without having been allocated here (e.g. by an explicit bind()).
+    u16 allocate(Function<bool(u16)> is_usable = nullptr);
+    void release(u16 port);
+
+private:
+    Lock m_lock;
+    Bitmap m_in_use;
+    u16 m_in_use_count { 0 };
+};
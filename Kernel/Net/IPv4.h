@@ -12,6 +12,8 @@ enum class IPv4Protocol : u16 {
     UDP = 17,
 };
 
+u32 internet_checksum_accumulate(const void*, size_t, u32 partial_sum = 0);
+u16 internet_checksum_fold(u32 partial_sum);
 NetworkOrdered<u16> internet_checksum(const void*, size_t);
 
 class [[gnu::packed]] IPv4Packet
@@ -55,6 +57,11 @@ public:
         return internet_checksum(this, sizeof(IPv4Packet));
     }
 
+    bool is_checksum_valid() const
+    {
+        return internet_checksum_fold(internet_checksum_accumulate(this, internet_header_length() * sizeof(u32))) == 0xffff;
+    }
+
 private:
     u8 m_version_and_ihl { 0 };
     u8 m_dscp_and_ecn { 0 };
@@ -70,17 +77,52 @@ private:
 
 static_assert(sizeof(IPv4Packet) == 20);
 
-inline NetworkOrdered<u16> internet_checksum(const void* ptr, size_t count)
+// Adds the 16-bit one's complement sum of the given bytes to a running partial sum.
+// One's complement addition is byte-order independent, so we sum the raw memory
+// 32 bits at a time and only fold/swap once at the very end.
+inline u32 internet_checksum_accumulate(const void* ptr, size_t count, u32 partial_sum)
 {
-    u32 checksum = 0;
-    auto* w = (const u16*)ptr;
-    while (count > 1) {
-        checksum += convert_between_host_and_network(*w++);
-        if (checksum & 0x80000000)
-            checksum = (checksum & 0xffff) | (checksum >> 16);
+    u64 sum = partial_sum;
+    auto* p = (const u8*)ptr;
+    while (count >= 16) {
+        sum += *(const u32*)(p + 0);
+        sum += *(const u32*)(p + 4);
+        sum += *(const u32*)(p + 8);
+        sum += *(const u32*)(p + 12);
+        p += 16;
+        count -= 16;
+    }
+    while (count >= 4) {
+        sum += *(const u32*)p;
+        p += 4;
+        count -= 4;
+    }
+    if (count >= 2) {
+        sum += *(const u16*)p;
+        p += 2;
         count -= 2;
     }
-    while (checksum >> 16)
-        checksum = (checksum & 0xffff) + (checksum >> 16);
-    return ~checksum & 0xffff;
+    if (count)
+        sum += *p;
+    while (sum >> 32)
+        sum = (sum & 0xffffffff) + (sum >> 32);
+    return (u32)sum;
+}
+
+// Folds a partial sum into 16 bits. The result is in network byte order.
+inline u16 internet_checksum_fold(u32 partial_sum)
+{
+    while (partial_sum >> 16)
+        partial_sum = (partial_sum & 0xffff) + (partial_sum >> 16);
+    return partial_sum;
+}
+
+inline NetworkOrdered<u16> internet_checksum_finish(u32 partial_sum)
+{
+    return convert_between_host_and_network((u16)~internet_checksum_fold(partial_sum));
+}
+
+inline NetworkOrdered<u16> internet_checksum(const void* ptr, size_t count)
+{
+    return internet_checksum_finish(internet_checksum_accumulate(ptr, count));
 }
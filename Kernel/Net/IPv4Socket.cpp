@@ -17,12 +17,12 @@
 
 //#define IPV4_SOCKET_DEBUG
 
-Lockable<HashTable<IPv4Socket*>>& IPv4Socket::all_sockets()
+Lockable<HashTable<IPv4Socket*>>& IPv4Socket::raw_sockets_for_protocol(u8 protocol)
 {
-    static Lockable<HashTable<IPv4Socket*>>* s_table;
-    if (!s_table)
-        s_table = new Lockable<HashTable<IPv4Socket*>>;
-    return *s_table;
+    static LockableBuckets<HashTable<IPv4Socket*>, 16>* s_buckets;
+    if (!s_buckets)
+        s_buckets = new LockableBuckets<HashTable<IPv4Socket*>, 16>;
+    return s_buckets->bucket_for(protocol);
 }
 
 NonnullRefPtr<IPv4Socket> IPv4Socket::create(int type, int protocol)
@@ -40,14 +40,20 @@ IPv4Socket::IPv4Socket(int type, int protocol)
 #ifdef IPV4_SOCKET_DEBUG
     kprintf("%s(%u) IPv4Socket{%p} created with type=%u, protocol=%d\n", current->process().name().characters(), current->pid(), this, type, protocol);
 #endif
-    LOCKER(all_sockets().lock());
-    all_sockets().resource().set(this);
+    if (type == SOCK_RAW) {
+        auto& raw_sockets = raw_sockets_for_protocol(protocol);
+        LOCKER(raw_sockets.lock());
+        raw_sockets.resource().set(this);
+    }
 }
 
 IPv4Socket::~IPv4Socket()
 {
-    LOCKER(all_sockets().lock());
-    all_sockets().resource().remove(this);
+    if (type() == SOCK_RAW) {
+        auto& raw_sockets = raw_sockets_for_protocol(protocol());
+        LOCKER(raw_sockets.lock());
+        raw_sockets.resource().remove(this);
+    }
 }
 
 bool IPv4Socket::get_local_address(sockaddr* address, socklen_t* address_size)
@@ -166,6 +172,7 @@ int IPv4Socket::allocate_local_port_if_needed()
     if (port < 0)
         return port;
     m_local_port = (u16)port;
+    m_local_port_is_ephemeral = true;
     return port;
 }
 
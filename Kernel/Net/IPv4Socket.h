@@ -18,7 +18,8 @@ public:
     static NonnullRefPtr<IPv4Socket> create(int type, int protocol);
     virtual ~IPv4Socket() override;
 
-    static Lockable<HashTable<IPv4Socket*>>& all_sockets();
+    // SOCK_RAW sockets, bucketed by IP protocol number so incoming packets only visit likely receivers.
+    static Lockable<HashTable<IPv4Socket*>>& raw_sockets_for_protocol(u8 protocol);
 
     virtual KResult bind(const sockaddr*, socklen_t) override;
     virtual KResult connect(FileDescription&, const sockaddr*, socklen_t, ShouldBlock = ShouldBlock::Yes) override;
@@ -58,6 +59,7 @@ protected:
     virtual const char* class_name() const override { return "IPv4Socket"; }
 
     int allocate_local_port_if_needed();
+    bool local_port_is_ephemeral() const { return m_local_port_is_ephemeral; }
 
     virtual KResult protocol_bind() { return KSuccess; }
     virtual KResult protocol_listen() { return KSuccess; }
@@ -92,4 +94,5 @@ private:
     u8 m_ttl { 64 };
 
     bool m_can_read { false };
+    bool m_local_port_is_ephemeral { false };
 };
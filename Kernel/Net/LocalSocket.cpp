@@ -212,9 +212,9 @@ bool LocalSocket::can_write(const FileDescription& description) const
 {
     auto role = this->role(description);
     if (role == Role::Accepted)
-        return !has_attached_peer(description) || m_for_client.bytes_in_write_buffer() < 16384;
+        return !has_attached_peer(description) || m_for_client.space_for_writing() > 0;
     if (role == Role::Connected)
-        return !has_attached_peer(description) || m_for_server.bytes_in_write_buffer() < 16384;
+        return !has_attached_peer(description) || m_for_server.space_for_writing() > 0;
     return false;
 }
 
@@ -222,27 +222,53 @@ ssize_t LocalSocket::sendto(FileDescription& description, const void* data, size
 {
     if (!has_attached_peer(description))
         return -EPIPE;
+    auto* buffer = send_buffer_for(description);
+    ASSERT(buffer);
+
+    // IPC clients expect a message to go out whole or not at all, so a non-blocking
+    // write that fits in the buffer is never split up.
+    if (!description.is_blocking()) {
+        if (data_size <= buffer->capacity() && buffer->space_for_writing() < data_size)
+            return -EAGAIN;
+        return buffer->write((const u8*)data, data_size);
+    }
+
+    size_t nwritten = 0;
+    while (nwritten < data_size) {
+        nwritten += buffer->write((const u8*)data + nwritten, data_size - nwritten);
+        if (nwritten == data_size)
+            break;
+        if (current->block<Thread::WriteBlocker>(description) == Thread::BlockResult::InterruptedBySignal)
+            return nwritten ? nwritten : -EINTR;
+        if (!has_attached_peer(description))
+            return nwritten ? nwritten : -EPIPE;
+    }
+    return nwritten;
+}
+
+RingBuffer& LocalSocket::receive_buffer_for(FileDescription& description)
+{
     auto role = this->role(description);
     if (role == Role::Accepted)
-        return m_for_client.write((const u8*)data, data_size);
+        return m_for_server;
     if (role == Role::Connected)
-        return m_for_server.write((const u8*)data, data_size);
+        return m_for_client;
     ASSERT_NOT_REACHED();
 }
 
-DoubleBuffer& LocalSocket::buffer_for(FileDescription& description)
+RingBuffer* LocalSocket::send_buffer_for(FileDescription& description)
 {
     auto role = this->role(description);
     if (role == Role::Accepted)
-        return m_for_server;
+        return &m_for_client;
     if (role == Role::Connected)
-        return m_for_client;
-    ASSERT_NOT_REACHED();
+        return &m_for_server;
+    return nullptr;
 }
 
 ssize_t LocalSocket::recvfrom(FileDescription& description, void* buffer, size_t buffer_size, int, sockaddr*, socklen_t*)
 {
-    auto& buffer_for_me = buffer_for(description);
+    auto& buffer_for_me = receive_buffer_for(description);
     if (!description.is_blocking()) {
         if (buffer_for_me.is_empty()) {
             if (!has_attached_peer(description))
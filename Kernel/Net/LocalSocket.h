@@ -1,8 +1,8 @@
 #pragma once
 
 #include <AK/InlineLinkedList.h>
-#include <Kernel/DoubleBuffer.h>
 #include <Kernel/Net/Socket.h>
+#include <Kernel/RingBuffer.h>
 
 class FileDescription;
 
@@ -36,7 +36,8 @@ private:
     virtual bool is_local() const override { return true; }
     bool has_attached_peer(const FileDescription&) const;
     static Lockable<InlineLinkedList<LocalSocket>>& all_sockets();
-    DoubleBuffer& buffer_for(FileDescription&);
+    RingBuffer& receive_buffer_for(FileDescription&);
+    RingBuffer* send_buffer_for(FileDescription&);
 
     // An open socket file on the filesystem.
     RefPtr<FileDescription> m_file;
@@ -59,8 +60,9 @@ private:
     bool m_accept_side_fd_open { false };
     sockaddr_un m_address;
 
-    DoubleBuffer m_for_client;
-    DoubleBuffer m_for_server;
+    static const size_t buffer_capacity = 64 * KB;
+    RingBuffer m_for_client { buffer_capacity };
+    RingBuffer m_for_server { buffer_capacity };
 
     // for InlineLinkedList
     LocalSocket* m_prev { nullptr };
@@ -11,6 +11,8 @@ LoopbackAdapter& LoopbackAdapter::the()
 LoopbackAdapter::LoopbackAdapter()
 {
     set_interface_name("loop");
+    // Looped-back frames never touch a wire, so there is nothing for checksums to catch.
+    set_offload_capabilities(IPv4ChecksumTX | TCPChecksumTX | IPv4ChecksumRX | TCPChecksumRX);
 }
 
 LoopbackAdapter::~LoopbackAdapter()
@@ -20,5 +22,33 @@ LoopbackAdapter::~LoopbackAdapter()
 void LoopbackAdapter::send_raw(const u8* data, int size)
 {
     dbgprintf("LoopbackAdapter: Sending %d byte(s) to myself.\n", size);
-    did_receive(data, size);
+    did_receive(data, size, IPv4ChecksumRX | TCPChecksumRX);
+}
+
+void LoopbackAdapter::send_raw_with_checksum_offload(const u8* data, int size, u16, u16)
+{
+    send_raw(data, size);
+}
+
+KBuffer LoopbackAdapter::wrap_for_local_delivery(const IPv4Address& source, const IPv4Address& destination, IPv4Protocol protocol, const void* header, size_t header_size, const void* payload, size_t payload_size, u8 ttl)
+{
+    auto buffer = KBuffer::create_with_size(sizeof(IPv4Packet) + header_size + payload_size);
+    auto& ipv4 = *new (buffer.data()) IPv4Packet;
+    ipv4.set_version(4);
+    ipv4.set_internet_header_length(5);
+    ipv4.set_source(source);
+    ipv4.set_destination(destination);
+    ipv4.set_protocol((u8)protocol);
+    ipv4.set_length(sizeof(IPv4Packet) + header_size + payload_size);
+    ipv4.set_ident(1);
+    ipv4.set_ttl(ttl);
+    memcpy(ipv4.payload(), header, header_size);
+    if (payload_size)
+        memcpy((u8*)ipv4.payload() + header_size, payload, payload_size);
+    return buffer;
+}
+
+void LoopbackAdapter::did_deliver_locally(size_t size)
+{
+    did_send_and_receive_locally(sizeof(IPv4Packet) + size);
 }
@@ -10,8 +10,14 @@ public:
     virtual ~LoopbackAdapter() override;
 
     virtual void send_raw(const u8*, int) override;
+    virtual void send_raw_with_checksum_offload(const u8*, int, u16 checksum_start, u16 checksum_offset) override;
     virtual const char* class_name() const override { return "LoopbackAdapter"; }
 
+    // Builds the buffer IPv4Socket::did_receive() expects (IPv4 header, transport header, payload)
+    // so that sockets talking to themselves can skip Ethernet framing and the NetworkTask.
+    KBuffer wrap_for_local_delivery(const IPv4Address& source, const IPv4Address& destination, IPv4Protocol, const void* header, size_t header_size, const void* payload, size_t payload_size, u8 ttl);
+    void did_deliver_locally(size_t size);
+
 private:
     LoopbackAdapter();
 };
@@ -4,6 +4,7 @@
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/TCP.h>
 #include <Kernel/StdLib.h>
 #include <Kernel/Heap/kmalloc.h>
 
@@ -85,24 +86,36 @@ void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Addr
     ipv4.set_length(sizeof(IPv4Packet) + payload_size);
     ipv4.set_ident(1);
     ipv4.set_ttl(ttl);
-    ipv4.set_checksum(ipv4.compute_checksum());
+    if (!has_offload(IPv4ChecksumTX))
+        ipv4.set_checksum(ipv4.compute_checksum());
     m_packets_out++;
     m_bytes_out += size_in_bytes;
     memcpy(ipv4.payload(), payload, payload_size);
+    if (protocol == IPv4Protocol::TCP && has_offload(TCPChecksumTX)) {
+        u16 checksum_start = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
+        send_raw_with_checksum_offload((const u8*)&eth, size_in_bytes, checksum_start, checksum_start + TCPPacket::checksum_offset);
+        return;
+    }
     send_raw((const u8*)&eth, size_in_bytes);
 }
 
-void NetworkAdapter::did_receive(const u8* data, int length)
+void NetworkAdapter::send_raw_with_checksum_offload(const u8*, int, u16, u16)
+{
+    // Adapters that advertise TCPChecksumTX must override this.
+    ASSERT_NOT_REACHED();
+}
+
+void NetworkAdapter::did_receive(const u8* data, int length, u32 verified_checksums)
 {
     InterruptDisabler disabler;
     m_packets_in++;
     m_bytes_in += length;
-    m_packet_queue.append(KBuffer::copy(data, length));
+    m_packet_queue.append(ReceivedPacket { KBuffer::copy(data, length), verified_checksums });
     if (on_receive)
         on_receive();
 }
 
-Optional<KBuffer> NetworkAdapter::dequeue_packet()
+Optional<NetworkAdapter::ReceivedPacket> NetworkAdapter::dequeue_packet()
 {
     InterruptDisabler disabler;
     if (m_packet_queue.is_empty())
@@ -16,6 +16,20 @@ class NetworkAdapter;
 
 class NetworkAdapter : public Weakable<NetworkAdapter> {
 public:
+    // Work the adapter can take off the protocol stack's hands.
+    // The RX flags are also used per-packet to say which checksums were already verified.
+    enum OffloadCapability : u32 {
+        IPv4ChecksumTX = 1 << 0,
+        TCPChecksumTX = 1 << 1,
+        IPv4ChecksumRX = 1 << 2,
+        TCPChecksumRX = 1 << 3,
+    };
+
+    struct ReceivedPacket {
+        KBuffer buffer;
+        u32 verified_checksums { 0 };
+    };
+
     static void for_each(Function<void(NetworkAdapter&)>);
     static WeakPtr<NetworkAdapter> from_ipv4_address(const IPv4Address&);
     static WeakPtr<NetworkAdapter> lookup_by_name(const StringView&);
@@ -30,6 +44,9 @@ public:
     IPv4Address ipv4_gateway() const { return m_ipv4_gateway; }
     virtual bool link_up() { return false; }
 
+    u32 offload_capabilities() const { return m_offload_capabilities; }
+    bool has_offload(OffloadCapability capability) const { return m_offload_capabilities & capability; }
+
     void set_ipv4_address(const IPv4Address&);
     void set_ipv4_netmask(const IPv4Address&);
     void set_ipv4_gateway(const IPv4Address&);
@@ -37,7 +54,7 @@ public:
     void send(const MACAddress&, const ARPPacket&);
     void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl);
 
-    Optional<KBuffer> dequeue_packet();
+    Optional<ReceivedPacket> dequeue_packet();
 
     bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
 
@@ -52,16 +69,29 @@ protected:
     NetworkAdapter();
     void set_interface_name(const StringView& basename);
     void set_mac_address(const MACAddress& mac_address) { m_mac_address = mac_address; }
+    void set_offload_capabilities(u32 capabilities) { m_offload_capabilities = capabilities; }
     virtual void send_raw(const u8*, int) = 0;
-    void did_receive(const u8*, int);
+    // Like send_raw(), but the adapter must fill in a 16-bit checksum at checksum_offset,
+    // covering everything from checksum_start to the end of the frame. The checksum field
+    // has been seeded with the folded pseudo-header sum. Only called for TCPChecksumTX.
+    virtual void send_raw_with_checksum_offload(const u8*, int, u16 checksum_start, u16 checksum_offset);
+    void did_receive(const u8*, int, u32 verified_checksums = 0);
+    void did_send_and_receive_locally(size_t size)
+    {
+        m_packets_out++;
+        m_bytes_out += size;
+        m_packets_in++;
+        m_bytes_in += size;
+    }
 
 private:
     MACAddress m_mac_address;
     IPv4Address m_ipv4_address;
     IPv4Address m_ipv4_netmask;
     IPv4Address m_ipv4_gateway;
-    SinglyLinkedList<KBuffer> m_packet_queue;
+    SinglyLinkedList<ReceivedPacket> m_packet_queue;
     String m_name;
+    u32 m_offload_capabilities { 0 };
     u32 m_packets_in { 0 };
     u32 m_bytes_in { 0 };
     u32 m_packets_out { 0 };
@@ -23,10 +23,10 @@
 //#define TCP_DEBUG
 
 static void handle_arp(const EthernetFrameHeader&, size_t frame_size);
-static void handle_ipv4(const EthernetFrameHeader&, size_t frame_size);
+static void handle_ipv4(const EthernetFrameHeader&, size_t frame_size, u32 verified_checksums);
 static void handle_icmp(const EthernetFrameHeader&, const IPv4Packet&);
 static void handle_udp(const IPv4Packet&);
-static void handle_tcp(const IPv4Packet&);
+static void handle_tcp(const IPv4Packet&, u32 verified_checksums);
 
 void NetworkTask_main()
 {
@@ -55,15 +55,15 @@ void NetworkTask_main()
         };
     });
 
-    auto dequeue_packet = [&pending_packets]() -> Optional<KBuffer> {
-        Optional<KBuffer> packet;
+    auto dequeue_packet = [&pending_packets]() -> Optional<NetworkAdapter::ReceivedPacket> {
+        Optional<NetworkAdapter::ReceivedPacket> packet;
         NetworkAdapter::for_each([&packet, &pending_packets](auto& adapter) {
             if (packet.has_value() || !adapter.has_queued_packets())
                 return;
             packet = adapter.dequeue_packet();
             pending_packets--;
 #ifdef NETWORK_TASK_DEBUG
-            kprintf("NetworkTask: Dequeued packet from %s (%d bytes)\n", adapter.name().characters(), packet.value().size());
+            kprintf("NetworkTask: Dequeued packet from %s (%d bytes)\n", adapter.name().characters(), packet.value().buffer.size());
 #endif
         });
         return packet;
@@ -78,7 +78,8 @@ void NetworkTask_main()
             });
             continue;
         }
-        auto& packet = packet_maybe_null.value();
+        auto& packet = packet_maybe_null.value().buffer;
+        u32 verified_checksums = packet_maybe_null.value().verified_checksums;
         if (packet.size() < sizeof(EthernetFrameHeader)) {
             kprintf("NetworkTask: Packet is too small to be an Ethernet packet! (%zu)\n", packet.size());
             continue;
@@ -119,7 +120,7 @@ void NetworkTask_main()
             handle_arp(eth, packet.size());
             break;
         case EtherType::IPv4:
-            handle_ipv4(eth, packet.size());
+            handle_ipv4(eth, packet.size(), verified_checksums);
             break;
         case EtherType::IPv6:
             // ignore
@@ -192,7 +193,7 @@ void handle_arp(const EthernetFrameHeader& eth, size_t frame_size)
     }
 }
 
-void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size)
+void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size, u32 verified_checksums)
 {
     constexpr size_t minimum_ipv4_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
     if (frame_size < minimum_ipv4_frame_size) {
@@ -212,6 +213,11 @@ void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size)
         return;
     }
 
+    if (!(verified_checksums & NetworkAdapter::IPv4ChecksumRX) && !packet.is_checksum_valid()) {
+        kprintf("handle_ipv4: Dropping packet with bad header checksum from %s\n", packet.source().to_string().characters());
+        return;
+    }
+
 #ifdef IPV4_DEBUG
     kprintf("handle_ipv4: source=%s, target=%s\n",
         packet.source().to_string().characters(),
@@ -224,7 +230,7 @@ void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size)
     case IPv4Protocol::UDP:
         return handle_udp(packet);
     case IPv4Protocol::TCP:
-        return handle_tcp(packet);
+        return handle_tcp(packet, verified_checksums);
     default:
         kprintf("handle_ipv4: Unhandled protocol %u\n", packet.protocol());
         break;
@@ -243,11 +249,12 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
 #endif
 
     {
-        LOCKER(IPv4Socket::all_sockets().lock());
-        for (RefPtr<IPv4Socket> socket : IPv4Socket::all_sockets().resource()) {
-            LOCKER(socket->lock());
+        auto& raw_sockets = IPv4Socket::raw_sockets_for_protocol((u8)IPv4Protocol::ICMP);
+        LOCKER(raw_sockets.lock());
+        for (RefPtr<IPv4Socket> socket : raw_sockets.resource()) {
             if (socket->protocol() != (unsigned)IPv4Protocol::ICMP)
                 continue;
+            LOCKER(socket->lock());
             socket->did_receive(ipv4_packet.source(), 0, KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
         }
     }
@@ -311,7 +318,7 @@ void handle_udp(const IPv4Packet& ipv4_packet)
     socket->did_receive(ipv4_packet.source(), udp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
 }
 
-void handle_tcp(const IPv4Packet& ipv4_packet)
+void handle_tcp(const IPv4Packet& ipv4_packet, u32 verified_checksums)
 {
     if (ipv4_packet.payload_size() < sizeof(TCPPacket)) {
         kprintf("handle_tcp: IPv4 payload is too small to be a TCP packet (%u, need %zu)\n", ipv4_packet.payload_size(), sizeof(TCPPacket));
@@ -333,6 +340,13 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
 
     size_t payload_size = ipv4_packet.payload_size() - tcp_packet.header_size();
 
+    if (!(verified_checksums & NetworkAdapter::TCPChecksumRX)) {
+        if (TCPSocket::compute_tcp_checksum(ipv4_packet.source(), ipv4_packet.destination(), tcp_packet, payload_size) != 0) {
+            kprintf("handle_tcp: Dropping packet with bad checksum from %s:%u\n", ipv4_packet.source().to_string().characters(), tcp_packet.source_port());
+            return;
+        }
+    }
+
 #ifdef TCP_DEBUG
     kprintf("handle_tcp: source=%s:%u, destination=%s:%u seq_no=%u, ack_no=%u, flags=%w (%s%s%s%s), window_size=%u, payload_size=%u\n",
         ipv4_packet.source().to_string().characters(),
@@ -19,6 +19,9 @@ public:
     TCPPacket() {}
     ~TCPPacket() {}
 
+    // Byte offset of m_checksum, for adapters that insert the checksum themselves.
+    static constexpr u16 checksum_offset = 16;
+
     size_t header_size() const { return data_offset() * sizeof(u32); }
 
     u16 source_port() const { return m_source_port; }
@@ -1,6 +1,7 @@
 #include <AK/Time.h>
-#include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/Net/EphemeralPortAllocator.h>
+#include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/NetworkAdapter.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Net/TCP.h>
@@ -9,11 +10,30 @@
 
 //#define TCP_SOCKET_DEBUG
 
+typedef LockableBuckets<HashMap<IPv4SocketTuple, TCPSocket*>, 64> TupleBuckets;
+
+static TupleBuckets& tuple_buckets()
+{
+    static TupleBuckets* s_buckets;
+    if (!s_buckets)
+        s_buckets = new TupleBuckets;
+    return *s_buckets;
+}
+
+static EphemeralPortAllocator& ephemeral_ports()
+{
+    static EphemeralPortAllocator* s_allocator;
+    if (!s_allocator)
+        s_allocator = new EphemeralPortAllocator("TCP ephemeral ports");
+    return *s_allocator;
+}
+
 void TCPSocket::for_each(Function<void(TCPSocket&)> callback)
 {
-    LOCKER(sockets_by_tuple().lock());
-    for (auto& it : sockets_by_tuple().resource())
-        callback(*it.value);
+    tuple_buckets().for_each_bucket([&](auto& sockets) {
+        for (auto& it : sockets)
+            callback(*it.value);
+    });
 }
 
 void TCPSocket::set_state(State new_state)
@@ -30,29 +50,29 @@ void TCPSocket::set_state(State new_state)
         m_role = Role::Connected;
 }
 
-Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::sockets_by_tuple()
+Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::sockets_by_tuple(u16 local_port)
 {
-    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>* s_map;
-    if (!s_map)
-        s_map = new Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>;
-    return *s_map;
+    // Every lookup for a segment (exact, address and wildcard match) shares the local port,
+    // so bucketing on it lets unrelated connections come and go without contending.
+    return tuple_buckets().bucket_for(local_port);
 }
 
 RefPtr<TCPSocket> TCPSocket::from_tuple(const IPv4SocketTuple& tuple)
 {
-    LOCKER(sockets_by_tuple().lock());
+    auto& sockets = sockets_by_tuple(tuple.local_port());
+    LOCKER(sockets.lock(), Lock::Mode::Shared);
 
-    auto exact_match = sockets_by_tuple().resource().get(tuple);
+    auto exact_match = sockets.resource().get(tuple);
     if (exact_match.has_value())
         return { *exact_match.value() };
 
     auto address_tuple = IPv4SocketTuple(tuple.local_address(), tuple.local_port(), IPv4Address(), 0);
-    auto address_match = sockets_by_tuple().resource().get(address_tuple);
+    auto address_match = sockets.resource().get(address_tuple);
     if (address_match.has_value())
         return { *address_match.value() };
 
     auto wildcard_tuple = IPv4SocketTuple(IPv4Address(), tuple.local_port(), IPv4Address(), 0);
-    auto wildcard_match = sockets_by_tuple().resource().get(wildcard_tuple);
+    auto wildcard_match = sockets.resource().get(wildcard_tuple);
     if (wildcard_match.has_value())
         return { *wildcard_match.value() };
 
@@ -68,8 +88,9 @@ RefPtr<TCPSocket> TCPSocket::create_client(const IPv4Address& new_local_address,
 {
     auto tuple = IPv4SocketTuple(new_local_address, new_local_port, new_peer_address, new_peer_port);
 
-    LOCKER(sockets_by_tuple().lock());
-    if (sockets_by_tuple().resource().contains(tuple))
+    auto& sockets = sockets_by_tuple(tuple.local_port());
+    LOCKER(sockets.lock());
+    if (sockets.resource().contains(tuple))
         return {};
 
     auto client = TCPSocket::create(protocol());
@@ -83,7 +104,7 @@ RefPtr<TCPSocket> TCPSocket::create_client(const IPv4Address& new_local_address,
     client->set_originator(*this);
 
     m_pending_release_for_accept.set(tuple, client);
-    sockets_by_tuple().resource().set(tuple, client);
+    sockets.resource().set(tuple, client);
 
     return from_tuple(tuple);
 }
@@ -108,8 +129,13 @@ TCPSocket::TCPSocket(int protocol)
 
 TCPSocket::~TCPSocket()
 {
-    LOCKER(sockets_by_tuple().lock());
-    sockets_by_tuple().resource().remove(tuple());
+    {
+        auto& sockets = sockets_by_tuple(local_port());
+        LOCKER(sockets.lock());
+        sockets.resource().remove(tuple());
+    }
+    if (local_port_is_ephemeral())
+        ephemeral_ports().release(local_port());
 }
 
 NonnullRefPtr<TCPSocket> TCPSocket::create(int protocol)
@@ -159,7 +185,20 @@ void TCPSocket::send_tcp_packet(u16 flags, const void* payload, int payload_size
     }
 
     memcpy(tcp_packet.payload(), payload, payload_size);
-    tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+
+    auto routing_decision = route_to(peer_address(), local_address());
+    ASSERT(!routing_decision.is_zero());
+
+    if (routing_decision.adapter.ptr() == &LoopbackAdapter::the() && deliver_to_local_peer(tcp_packet, payload_size))
+        return;
+
+    if (routing_decision.adapter->has_offload(NetworkAdapter::TCPChecksumTX)) {
+        // The adapter sums the segment itself, we only have to seed it with the pseudo-header.
+        u32 sum = compute_tcp_pseudo_header_sum(local_address(), peer_address(), buffer.size());
+        tcp_packet.set_checksum(convert_between_host_and_network(internet_checksum_fold(sum)));
+    } else {
+        tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+    }
 
     if (tcp_packet.has_syn() || payload_size > 0) {
         LOCKER(m_not_acked_lock);
@@ -168,9 +207,6 @@ void TCPSocket::send_tcp_packet(u16 flags, const void* payload, int payload_size
         return;
     }
 
-    auto routing_decision = route_to(peer_address(), local_address());
-    ASSERT(!routing_decision.is_zero());
-
     routing_decision.adapter->send_ipv4(
         routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
         buffer.data(), buffer.size(), ttl());
@@ -179,6 +215,44 @@ void TCPSocket::send_tcp_packet(u16 flags, const void* payload, int payload_size
     m_bytes_out += buffer.size();
 }
 
+bool TCPSocket::deliver_to_local_peer(const TCPPacket& tcp_packet, int payload_size)
+{
+    // Only data on an established connection takes the shortcut, the handshake and
+    // teardown still go through the state machine in NetworkTask.
+    if (m_state != State::Established || tcp_packet.flags() != (TCPFlags::PUSH | TCPFlags::ACK) || !payload_size)
+        return false;
+
+    {
+        // Anything we're still waiting to have acknowledged has to arrive first.
+        LOCKER(m_not_acked_lock);
+        if (!m_not_acked.is_empty())
+            return false;
+    }
+
+    auto peer = from_tuple(IPv4SocketTuple(peer_address(), peer_port(), local_address(), local_port()));
+    if (!peer || peer->peer_port() != local_port() || peer->state() != State::Established)
+        return false;
+
+    size_t segment_size = tcp_packet.header_size() + payload_size;
+    auto& loopback = LoopbackAdapter::the();
+    auto packet = loopback.wrap_for_local_delivery(local_address(), peer_address(), IPv4Protocol::TCP, &tcp_packet, segment_size, nullptr, 0, ttl());
+
+    {
+        LOCKER(peer->lock());
+        if (!peer->did_receive(local_address(), local_port(), move(packet)))
+            return false;
+        // The segment can't get lost, so there's no ACK to wait for. Just move the peer's window along.
+        peer->set_ack_number(tcp_packet.sequence_number() + payload_size);
+        peer->m_packets_in++;
+        peer->m_bytes_in += segment_size;
+    }
+
+    loopback.did_deliver_locally(segment_size);
+    m_packets_out++;
+    m_bytes_out += segment_size;
+    return true;
+}
+
 void TCPSocket::send_outgoing_packets()
 {
     auto routing_decision = route_to(peer_address(), local_address());
@@ -255,7 +329,7 @@ void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
     m_bytes_in += packet.header_size() + size;
 }
 
-NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+u32 TCPSocket::compute_tcp_pseudo_header_sum(const IPv4Address& source, const IPv4Address& destination, u16 segment_size)
 {
     struct [[gnu::packed]] PseudoHeader
     {
@@ -263,38 +337,18 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, c
         IPv4Address destination;
         u8 zero;
         u8 protocol;
-        NetworkOrdered<u16> payload_size;
+        NetworkOrdered<u16> segment_size;
     };
 
-    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, sizeof(TCPPacket) + payload_size };
+    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, segment_size };
+    return internet_checksum_accumulate(&pseudo_header, sizeof(pseudo_header));
+}
 
-    u32 checksum = 0;
-    auto* w = (const NetworkOrdered<u16>*)&pseudo_header;
-    for (size_t i = 0; i < sizeof(pseudo_header) / sizeof(u16); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    w = (const NetworkOrdered<u16>*)&packet;
-    for (size_t i = 0; i < sizeof(packet) / sizeof(u16); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    ASSERT(packet.data_offset() * 4 == sizeof(TCPPacket));
-    w = (const NetworkOrdered<u16>*)packet.payload();
-    for (size_t i = 0; i < payload_size / sizeof(u16); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    if (payload_size & 1) {
-        u16 expanded_byte = ((const u8*)packet.payload())[payload_size - 1] << 8;
-        checksum += expanded_byte;
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    return ~(checksum & 0xffff);
+NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+{
+    u16 segment_size = packet.header_size() + payload_size;
+    u32 sum = compute_tcp_pseudo_header_sum(source, destination, segment_size);
+    return internet_checksum_finish(internet_checksum_accumulate(&packet, segment_size, sum));
 }
 
 KResult TCPSocket::protocol_bind()
@@ -310,10 +364,11 @@ KResult TCPSocket::protocol_bind()
 
 KResult TCPSocket::protocol_listen()
 {
-    LOCKER(sockets_by_tuple().lock());
-    if (sockets_by_tuple().resource().contains(tuple()))
+    auto& sockets = sockets_by_tuple(local_port());
+    LOCKER(sockets.lock());
+    if (sockets.resource().contains(tuple()))
         return KResult(-EADDRINUSE);
-    sockets_by_tuple().resource().set(tuple(), this);
+    sockets.resource().set(tuple(), this);
     set_direction(Direction::Passive);
     set_state(State::Listen);
     set_setup_state(SetupState::Completed);
@@ -355,28 +410,29 @@ KResult TCPSocket::protocol_connect(FileDescription& description, ShouldBlock sh
 
 int TCPSocket::protocol_allocate_local_port()
 {
-    static const u16 first_ephemeral_port = 32768;
-    static const u16 last_ephemeral_port = 60999;
-    static const u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
-    u16 first_scan_port = first_ephemeral_port + RandomDevice::random_value() % ephemeral_port_range_size;
-
-    LOCKER(sockets_by_tuple().lock());
-    for (u16 port = first_scan_port;;) {
-        IPv4SocketTuple proposed_tuple(local_address(), port, peer_address(), peer_port());
-
-        auto it = sockets_by_tuple().resource().find(proposed_tuple);
-        if (it == sockets_by_tuple().resource().end()) {
-            set_local_port(port);
-            sockets_by_tuple().resource().set(proposed_tuple, this);
-            return port;
+    for (;;) {
+        // The bitmap only knows about ports it handed out, so also steer clear of explicitly bound ones.
+        u16 port = ephemeral_ports().allocate([this](u16 port) {
+            auto& sockets = sockets_by_tuple(port);
+            LOCKER(sockets.lock());
+            return !sockets.resource().contains(IPv4SocketTuple(local_address(), port, peer_address(), peer_port()));
+        });
+        if (!port)
+            return -EADDRINUSE;
+
+        // Someone may have listened on the tuple since we looked, so look again
+        // while claiming it.
+        IPv4SocketTuple port_tuple(local_address(), port, peer_address(), peer_port());
+        auto& sockets = sockets_by_tuple(port);
+        LOCKER(sockets.lock());
+        if (sockets.resource().contains(port_tuple)) {
+            ephemeral_ports().release(port);
+            continue;
         }
-        ++port;
-        if (port > last_ephemeral_port)
-            port = first_ephemeral_port;
-        if (port == first_scan_port)
-            break;
+        set_local_port(port);
+        sockets.resource().set(port_tuple, this);
+        return port;
     }
-    return -EADDRINUSE;
 }
 
 bool TCPSocket::protocol_is_disconnected() const
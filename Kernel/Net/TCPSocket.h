@@ -125,7 +125,10 @@ public:
     void send_outgoing_packets();
     void receive_tcp_packet(const TCPPacket&, u16 size);
 
-    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
+    static u32 compute_tcp_pseudo_header_sum(const IPv4Address& source, const IPv4Address& destination, u16 segment_size);
+    static NetworkOrdered<u16> compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket&, u16 payload_size);
+
+    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple(u16 local_port);
     static RefPtr<TCPSocket> from_tuple(const IPv4SocketTuple& tuple);
     static RefPtr<TCPSocket> from_endpoints(const IPv4Address& local_address, u16 local_port, const IPv4Address& peer_address, u16 peer_port);
 
@@ -142,7 +145,7 @@ private:
     explicit TCPSocket(int protocol);
     virtual const char* class_name() const override { return "TCPSocket"; }
 
-    static NetworkOrdered<u16> compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket&, u16 payload_size);
+    bool deliver_to_local_peer(const TCPPacket&, int payload_size);
 
     virtual int protocol_receive(const KBuffer&, void* buffer, size_t buffer_size, int flags) override;
     virtual int protocol_send(const void*, int) override;
@@ -1,32 +1,50 @@
-#include <Kernel/Devices/RandomDevice.h>
+#include <Kernel/Net/EphemeralPortAllocator.h>
+#include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/NetworkAdapter.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Net/UDP.h>
 #include <Kernel/Net/UDPSocket.h>
 #include <Kernel/Process.h>
 
+typedef LockableBuckets<HashMap<u16, UDPSocket*>, 64> PortBuckets;
+
+static PortBuckets& port_buckets()
+{
+    static PortBuckets* s_buckets;
+    if (!s_buckets)
+        s_buckets = new PortBuckets;
+    return *s_buckets;
+}
+
+static EphemeralPortAllocator& ephemeral_ports()
+{
+    static EphemeralPortAllocator* s_allocator;
+    if (!s_allocator)
+        s_allocator = new EphemeralPortAllocator("UDP ephemeral ports");
+    return *s_allocator;
+}
+
 void UDPSocket::for_each(Function<void(UDPSocket&)> callback)
 {
-    LOCKER(sockets_by_port().lock());
-    for (auto it : sockets_by_port().resource())
-        callback(*it.value);
+    port_buckets().for_each_bucket([&](auto& sockets) {
+        for (auto it : sockets)
+            callback(*it.value);
+    });
 }
 
-Lockable<HashMap<u16, UDPSocket*>>& UDPSocket::sockets_by_port()
+Lockable<HashMap<u16, UDPSocket*>>& UDPSocket::sockets_by_port(u16 port)
 {
-    static Lockable<HashMap<u16, UDPSocket*>>* s_map;
-    if (!s_map)
-        s_map = new Lockable<HashMap<u16, UDPSocket*>>;
-    return *s_map;
+    return port_buckets().bucket_for(port);
 }
 
 SocketHandle<UDPSocket> UDPSocket::from_port(u16 port)
 {
     RefPtr<UDPSocket> socket;
     {
-        LOCKER(sockets_by_port().lock());
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end())
+        auto& sockets = sockets_by_port(port);
+        LOCKER(sockets.lock(), Lock::Mode::Shared);
+        auto it = sockets.resource().find(port);
+        if (it == sockets.resource().end())
             return {};
         socket = (*it).value;
         ASSERT(socket);
@@ -41,8 +59,13 @@ UDPSocket::UDPSocket(int protocol)
 
 UDPSocket::~UDPSocket()
 {
-    LOCKER(sockets_by_port().lock());
-    sockets_by_port().resource().remove(local_port());
+    {
+        auto& sockets = sockets_by_port(local_port());
+        LOCKER(sockets.lock());
+        sockets.resource().remove(local_port());
+    }
+    if (local_port_is_ephemeral())
+        ephemeral_ports().release(local_port());
 }
 
 NonnullRefPtr<UDPSocket> UDPSocket::create(int protocol)
@@ -66,6 +89,21 @@ int UDPSocket::protocol_send(const void* data, int data_length)
     auto routing_decision = route_to(peer_address(), local_address());
     if (routing_decision.is_zero())
         return -EHOSTUNREACH;
+
+    if (routing_decision.adapter.ptr() == &LoopbackAdapter::the()) {
+        // Hand the datagram straight to the receiving socket, no need for framing or a NetworkTask round-trip.
+        UDPPacket udp_header;
+        udp_header.set_source_port(local_port());
+        udp_header.set_destination_port(peer_port());
+        udp_header.set_length(sizeof(UDPPacket) + data_length);
+        auto& loopback = LoopbackAdapter::the();
+        auto packet = loopback.wrap_for_local_delivery(local_address(), peer_address(), IPv4Protocol::UDP, &udp_header, sizeof(udp_header), data, data_length, ttl());
+        loopback.did_deliver_locally(sizeof(UDPPacket) + data_length);
+        if (auto socket = UDPSocket::from_port(peer_port()))
+            socket->did_receive(local_address(), local_port(), move(packet));
+        return data_length;
+    }
+
     auto buffer = ByteBuffer::create_zeroed(sizeof(UDPPacket) + data_length);
     auto& udp_packet = *(UDPPacket*)(buffer.data());
     udp_packet.set_source_port(local_port());
@@ -89,33 +127,35 @@ KResult UDPSocket::protocol_connect(FileDescription&, ShouldBlock)
 
 int UDPSocket::protocol_allocate_local_port()
 {
-    static const u16 first_ephemeral_port = 32768;
-    static const u16 last_ephemeral_port = 60999;
-    static const u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
-    u16 first_scan_port = first_ephemeral_port + RandomDevice::random_value() % ephemeral_port_range_size;
-
-    LOCKER(sockets_by_port().lock());
-    for (u16 port = first_scan_port;;) {
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end()) {
-            set_local_port(port);
-            sockets_by_port().resource().set(port, this);
-            return port;
+    for (;;) {
+        // The bitmap only knows about ports it handed out, so also steer clear of explicitly bound ones.
+        u16 port = ephemeral_ports().allocate([](u16 port) {
+            auto& sockets = sockets_by_port(port);
+            LOCKER(sockets.lock());
+            return !sockets.resource().contains(port);
+        });
+        if (!port)
+            return -EADDRINUSE;
+
+        // Someone may have bound the port since we looked, so look again while claiming it.
+        auto& sockets = sockets_by_port(port);
+        LOCKER(sockets.lock());
+        if (sockets.resource().contains(port)) {
+            ephemeral_ports().release(port);
+            continue;
         }
-        ++port;
-        if (port > last_ephemeral_port)
-            port = first_ephemeral_port;
-        if (port == first_scan_port)
-            break;
+        set_local_port(port);
+        sockets.resource().set(port, this);
+        return port;
     }
-    return -EADDRINUSE;
 }
 
 KResult UDPSocket::protocol_bind()
 {
-    LOCKER(sockets_by_port().lock());
-    if (sockets_by_port().resource().contains(local_port()))
+    auto& sockets = sockets_by_port(local_port());
+    LOCKER(sockets.lock());
+    if (sockets.resource().contains(local_port()))
         return KResult(-EADDRINUSE);
-    sockets_by_port().resource().set(local_port(), this);
+    sockets.resource().set(local_port(), this);
     return KSuccess;
 }
@@ -27,8 +27,10 @@
 #include <Kernel/Net/Socket.h>
 #include <Kernel/Process.h>
 #include <Kernel/ProcessTracer.h>
+#include <Kernel/ProfileBuffer.h>
 #include <Kernel/RTC.h>
 #include <Kernel/Scheduler.h>
+#include <Kernel/TimerQueue.h>
 #include <Kernel/SharedBuffer.h>
 #include <Kernel/StdLib.h>
 #include <Kernel/Syscall.h>
@@ -1089,11 +1091,6 @@ ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
 ssize_t Process::do_write(FileDescription& description, const u8* data, int data_size)
 {
     ssize_t nwritten = 0;
-    if (!description.is_blocking()) {
-        if (!description.can_write())
-            return -EAGAIN;
-    }
-
     if (description.should_append()) {
 #ifdef IO_DEBUG
         dbgprintf("seeking to end (O_APPEND)\n");
@@ -1106,21 +1103,24 @@ ssize_t Process::do_write(FileDescription& description, const u8* data, int data
         dbgprintf("while %u < %u\n", nwritten, size);
 #endif
         if (!description.can_write()) {
+            // A non-blocking write takes whatever fits, and stops there.
+            if (!description.is_blocking())
+                return nwritten ? nwritten : -EAGAIN;
 #ifdef IO_DEBUG
             dbgprintf("block write on %d\n", fd);
 #endif
-            if (current->block<Thread::WriteBlocker>(description) == Thread::BlockResult::InterruptedBySignal) {
-                if (nwritten == 0)
-                    return -EINTR;
-            }
+            if (current->block<Thread::WriteBlocker>(description) == Thread::BlockResult::InterruptedBySignal)
+                return nwritten ? nwritten : -EINTR;
         }
         ssize_t rc = description.write(data + nwritten, data_size - nwritten);
 #ifdef IO_DEBUG
         dbgprintf("   -> write returned %d\n", rc);
 #endif
         if (rc < 0) {
-            // FIXME: Support returning partial nwritten with errno.
-            ASSERT(nwritten == 0);
+            // Report what did get written; the error will come up again on
+            // the next write, if it's still there.
+            if (nwritten > 0)
+                return nwritten;
             return rc;
         }
         if (rc == 0)
@@ -1493,11 +1493,17 @@ unsigned Process::sys$alarm(unsigned seconds)
     if (m_alarm_deadline && m_alarm_deadline > g_uptime) {
         previous_alarm_remaining = (m_alarm_deadline - g_uptime) / TICKS_PER_SECOND;
     }
+    if (m_alarm_timer_id) {
+        TimerQueue::the().cancel_timer(m_alarm_timer_id);
+        m_alarm_timer_id = 0;
+    }
     if (!seconds) {
         m_alarm_deadline = 0;
         return previous_alarm_remaining;
     }
     m_alarm_deadline = g_uptime + seconds * TICKS_PER_SECOND;
+    // The scheduler delivers SIGALRM once the uptime has passed the deadline.
+    m_alarm_timer_id = TimerQueue::the().add_timer((m_alarm_deadline + 1) * 1000000, nullptr);
     return previous_alarm_remaining;
 }
 
@@ -1589,8 +1595,8 @@ int Process::sys$usleep(useconds_t usec)
 {
     if (!usec)
         return 0;
-    u64 wakeup_time = current->sleep(usec / 1000);
-    if (wakeup_time > g_uptime)
+    u64 wakeup_time = current->sleep((u64)usec * 1000);
+    if (wakeup_time > PIT::nanoseconds_since_boot())
         return -EINTR;
     return 0;
 }
@@ -1599,19 +1605,19 @@ int Process::sys$sleep(unsigned seconds)
 {
     if (!seconds)
         return 0;
-    u64 wakeup_time = current->sleep(seconds * TICKS_PER_SECOND);
-    if (wakeup_time > g_uptime) {
-        u32 ticks_left_until_original_wakeup_time = wakeup_time - g_uptime;
-        return ticks_left_until_original_wakeup_time / TICKS_PER_SECOND;
-    }
+    u64 wakeup_time = current->sleep((u64)seconds * 1000000000);
+    u64 now = PIT::nanoseconds_since_boot();
+    if (wakeup_time > now)
+        return (wakeup_time - now) / 1000000000;
     return 0;
 }
 
 timeval kgettimeofday()
 {
+    u64 nanoseconds = PIT::nanoseconds_since_boot();
     timeval tv;
-    tv.tv_sec = RTC::boot_time() + PIT::seconds_since_boot();
-    tv.tv_usec = PIT::ticks_this_second() * 1000;
+    tv.tv_sec = RTC::boot_time() + nanoseconds / 1000000000;
+    tv.tv_usec = (nanoseconds % 1000000000) / 1000;
     return tv;
 }
 
@@ -2501,8 +2507,12 @@ ssize_t Process::sys$sendto(const Syscall::SC_sendto_params* params)
 {
     if (!validate_read_typed(params))
         return -EFAULT;
+    return do_sendto(*params);
+}
 
-    auto& [sockfd, data, data_length, flags, addr, addr_length] = *params;
+ssize_t Process::do_sendto(const Syscall::SC_sendto_params& params)
+{
+    auto& [sockfd, data, data_length, flags, addr, addr_length] = params;
 
     if (!validate_read(data, data_length))
         return -EFAULT;
@@ -2522,8 +2532,12 @@ ssize_t Process::sys$recvfrom(const Syscall::SC_recvfrom_params* params)
 {
     if (!validate_read_typed(params))
         return -EFAULT;
+    return do_recvfrom(*params);
+}
 
-    auto& [sockfd, buffer, buffer_length, flags, addr, addr_length] = *params;
+ssize_t Process::do_recvfrom(const Syscall::SC_recvfrom_params& params)
+{
+    auto& [sockfd, buffer, buffer_length, flags, addr, addr_length] = params;
 
     if (!validate_write(buffer, buffer_length))
         return -EFAULT;
@@ -2553,6 +2567,170 @@ ssize_t Process::sys$recvfrom(const Syscall::SC_recvfrom_params* params)
     return nrecv;
 }
 
+// Checks the buffers of one io_ring batch. Entries mostly point into the same
+// few buffers, so we remember the last region we found and only look up another
+// one when a buffer falls outside of it.
+class IORingBufferValidator {
+public:
+    explicit IORingBufferValidator(Process& process)
+        : m_process(process)
+    {
+    }
+
+    bool validate_read(const void* buffer, size_t length) { return validate(buffer, length, false); }
+    bool validate_write(void* buffer, size_t length) { return validate(buffer, length, true); }
+
+    // The region may have been unmapped while an entry was blocked.
+    void forget() { m_range = {}; }
+
+private:
+    bool validate(const void* buffer, size_t length, bool write)
+    {
+        VirtualAddress address((u32)buffer);
+        if (address.get() + length < address.get())
+            return false;
+        if (m_range.is_valid() && m_range.contains(address, length) && (write ? m_writable : m_readable))
+            return true;
+
+        if (!m_process.is_ring0()) {
+            if (auto* region = m_process.region_containing({ address, length })) {
+                m_range = { region->vaddr(), region->size() };
+                m_readable = region->is_readable();
+                m_writable = region->is_writable();
+                return write ? m_writable : m_readable;
+            }
+        }
+
+        // Spans more than one region, or isn't in userspace at all.
+        if (write)
+            return m_process.validate_write(const_cast<void*>(buffer), length);
+        return m_process.validate_read(buffer, length);
+    }
+
+    Process& m_process;
+    Range m_range;
+    bool m_readable { false };
+    bool m_writable { false };
+};
+
+int Process::sys$io_ring_enter(io_ring* ring, int to_submit)
+{
+    static constexpr u32 max_entry_count = 4096;
+
+    if (to_submit < 0)
+        return -EINVAL;
+    if (!validate_read_typed(ring))
+        return -EFAULT;
+    u32 entry_count = ring->entry_count;
+    if (!entry_count || (entry_count & (entry_count - 1)) || entry_count > max_entry_count)
+        return -EINVAL;
+    if (!validate_write(ring, sizeof(io_ring) + entry_count * (sizeof(io_ring_submission) + sizeof(io_ring_completion))))
+        return -EFAULT;
+
+    auto* submissions = reinterpret_cast<io_ring_submission*>(ring + 1);
+    auto* completions = reinterpret_cast<io_ring_completion*>(submissions + entry_count);
+    u32 mask = entry_count - 1;
+
+    IORingBufferValidator validator(*this);
+
+    // Non-blocking descriptors complete with -EAGAIN when they aren't ready,
+    // rather than holding up the rest of the ring.
+    auto read_entry = [&](const io_ring_submission& submission) -> ssize_t {
+        if ((ssize_t)submission.length < 0)
+            return -EINVAL;
+        if (!submission.length)
+            return 0;
+        if (!validator.validate_write(submission.buffer, submission.length))
+            return -EFAULT;
+        auto* description = file_description(submission.fd);
+        if (!description)
+            return -EBADF;
+        if (description->is_directory())
+            return -EISDIR;
+        if (!description->can_read()) {
+            if (!description->is_blocking())
+                return -EAGAIN;
+            validator.forget();
+            if (current->block<Thread::ReadBlocker>(*description) == Thread::BlockResult::InterruptedBySignal)
+                return -EINTR;
+        }
+        return description->read((u8*)submission.buffer, submission.length);
+    };
+
+    auto write_entry = [&](const io_ring_submission& submission) -> ssize_t {
+        if ((ssize_t)submission.length < 0)
+            return -EINVAL;
+        if (!submission.length)
+            return 0;
+        if (!validator.validate_read(submission.buffer, submission.length))
+            return -EFAULT;
+        auto* description = file_description(submission.fd);
+        if (!description)
+            return -EBADF;
+        if (description->is_blocking())
+            validator.forget();
+        return do_write(*description, (const u8*)submission.buffer, submission.length);
+    };
+
+    // NOTE: Entries are executed in order on the calling thread, so a blocking
+    //       operation holds up everything queued behind it.
+    int submitted = 0;
+    while (submitted < to_submit) {
+        u32 head = ring->submission_head;
+        if (head == ring->submission_tail)
+            break;
+        if (ring->completion_tail - ring->completion_head >= entry_count)
+            break;
+
+        auto& submission = submissions[head & mask];
+        i32 result = 0;
+        u32 flags = 0;
+        switch (submission.opcode) {
+        case IORING_OP_NOP:
+            break;
+        case IORING_OP_READ:
+            result = read_entry(submission);
+            break;
+        case IORING_OP_WRITE:
+            result = write_entry(submission);
+            break;
+        case IORING_OP_SENDTO: {
+            validator.forget();
+            Syscall::SC_sendto_params params { submission.fd, submission.buffer, submission.length, submission.flags, submission.addr, submission.addr_length };
+            result = do_sendto(params);
+            break;
+        }
+        case IORING_OP_RECVFROM: {
+            validator.forget();
+            Syscall::SC_recvfrom_params params { submission.fd, submission.buffer, submission.length, submission.flags, submission.addr, submission.addr_length_ptr };
+            result = do_recvfrom(params);
+            break;
+        }
+        case IORING_OP_POLL:
+            validator.forget();
+            result = sys$poll(&submission.poll, 1, submission.timeout);
+            flags = (u16)submission.poll.revents;
+            break;
+        default:
+            result = -EINVAL;
+            break;
+        }
+
+        auto& completion = completions[ring->completion_tail & mask];
+        completion.user_data = submission.user_data;
+        completion.result = result;
+        completion.flags = flags;
+        ring->completion_tail = ring->completion_tail + 1;
+        ring->submission_head = head + 1;
+        ++submitted;
+
+        // Let the signal be dispatched before running anything else.
+        if (result == -EINTR)
+            break;
+    }
+    return submitted;
+}
+
 int Process::sys$getsockname(int sockfd, sockaddr* addr, socklen_t* addrlen)
 {
     if (!validate_read_typed(addrlen))
@@ -3299,10 +3477,12 @@ int Process::sys$clock_gettime(clockid_t clock_id, timespec* ts)
         return -EFAULT;
 
     switch (clock_id) {
-    case CLOCK_MONOTONIC:
-        ts->tv_sec = g_uptime / TICKS_PER_SECOND;
-        ts->tv_nsec = (g_uptime % TICKS_PER_SECOND) * 1000000;
+    case CLOCK_MONOTONIC: {
+        u64 nanoseconds = PIT::nanoseconds_since_boot();
+        ts->tv_sec = nanoseconds / 1000000000;
+        ts->tv_nsec = nanoseconds % 1000000000;
         break;
+    }
     default:
         return -EINVAL;
     }
@@ -3327,22 +3507,21 @@ int Process::sys$clock_nanosleep(const Syscall::SC_clock_nanosleep_params* param
 
     switch (clock_id) {
     case CLOCK_MONOTONIC: {
+        u64 requested_nanoseconds = (u64)requested_sleep->tv_sec * 1000000000 + requested_sleep->tv_nsec;
         u64 wakeup_time;
         if (is_absolute) {
-            u64 time_to_wake = (requested_sleep->tv_sec * 1000 + requested_sleep->tv_nsec / 1000000);
-            wakeup_time = current->sleep_until(time_to_wake);
+            wakeup_time = current->sleep_until(requested_nanoseconds);
         } else {
-            u32 ticks_to_sleep = (requested_sleep->tv_sec * 1000 + requested_sleep->tv_nsec / 1000000);
-            if (!ticks_to_sleep)
+            if (!requested_nanoseconds)
                 return 0;
-            wakeup_time = current->sleep(ticks_to_sleep);
+            wakeup_time = current->sleep(requested_nanoseconds);
         }
-        if (wakeup_time > g_uptime) {
-            u32 ticks_left = wakeup_time - g_uptime;
+        u64 now = PIT::nanoseconds_since_boot();
+        if (wakeup_time > now) {
+            u64 nanoseconds_left = wakeup_time - now;
             if (!is_absolute && remaining_sleep) {
-                remaining_sleep->tv_sec = ticks_left / TICKS_PER_SECOND;
-                ticks_left -= remaining_sleep->tv_sec * TICKS_PER_SECOND;
-                remaining_sleep->tv_nsec = ticks_left * 1000000;
+                remaining_sleep->tv_sec = nanoseconds_left / 1000000000;
+                remaining_sleep->tv_nsec = nanoseconds_left % 1000000000;
             }
             return -EINTR;
         }
@@ -3353,6 +3532,43 @@ int Process::sys$clock_nanosleep(const Syscall::SC_clock_nanosleep_params* param
     }
 }
 
+int Process::sys$profiling_enable(pid_t pid)
+{
+    InterruptDisabler disabler;
+    auto* peer = Process::from_pid(pid);
+    if (!peer)
+        return -ESRCH;
+    if (!is_superuser() && peer->uid() != m_euid)
+        return -EACCES;
+    // Start from a clean slate, but hang on to the samples after disabling
+    // so they can still be read from /proc/PID/profile.
+    peer->m_profile = ProfileBuffer::create();
+    peer->m_profiling = true;
+    return 0;
+}
+
+int Process::sys$profiling_disable(pid_t pid)
+{
+    InterruptDisabler disabler;
+    auto* peer = Process::from_pid(pid);
+    if (!peer)
+        return -ESRCH;
+    if (!is_superuser() && peer->uid() != m_euid)
+        return -EACCES;
+    if (!peer->m_profiling)
+        return -EINVAL;
+    peer->m_profiling = false;
+    return 0;
+}
+
+int Process::sys$get_time_page(const TimePage** address)
+{
+    if (!validate_write_typed(address))
+        return -EFAULT;
+    *address = (const TimePage*)PIT::time_page_address().as_ptr();
+    return 0;
+}
+
 int Process::sys$sync()
 {
     VFS::the().sync();
@@ -23,7 +23,9 @@ class PageDirectory;
 class Region;
 class VMObject;
 class ProcessTracer;
+class ProfileBuffer;
 class SharedBuffer;
+struct TimePage;
 
 timeval kgettimeofday();
 void kgettimeofday(timeval&);
@@ -196,6 +198,10 @@ public:
     int sys$connect(int sockfd, const sockaddr*, socklen_t);
     ssize_t sys$sendto(const Syscall::SC_sendto_params*);
     ssize_t sys$recvfrom(const Syscall::SC_recvfrom_params*);
+    int sys$io_ring_enter(io_ring*, int to_submit);
+    int sys$profiling_enable(pid_t);
+    int sys$profiling_disable(pid_t);
+    int sys$get_time_page(const TimePage**);
     int sys$getsockopt(const Syscall::SC_getsockopt_params*);
     int sys$setsockopt(const Syscall::SC_setsockopt_params*);
     int sys$getsockname(int sockfd, sockaddr* addr, socklen_t* addrlen);
@@ -238,6 +244,10 @@ public:
     ProcessTracer* tracer() { return m_tracer.ptr(); }
     ProcessTracer& ensure_tracer();
 
+    bool is_profiling() const { return m_profiling; }
+    const ProfileBuffer* profile() const { return m_profile.ptr(); }
+    ProfileBuffer* profile() { return m_profile.ptr(); }
+
     u32 m_ticks_in_user { 0 };
     u32 m_ticks_in_kernel { 0 };
 
@@ -303,6 +313,7 @@ private:
     friend class MemoryManager;
     friend class Scheduler;
     friend class Region;
+    friend class IORingBufferValidator;
 
     Process(String&& name, uid_t, gid_t, pid_t ppid, RingLevel, RefPtr<Custody> cwd = nullptr, RefPtr<Custody> executable = nullptr, TTY* = nullptr, Process* fork_parent = nullptr);
 
@@ -310,6 +321,8 @@ private:
 
     int do_exec(String path, Vector<String> arguments, Vector<String> environment);
     ssize_t do_write(FileDescription&, const u8*, int data_size);
+    ssize_t do_sendto(const Syscall::SC_sendto_params&);
+    ssize_t do_recvfrom(const Syscall::SC_recvfrom_params&);
 
     int alloc_fd(int first_candidate_fd = 0);
     void disown_all_shared_buffers();
@@ -379,6 +392,8 @@ private:
     unsigned m_cow_faults { 0 };
 
     RefPtr<ProcessTracer> m_tracer;
+    RefPtr<ProfileBuffer> m_profile;
+    bool m_profiling { false };
     OwnPtr<ELFLoader> m_elf_loader;
 
     Region* m_master_tls_region { nullptr };
@@ -388,6 +403,7 @@ private:
     Lock m_big_lock { "Process" };
 
     u64 m_alarm_deadline { 0 };
+    u64 m_alarm_timer_id { 0 };
 
     int m_icon_id { -1 };
 };
@@ -0,0 +1,63 @@
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Process.h>
+#include <Kernel/ProfileBuffer.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/VM/MemoryManager.h>
+
+ProfileBuffer::ProfileBuffer()
+    : m_buffer(KBuffer::create_with_size(sizeof(Sample) * max_sample_count))
+{
+}
+
+ProfileBuffer::ProfileBuffer(const KBuffer& buffer, size_t next_index, size_t sample_count, u32 dropped_sample_count)
+    : m_buffer(buffer)
+    , m_next_index(next_index)
+    , m_sample_count(sample_count)
+    , m_dropped_sample_count(dropped_sample_count)
+{
+}
+
+void ProfileBuffer::record_sample(Thread& thread, const RegisterDump& regs)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    auto& sample = samples()[m_next_index];
+    sample.timestamp = g_uptime;
+    sample.tid = thread.tid();
+    sample.frame_count = 0;
+    sample.frames[sample.frame_count++] = regs.eip;
+
+    // We can't take page faults in here, so stop at the first frame that
+    // isn't resident. Neither half of a frame can straddle a page boundary
+    // since the frame pointer is word aligned.
+    auto& process = thread.process();
+    u32 frame_ptr = regs.ebp;
+    while (sample.frame_count < max_stack_depth) {
+        if (!frame_ptr || (frame_ptr & 3) || !MM.is_resident(process, VirtualAddress(frame_ptr)))
+            break;
+        auto* frame = reinterpret_cast<const u32*>(frame_ptr);
+        u32 return_address = frame[1];
+        if (!return_address)
+            break;
+        sample.frames[sample.frame_count++] = return_address;
+        // Stacks grow down, so callers' frames are at higher addresses. The
+        // only exception is the step from a syscall's kernel stack back down
+        // to the userspace stack it was made from.
+        u32 next_frame_ptr = frame[0];
+        bool leaves_kernel_stack = frame_ptr >= 0xc0000000 && next_frame_ptr < 0xc0000000;
+        if (next_frame_ptr <= frame_ptr && !leaves_kernel_stack)
+            break;
+        frame_ptr = next_frame_ptr;
+    }
+
+    m_next_index = (m_next_index + 1) % max_sample_count;
+    if (m_sample_count < max_sample_count)
+        ++m_sample_count;
+    else
+        ++m_dropped_sample_count;
+}
+
+NonnullRefPtr<ProfileBuffer> ProfileBuffer::snapshot() const
+{
+    InterruptDisabler disabler;
+    return adopt(*new ProfileBuffer(KBuffer::copy(m_buffer.data(), m_buffer.size()), m_next_index, m_sample_count, m_dropped_sample_count));
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <AK/RefCounted.h>
+#include <AK/RefPtr.h>
+#include <AK/Types.h>
+#include <Kernel/KBuffer.h>
+
+class Thread;
+struct RegisterDump;
+
+// Stack samples of one process, taken by the timer interrupt whenever it
+// catches one of the process's threads running. This is a ring: once full,
+// each new sample replaces the oldest one.
+// Readers hold a reference, since profiling may be restarted with a fresh
+// buffer while they're looking at the old one.
+class ProfileBuffer : public RefCounted<ProfileBuffer> {
+public:
+    static constexpr size_t max_sample_count = 4096;
+    static constexpr size_t max_stack_depth = 32;
+
+    struct Sample {
+        u32 timestamp { 0 };
+        int tid { 0 };
+        u32 frame_count { 0 };
+        u32 frames[max_stack_depth];
+    };
+
+    static NonnullRefPtr<ProfileBuffer> create() { return adopt(*new ProfileBuffer); }
+
+    // Walks the frame pointer chain of the interrupted context, through the
+    // kernel and on into userspace. Called with interrupts disabled.
+    void record_sample(Thread&, const RegisterDump&);
+
+    // A copy that won't change under us while we're looking at it.
+    NonnullRefPtr<ProfileBuffer> snapshot() const;
+
+    size_t sample_count() const { return m_sample_count; }
+    u32 dropped_sample_count() const { return m_dropped_sample_count; }
+
+    template<typename Callback>
+    void for_each_sample(Callback callback) const
+    {
+        size_t index = (m_next_index + max_sample_count - m_sample_count) % max_sample_count;
+        for (size_t i = 0; i < m_sample_count; ++i) {
+            callback(samples()[index]);
+            index = (index + 1) % max_sample_count;
+        }
+    }
+
+private:
+    ProfileBuffer();
+    ProfileBuffer(const KBuffer&, size_t next_index, size_t sample_count, u32 dropped_sample_count);
+
+    Sample* samples() { return reinterpret_cast<Sample*>(m_buffer.data()); }
+    const Sample* samples() const { return reinterpret_cast<const Sample*>(m_buffer.data()); }
+
+    KBuffer m_buffer;
+    size_t m_next_index { 0 };
+    size_t m_sample_count { 0 };
+    u32 m_dropped_sample_count { 0 };
+};
@@ -0,0 +1,56 @@
+#include <AK/StdLibExtras.h>
+#include <Kernel/RingBuffer.h>
+#include <Kernel/VM/MemoryManager.h>
+
+RingBuffer::RingBuffer(size_t capacity)
+    : m_capacity(capacity)
+{
+    ASSERT(capacity && !(capacity & (capacity - 1)));
+    ASSERT(!(capacity % PAGE_SIZE));
+}
+
+RingBuffer::~RingBuffer()
+{
+}
+
+ssize_t RingBuffer::write(const u8* data, ssize_t size)
+{
+    if (size <= 0)
+        return 0;
+    LOCKER(m_write_lock);
+    if (!m_storage) {
+        m_region = MM.allocate_kernel_region(m_capacity, "RingBuffer");
+        ASSERT(m_region);
+        m_storage = m_region->vaddr().as_ptr();
+    }
+
+    u32 write_offset = m_write_offset.load(AK::memory_order_relaxed);
+    u32 read_offset = m_read_offset.load(AK::memory_order_acquire);
+    size_t nwritten = min((size_t)size, m_capacity - (write_offset - read_offset));
+    size_t start = write_offset & (m_capacity - 1);
+    size_t first_chunk = min(nwritten, m_capacity - start);
+    memcpy(m_storage + start, data, first_chunk);
+    if (nwritten > first_chunk)
+        memcpy(m_storage, data + first_chunk, nwritten - first_chunk);
+    m_write_offset.store(write_offset + nwritten, AK::memory_order_release);
+    return nwritten;
+}
+
+ssize_t RingBuffer::read(u8* data, ssize_t size)
+{
+    if (size <= 0)
+        return 0;
+    LOCKER(m_read_lock);
+    u32 read_offset = m_read_offset.load(AK::memory_order_relaxed);
+    u32 write_offset = m_write_offset.load(AK::memory_order_acquire);
+    size_t nread = min((size_t)size, (size_t)(write_offset - read_offset));
+    if (!nread)
+        return 0;
+    size_t start = read_offset & (m_capacity - 1);
+    size_t first_chunk = min(nread, m_capacity - start);
+    memcpy(data, m_storage + start, first_chunk);
+    if (nread > first_chunk)
+        memcpy(data + first_chunk, m_storage, nread - first_chunk);
+    m_read_offset.store(read_offset + nread, AK::memory_order_release);
+    return nread;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/OwnPtr.h>
+#include <AK/Types.h>
+#include <Kernel/Lock.h>
+
+class Region;
+
+// RingBuffer: Fixed-capacity byte queue backed by kernel pages.
+//
+// The reading and writing sides only communicate through two free-running offsets,
+// so a reader never has to wait for a writer (or vice versa). Multiple writers, or
+// multiple readers, are still serialized amongst themselves by a per-side lock.
+//
+// Storage is allocated on the first write, so idle endpoints don't pin any memory.
+
+class RingBuffer {
+public:
+    // The capacity must be a power of two and a multiple of PAGE_SIZE.
+    explicit RingBuffer(size_t capacity);
+    ~RingBuffer();
+
+    ssize_t write(const u8*, ssize_t);
+    ssize_t read(u8*, ssize_t);
+
+    size_t capacity() const { return m_capacity; }
+    size_t bytes_available() const { return m_write_offset.load(AK::memory_order_acquire) - m_read_offset.load(AK::memory_order_acquire); }
+    size_t space_for_writing() const { return m_capacity - bytes_available(); }
+    bool is_empty() const { return bytes_available() == 0; }
+
+private:
+    size_t m_capacity { 0 };
+    OwnPtr<Region> m_region;
+    u8* m_storage { nullptr };
+    Atomic<u32> m_read_offset { 0 };
+    Atomic<u32> m_write_offset { 0 };
+    Lock m_read_lock { "RingBuffer read" };
+    Lock m_write_lock { "RingBuffer write" };
+};
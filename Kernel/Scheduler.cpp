@@ -1,12 +1,63 @@
 #include <AK/TemporaryChange.h>
+#include <Kernel/Arch/i386/APIC.h>
+#include <Kernel/Arch/i386/PIC.h>
 #include <Kernel/Arch/i386/PIT.h>
 #include <Kernel/Devices/PCSpeaker.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/Process.h>
+#include <Kernel/ProfileBuffer.h>
 #include <Kernel/RTC.h>
 #include <Kernel/Scheduler.h>
+#include <Kernel/TimerQueue.h>
 
 SchedulerData* g_scheduler_data;
+RecursiveSpinLock g_kernel_lock;
+
+// What the scheduler keeps for each processor. Only ever touched by that
+// processor, with the kernel lock held.
+struct ProcessorSchedulerData {
+    Thread* idle_thread { nullptr };
+
+    // The thread we most recently switched away from in context_switch(),
+    // whose state switch_now() still has to save.
+    Thread* outgoing_thread { nullptr };
+
+    // Set when a thread has rewritten its own saved state (exec, signals) and
+    // the next switch away from it must not overwrite that with where it is
+    // right now.
+    bool discard_outgoing_context { false };
+
+    bool active { false };
+    bool tick_stopped { false };
+    bool should_stop_idling { false };
+};
+
+static ProcessorSchedulerData s_processor_data[Processor::max_count];
+
+static ProcessorSchedulerData& local_data()
+{
+    return s_processor_data[Processor::local().index()];
+}
+
+// The processors that have entered the scheduler and may be given threads.
+static u8 s_scheduling_mask = 1;
+static Atomic<bool> s_started;
+
+static u32 run_queue_length(u32 processor_index)
+{
+    u32 length = 0;
+    for (auto& thread : g_scheduler_data->m_runnable_threads[processor_index]) {
+        (void)thread;
+        ++length;
+    }
+    return length;
+}
+
+static bool is_idle(u32 processor_index)
+{
+    auto* thread = Processor::for_index(processor_index).current_thread();
+    return thread && Scheduler::is_idle_thread(*thread) && g_scheduler_data->m_runnable_threads[processor_index].is_empty();
+}
 
 void Scheduler::init_thread(Thread& thread)
 {
@@ -15,12 +66,80 @@ void Scheduler::init_thread(Thread& thread)
 
 void Scheduler::update_state_for_thread(Thread& thread)
 {
-    auto& list = g_scheduler_data->thread_list_for_state(thread.state());
+    ASSERT(g_kernel_lock.is_locked_by_this_processor());
+    auto& list = g_scheduler_data->thread_list_for(thread);
 
     if (list.contains(thread))
         return;
 
-    list.append(thread);
+    if (!Thread::is_runnable_state(thread.state())) {
+        list.append(thread);
+        return;
+    }
+
+    // A running thread is the one this processor is running. Anyone else
+    // just woke up, and goes wherever they'll get to run soonest.
+    u32 local_index = Processor::local().index();
+    u32 index = thread.state() == Thread::Running ? local_index : processor_for_woken_thread(thread);
+    bool should_kick = index != local_index && is_idle(index);
+    thread.m_processor_index = index;
+    g_scheduler_data->m_runnable_threads[index].append(thread);
+    if (should_kick)
+        Processor::for_index(index).send_reschedule_ipi();
+}
+
+// Stay on the processor we last ran on, where some of our working set may
+// still be cached, unless it's busy and another one is idle, or its queue is
+// much longer than another's.
+u32 Scheduler::processor_for_woken_thread(const Thread& thread)
+{
+    u32 previous = thread.m_processor_index;
+    if (!(s_scheduling_mask & (1 << previous)))
+        previous = 0;
+    if (is_idle(previous))
+        return previous;
+
+    u32 best = previous;
+    u32 best_length = run_queue_length(previous);
+    for (u32 i = 0; i < Processor::max_count; ++i) {
+        if (i == previous || !(s_scheduling_mask & (1 << i)))
+            continue;
+        if (is_idle(i))
+            return i;
+        u32 length = run_queue_length(i);
+        if (length + 1 < best_length) {
+            best = i;
+            best_length = length;
+        }
+    }
+    return best;
+}
+
+// Finds a thread waiting to run on whichever other processor has the most of
+// them, for this one to run instead of going idle.
+Thread* Scheduler::steal_runnable_thread()
+{
+    u32 local_index = Processor::local().index();
+    Thread* stolen = nullptr;
+    u32 most_waiting = 0;
+    for (u32 i = 0; i < Processor::max_count; ++i) {
+        if (i == local_index || !(s_scheduling_mask & (1 << i)))
+            continue;
+        Thread* candidate = nullptr;
+        u32 waiting = 0;
+        for (auto& thread : g_scheduler_data->m_runnable_threads[i]) {
+            if (thread.state() != Thread::Runnable || thread.process().is_being_inspected())
+                continue;
+            if (!candidate)
+                candidate = &thread;
+            ++waiting;
+        }
+        if (waiting > most_waiting) {
+            most_waiting = waiting;
+            stolen = candidate;
+        }
+    }
+    return stolen;
 }
 
 //#define LOG_EVERY_CONTEXT_SWITCH
@@ -43,29 +162,150 @@ static u32 time_slice_for(ThreadPriority priority)
     ASSERT_NOT_REACHED();
 }
 
-Thread* current;
-Thread* g_last_fpu_thread;
 Thread* g_finalizer;
 static Process* s_colonel_process;
 u64 g_uptime;
-static u64 s_beep_timeout;
+static u64 s_beep_timer_id;
+
+// Saves the callee-saved registers, stack and a resume point into 'from',
+// then loads 'to'. Returns once someone switches back to 'from'.
+extern "C" void switch_context(TSS32* from, TSS32* to);
+
+// Loads the register state in 'to' and continues there. Ring 3 state is
+// entered through an iret frame on the thread's kernel stack, ring 0 state
+// through one pushed just below its saved stack pointer.
+extern "C" [[noreturn]] void resume_context(TSS32* to);
+
+// Called by resume_context() once it's on the incoming thread's stack, and so
+// done with the outgoing one's. That's the earliest another processor may pick
+// up the outgoing thread, so it's when we hand the kernel lock over to the
+// incoming thread: back to its old hold if it was switched out in the kernel,
+// or let go of entirely if it's headed for userspace.
+extern "C" void finish_context_switch(TSS32* to)
+{
+    u32 depth = (to->cs & 3) ? 0 : current->kernel_lock_depth();
+    g_kernel_lock.set_depth(depth);
+}
 
-struct TaskRedirectionData {
-    u16 selector;
-    TSS32 tss;
-};
-static TaskRedirectionData s_redirection;
-static bool s_active;
+asm(
+    ".globl switch_context \n"
+    "switch_context: \n"
+    "    movl 4(%esp), %eax \n"
+    "    movl 8(%esp), %edx \n"
+    "    movl %ebx, 0x34(%eax) \n"
+    "    movl %esp, 0x38(%eax) \n"
+    "    movl %ebp, 0x3c(%eax) \n"
+    "    movl %esi, 0x40(%eax) \n"
+    "    movl %edi, 0x44(%eax) \n"
+    "    movl $1f, 0x20(%eax) \n"
+    "    pushfl \n"
+    "    popl %ecx \n"
+    "    orl $0x200, %ecx \n" // Like a hardware task switch after sti, resume with interrupts on.
+    "    movl %ecx, 0x24(%eax) \n"
+    "    movw %es, 0x48(%eax) \n"
+    "    movw %cs, 0x4c(%eax) \n"
+    "    movw %ss, 0x50(%eax) \n"
+    "    movw %ds, 0x54(%eax) \n"
+    "    movw %fs, 0x58(%eax) \n"
+    "    movw %gs, 0x5c(%eax) \n"
+    "    movl %edx, %eax \n"
+    "    jmp resume_context_from_eax \n"
+    "1: \n"
+    "    ret \n"
+    "\n"
+    ".globl resume_context \n"
+    "resume_context: \n"
+    "    movl 4(%esp), %eax \n"
+    "resume_context_from_eax: \n"
+    "    movl 0x1c(%eax), %ecx \n"
+    "    movl %cr3, %edx \n"
+    "    cmpl %ecx, %edx \n"
+    "    je 2f \n"
+    "    movl %ecx, %cr3 \n"
+    "2: \n"
+    "    testl $3, 0x4c(%eax) \n"
+    "    jz 3f \n"
+    "    movl 0x04(%eax), %esp \n"
+    "    movzwl 0x50(%eax), %ecx \n"
+    "    pushl %ecx \n"
+    "    pushl 0x38(%eax) \n"
+    "    jmp 4f \n"
+    "3: \n"
+    "    movl 0x38(%eax), %esp \n"
+    "4: \n"
+    "    pushl %eax \n"
+    "    call finish_context_switch \n"
+    "    popl %eax \n"
+    "    pushl 0x24(%eax) \n"
+    "    movzwl 0x4c(%eax), %ecx \n"
+    "    pushl %ecx \n"
+    "    pushl 0x20(%eax) \n"
+    "    movl 0x2c(%eax), %ecx \n"
+    "    movl 0x30(%eax), %edx \n"
+    "    movl 0x34(%eax), %ebx \n"
+    "    movl 0x3c(%eax), %ebp \n"
+    "    movl 0x40(%eax), %esi \n"
+    "    movl 0x44(%eax), %edi \n"
+    "    movw 0x48(%eax), %es \n"
+    "    movw 0x58(%eax), %fs \n"
+    "    movw 0x5c(%eax), %gs \n"
+    "    movw 0x54(%eax), %ds \n"
+    "    movl 0x28(%eax), %eax \n"
+    "    iret \n");
+
+static_assert(__builtin_offsetof(TSS32, esp0) == 0x04);
+static_assert(__builtin_offsetof(TSS32, cr3) == 0x1c);
+static_assert(__builtin_offsetof(TSS32, eip) == 0x20);
+static_assert(__builtin_offsetof(TSS32, eax) == 0x28);
+static_assert(__builtin_offsetof(TSS32, esp) == 0x38);
+static_assert(__builtin_offsetof(TSS32, es) == 0x48);
+static_assert(__builtin_offsetof(TSS32, gs) == 0x5c);
 
 bool Scheduler::is_active()
 {
-    return s_active;
+    return local_data().active;
+}
+
+bool Scheduler::is_idle_thread(const Thread& thread)
+{
+    return &thread.process() == s_colonel_process;
 }
 
 void Scheduler::beep()
 {
+    ScopedSpinLock lock(g_kernel_lock);
     PCSpeaker::tone_on(440);
-    s_beep_timeout = g_uptime + 100;
+    if (s_beep_timer_id)
+        TimerQueue::the().cancel_timer(s_beep_timer_id);
+    s_beep_timer_id = TimerQueue::the().add_timer(PIT::nanoseconds_since_boot() + 100000000, [] {
+        PCSpeaker::tone_off();
+        s_beep_timer_id = 0;
+    });
+}
+
+Thread::Blocker::~Blocker()
+{
+    if (m_wakeup_timer_id)
+        TimerQueue::the().cancel_timer(m_wakeup_timer_id);
+}
+
+void Thread::Blocker::set_wakeup_deadline(u64 deadline)
+{
+    ASSERT(!m_wakeup_timer_id);
+    // Nothing to do when it expires, the timer interrupt runs the scheduler
+    // and should_unblock() takes it from there.
+    m_wakeup_timer_id = TimerQueue::the().add_timer(deadline, nullptr);
+}
+
+void Thread::Blocker::set_wakeup_deadline(const timeval& deadline)
+{
+    timeval now = kgettimeofday();
+    if (deadline.tv_sec < now.tv_sec || (deadline.tv_sec == now.tv_sec && deadline.tv_usec <= now.tv_usec)) {
+        set_wakeup_deadline(PIT::nanoseconds_since_boot());
+        return;
+    }
+    u64 nanoseconds_from_now = (u64)(deadline.tv_sec - now.tv_sec) * 1000000000 + (deadline.tv_usec - now.tv_usec) * 1000;
+    set_wakeup_deadline(PIT::nanoseconds_since_boot() + nanoseconds_from_now);
 }
 
 Thread::JoinBlocker::JoinBlocker(Thread& joinee, void*& joinee_exit_value)
@@ -105,6 +345,9 @@ bool Thread::AcceptBlocker::should_unblock(Thread&, time_t, long)
 Thread::ReceiveBlocker::ReceiveBlocker(const FileDescription& description)
     : FileDescriptionBlocker(description)
 {
+    auto deadline = description.socket()->receive_deadline();
+    if (deadline.tv_sec || deadline.tv_usec)
+        set_wakeup_deadline(deadline);
 }
 
 bool Thread::ReceiveBlocker::should_unblock(Thread&, time_t now_sec, long now_usec)
@@ -164,11 +407,12 @@ bool Thread::ConditionBlocker::should_unblock(Thread&, time_t, long)
 Thread::SleepBlocker::SleepBlocker(u64 wakeup_time)
     : m_wakeup_time(wakeup_time)
 {
+    set_wakeup_deadline(wakeup_time);
 }
 
 bool Thread::SleepBlocker::should_unblock(Thread&, time_t, long)
 {
-    return m_wakeup_time <= g_uptime;
+    return m_wakeup_time <= PIT::nanoseconds_since_boot();
 }
 
 Thread::SelectBlocker::SelectBlocker(const timeval& tv, bool select_has_timeout, const FDVector& read_fds, const FDVector& write_fds, const FDVector& except_fds)
@@ -178,6 +422,8 @@ Thread::SelectBlocker::SelectBlocker(const timeval& tv, bool select_has_timeout,
     , m_select_write_fds(write_fds)
     , m_select_exceptional_fds(except_fds)
 {
+    if (m_select_has_timeout)
+        set_wakeup_deadline(m_select_timeout);
 }
 
 bool Thread::SelectBlocker::should_unblock(Thread& thread, time_t now_sec, long now_usec)
@@ -278,16 +524,19 @@ void Thread::consider_unblock(time_t now_sec, long now_usec)
 bool Scheduler::pick_next()
 {
     ASSERT_INTERRUPTS_DISABLED();
-    ASSERT(!s_active);
+    ASSERT(g_kernel_lock.is_locked_by_this_processor());
+    auto& data = local_data();
+    ASSERT(!data.active);
 
-    TemporaryChange<bool> change(s_active, true);
+    TemporaryChange<bool> change(data.active, true);
 
-    ASSERT(s_active);
+    ASSERT(data.active);
 
+    auto& idle_thread = *data.idle_thread;
     if (!current) {
-        // XXX: The first ever context_switch() goes to the idle process.
+        // XXX: The first ever context_switch() goes to the idle thread.
         //      This to setup a reliable place we can return to.
-        return context_switch(s_colonel_process->main_thread());
+        return context_switch(idle_thread);
     }
 
     struct timeval now;
@@ -327,7 +576,9 @@ bool Scheduler::pick_next()
         // FIXME: It would be nice if the Scheduler didn't have to worry about who is "current"
         //        For now, avoid dispatching signals to "current" and do it in a scheduling pass
         //        while some other process is interrupted. Otherwise a mess will be made.
-        if (&thread == current)
+        //        Threads running on other processors count as "current" too; their
+        //        saved state isn't where they are.
+        if (&thread == current || thread.state() == Thread::Running)
             return IterationDecision::Continue;
         // We know how to interrupt blocked processes, but if they are just executing
         // at some random point in the kernel, let them continue. They'll be in userspace
@@ -366,9 +617,12 @@ bool Scheduler::pick_next()
     });
 #endif
 
-    auto& runnable_list = g_scheduler_data->m_runnable_threads;
-    if (runnable_list.is_empty())
-        return context_switch(s_colonel_process->main_thread());
+    auto& runnable_list = g_scheduler_data->m_runnable_threads[Processor::local().index()];
+    if (runnable_list.is_empty()) {
+        if (auto* thread = steal_runnable_thread())
+            return context_switch(*thread);
+        return context_switch(idle_thread);
+    }
 
     auto* previous_head = runnable_list.first();
     for (;;) {
@@ -384,15 +638,18 @@ bool Scheduler::pick_next()
         }
 
         if (thread == previous_head) {
-            // Back at process_head, nothing wants to run. Send in the colonel!
-            return context_switch(s_colonel_process->main_thread());
+            // Back at process_head, nothing here wants to run. Look elsewhere,
+            // or send in the colonel!
+            if (auto* stolen = steal_runnable_thread())
+                return context_switch(*stolen);
+            return context_switch(idle_thread);
         }
     }
 }
 
 bool Scheduler::donate_to(Thread* beneficiary, const char* reason)
 {
-    InterruptDisabler disabler;
+    ScopedSpinLock lock(g_kernel_lock);
     if (!Thread::is_thread(beneficiary))
         return false;
 
@@ -413,14 +670,14 @@ bool Scheduler::donate_to(Thread* beneficiary, const char* reason)
 
 bool Scheduler::yield()
 {
-    InterruptDisabler disabler;
+    ScopedSpinLock lock(g_kernel_lock);
     ASSERT(current);
     //    dbgprintf("%s(%u:%u) yield()\n", current->process().name().characters(), current->pid(), current->tid());
 
     if (!pick_next())
         return false;
 
-    //    dbgprintf("yield() jumping to new process: sel=%x, %s(%u:%u)\n", current->far_ptr().selector, current->process().name().characters(), current->pid(), current->tid());
+    //    dbgprintf("yield() jumping to new process: %s(%u:%u)\n", current->process().name().characters(), current->pid(), current->tid());
     switch_now();
     return true;
 }
@@ -432,13 +689,41 @@ void Scheduler::pick_next_and_switch_now()
     switch_now();
 }
 
+// Points the processor at the incoming thread's kernel stack and arranges
+// for its FPU state to be swapped in lazily by the first FPU instruction.
+static void prepare_processor_for(Thread& thread)
+{
+    Processor::local().tss().esp0 = thread.tss().esp0;
+
+    if (Processor::local().fpu_owner() == &thread) {
+        asm volatile("clts");
+    } else {
+        asm volatile(
+            "movl %%cr0, %%eax\n"
+            "orl $0x8, %%eax\n"
+            "movl %%eax, %%cr0\n" ::
+                : "%eax", "memory");
+    }
+}
+
 void Scheduler::switch_now()
 {
-    Descriptor& descriptor = get_gdt_entry(current->selector());
-    descriptor.type = 9;
-    flush_gdt();
-    asm("sti\n"
-        "ljmp *(%%eax)\n" ::"a"(&current->far_ptr()));
+    auto& data = local_data();
+    Thread* outgoing = data.outgoing_thread;
+    bool discard_outgoing_context = data.discard_outgoing_context;
+    data.outgoing_thread = nullptr;
+    data.discard_outgoing_context = false;
+
+    if (!outgoing && !discard_outgoing_context)
+        return;
+
+    prepare_processor_for(*current);
+    if (outgoing && !discard_outgoing_context) {
+        outgoing->set_kernel_lock_depth(g_kernel_lock.depth());
+        switch_context(&outgoing->tss(), &current->tss());
+        return;
+    }
+    resume_context(&current->tss());
 }
 
 bool Scheduler::context_switch(Thread& thread)
@@ -455,6 +740,13 @@ bool Scheduler::context_switch(Thread& thread)
         if (current->state() == Thread::Running)
             current->set_state(Thread::Runnable);
 
+        // The next processor to run it may not be this one, so save its FPU
+        // state now instead of when someone else here wants the FPU.
+        if (Processor::count() > 1 && Processor::local().fpu_owner() == current) {
+            asm volatile("fxsave %0"
+                         : "=m"(current->fpu_state()));
+        }
+
 #ifdef LOG_EVERY_CONTEXT_SWITCH
         dbgprintf("Scheduler: %s(%u:%u) -> %s(%u:%u) %w:%x\n",
             current->process().name().characters(), current->process().pid(), current->tid(),
@@ -463,64 +755,32 @@ bool Scheduler::context_switch(Thread& thread)
 #endif
     }
 
+    // Threads picked from another processor's run queue move to ours.
+    u32 local_index = Processor::local().index();
+    if (!is_idle_thread(thread) && thread.m_processor_index != local_index) {
+        thread.m_processor_index = local_index;
+        g_scheduler_data->m_runnable_threads[local_index].append(thread);
+    }
+
+    local_data().outgoing_thread = current;
     current = &thread;
     thread.set_state(Thread::Running);
 
-    if (!thread.selector()) {
-        thread.set_selector(gdt_alloc_entry());
-        auto& descriptor = get_gdt_entry(thread.selector());
-        descriptor.set_base(&thread.tss());
-        descriptor.set_limit(0xffff);
-        descriptor.dpl = 0;
-        descriptor.segment_present = 1;
-        descriptor.granularity = 1;
-        descriptor.zero = 0;
-        descriptor.operation_size = 1;
-        descriptor.descriptor_type = 0;
-    }
-
     if (!thread.thread_specific_data().is_null()) {
         auto& descriptor = thread_specific_descriptor();
         descriptor.set_base(thread.thread_specific_data().as_ptr());
         descriptor.set_limit(sizeof(ThreadSpecificData*));
     }
-
-    auto& descriptor = get_gdt_entry(thread.selector());
-    descriptor.type = 11; // Busy TSS
-    flush_gdt();
     return true;
 }
 
-static void initialize_redirection()
-{
-    auto& descriptor = get_gdt_entry(s_redirection.selector);
-    descriptor.set_base(&s_redirection.tss);
-    descriptor.set_limit(0xffff);
-    descriptor.dpl = 0;
-    descriptor.segment_present = 1;
-    descriptor.granularity = 1;
-    descriptor.zero = 0;
-    descriptor.operation_size = 1;
-    descriptor.descriptor_type = 0;
-    descriptor.type = 9;
-    flush_gdt();
-}
-
-void Scheduler::prepare_for_iret_to_new_process()
-{
-    auto& descriptor = get_gdt_entry(s_redirection.selector);
-    descriptor.type = 9;
-    s_redirection.tss.backlink = current->selector();
-    load_task_register(s_redirection.selector);
-}
-
 void Scheduler::prepare_to_modify_tss(Thread& thread)
 {
     // This ensures that a currently running process modifying its own TSS
     // in order to yield() and end up somewhere else doesn't just end up
     // right after the yield().
     if (current == &thread)
-        load_task_register(s_redirection.selector);
+        local_data().discard_outgoing_context = true;
 }
 
 Process* Scheduler::colonel()
@@ -531,12 +791,85 @@ Process* Scheduler::colonel()
 void Scheduler::initialize()
 {
     g_scheduler_data = new SchedulerData;
-    s_redirection.selector = gdt_alloc_entry();
-    initialize_redirection();
     s_colonel_process = Process::create_kernel_process("colonel", nullptr);
     // Make sure the colonel uses a smallish time slice.
     s_colonel_process->main_thread().set_priority(ThreadPriority::Idle);
-    load_task_register(s_redirection.selector);
+    s_processor_data[0].idle_thread = &s_colonel_process->main_thread();
+
+    // The colonel's other threads idle the application processors. They start
+    // out in idle_loop() on a stack of their own, not holding the kernel lock.
+    Processor::for_each([](Processor& processor) {
+        if (processor.is_bsp())
+            return;
+        auto* idle_thread = new Thread(*s_colonel_process);
+        idle_thread->set_priority(ThreadPriority::Idle);
+        idle_thread->tss().eip = (u32)&Scheduler::idle_loop;
+        idle_thread->set_kernel_lock_depth(0);
+        s_processor_data[processor.index()].idle_thread = idle_thread;
+    });
+
+    // Application processors copy the GDT when they start scheduling, so the
+    // thread-specific descriptor has to be in it by then.
+    thread_specific_selector();
+}
+
+// Turns the boot thread of execution into the bootstrap processor's idle
+// thread, and lets the application processors start picking threads too.
+void Scheduler::start()
+{
+    {
+        ScopedSpinLock lock(g_kernel_lock);
+        pick_next();
+    }
+    s_started.store(true, AK::memory_order_release);
+}
+
+void Scheduler::start_on_application_processor()
+{
+    auto& processor = Processor::local();
+    while (!s_started.load(AK::memory_order_acquire))
+        Processor::wait_for_lock();
+
+    // Without a tick of our own, we couldn't preempt anything we ran.
+    if (!APIC::has_timer())
+        processor.idle_loop();
+
+    // resume_context() hands the lock over to the idle thread, which lets go of it.
+    g_kernel_lock.lock();
+    processor.use_private_gdt();
+    s_scheduling_mask |= 1 << processor.index();
+    pick_next();
+    local_data().outgoing_thread = nullptr;
+    prepare_processor_for(*current);
+    resume_context(&current->tss());
+}
+
+static void update_uptime()
+{
+    // With a high resolution clock, follow it rather than count ticks, so we
+    // catch up on the ticks we skipped while idling without one.
+    if (!PIT::has_high_resolution_clock()) {
+        ++g_uptime;
+    } else {
+        u64 uptime = PIT::nanoseconds_since_boot() / 1000000;
+        if (uptime > g_uptime)
+            g_uptime = uptime;
+    }
+    PIT::update_time_page();
+}
+
+static void restart_tick()
+{
+    auto& data = local_data();
+    if (!data.tick_stopped)
+        return;
+    data.tick_stopped = false;
+    if (!Processor::local().is_bsp()) {
+        APIC::start_tick();
+        return;
+    }
+    update_uptime();
+    PIC::enable(IRQ_TIMER);
 }
 
 void Scheduler::timer_tick(RegisterDump& regs)
@@ -544,21 +877,57 @@ void Scheduler::timer_tick(RegisterDump& regs)
     if (!current)
         return;
 
-    ++g_uptime;
-
-    if (s_beep_timeout && g_uptime > s_beep_timeout) {
-        PCSpeaker::tone_off();
-        s_beep_timeout = 0;
+    // Only the bootstrap processor keeps time; the others tick to preempt.
+    if (Processor::local().is_bsp()) {
+        update_uptime();
+        TimerQueue::the().fire();
     }
 
+    if (current->process().is_profiling())
+        current->process().profile()->record_sample(*current, regs);
+
     if (current->tick())
         return;
 
-    auto& outgoing_tss = current->tss();
+    preempt(regs);
+}
 
-    if (!pick_next())
+void Scheduler::timer_deadline(RegisterDump& regs)
+{
+    restart_tick();
+
+    if (!TimerQueue::the().fire())
+        return;
+
+    if (!current)
         return;
 
+    preempt(regs);
+}
+
+void Scheduler::reschedule(RegisterDump& regs)
+{
+    if (Processor::local().is_bsp())
+        TimerQueue::the().update_hardware_timer();
+
+    if (!current)
+        return;
+    if (is_idle_thread(*current)) {
+        stop_idling();
+        return;
+    }
+    // See Thread::set_should_die().
+    if (current->m_should_die)
+        preempt(regs);
+}
+
+void Scheduler::preempt(RegisterDump& regs)
+{
+    auto& outgoing = *current;
+    auto& outgoing_tss = outgoing.tss();
+
+    // Save the interrupted context up front, so the scheduler sees where the
+    // outgoing thread really is.
     outgoing_tss.gs = regs.gs;
     outgoing_tss.fs = regs.fs;
     outgoing_tss.es = regs.es;
@@ -583,32 +952,95 @@ void Scheduler::timer_tick(RegisterDump& regs)
         outgoing_tss.ss = regs.ss_if_crossRing;
         outgoing_tss.esp = regs.esp_if_crossRing;
     }
-    prepare_for_iret_to_new_process();
 
-    // Set the NT (nested task) flag.
-    asm(
-        "pushf\n"
-        "orl $0x00004000, (%esp)\n"
-        "popf\n");
-}
+    // The interrupt handler that got us here took one more hold on the kernel
+    // lock than the interrupted context had.
+    outgoing.set_kernel_lock_depth(g_kernel_lock.depth() - 1);
 
-static bool s_should_stop_idling = false;
+    // Killed from another processor while running in userspace.
+    if (outgoing.m_should_die && !outgoing.in_kernel() && outgoing.state() == Thread::Running)
+        outgoing.set_state(Thread::Dying);
+
+    if (!pick_next())
+        return;
+
+    // The outgoing state is the interrupted context we just captured, not
+    // wherever we are inside this interrupt handler, so just load the next one.
+    auto& data = local_data();
+    data.outgoing_thread = nullptr;
+    data.discard_outgoing_context = false;
+    prepare_processor_for(*current);
+    resume_context(&current->tss());
+}
 
 void Scheduler::stop_idling()
 {
-    if (current != &s_colonel_process->main_thread())
+    if (!current || !is_idle_thread(*current))
         return;
 
-    s_should_stop_idling = true;
+    local_data().should_stop_idling = true;
 }
 
+// With a one-shot timer for the next deadline, an idle processor doesn't need
+// the periodic tick: nothing can become runnable without an interrupt. The
+// application processors only need theirs to preempt what they run, and get
+// a reschedule IPI when they're given something.
+static void stop_tick_if_possible()
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    auto& processor = Processor::local();
+    if (!APIC::has_timer())
+        return;
+    if (!g_scheduler_data->m_runnable_threads[processor.index()].is_empty())
+        return;
+
+    if (!processor.is_bsp()) {
+        APIC::stop_tick();
+        local_data().tick_stopped = true;
+        return;
+    }
+
+    if (!PIT::has_high_resolution_clock())
+        return;
+
+    bool anyone_else_wants_to_run = false;
+    // Threads skipping scheduler passes need the ticks to become runnable.
+    Scheduler::for_each_nonrunnable([&](Thread& thread) {
+        if (thread.state() != Thread::Skip1SchedulerPass && thread.state() != Thread::Skip0SchedulerPasses)
+            return IterationDecision::Continue;
+        anyone_else_wants_to_run = true;
+        return IterationDecision::Break;
+    });
+    if (anyone_else_wants_to_run)
+        return;
+
+    PIC::disable(IRQ_TIMER);
+    local_data().tick_stopped = true;
+}
+
+// Idle threads run without holding the kernel lock, so other processors can
+// get on with things while this one sleeps.
 void Scheduler::idle_loop()
 {
     for (;;) {
-        asm("hlt");
-        if (s_should_stop_idling) {
-            s_should_stop_idling = false;
-            yield();
+        asm volatile("cli");
+        {
+            ScopedSpinLock lock(g_kernel_lock);
+            stop_tick_if_possible();
         }
+        // sti only takes effect after the next instruction, so an interrupt
+        // can't sneak in before the hlt.
+        asm volatile("sti\n"
+                     "hlt");
+        bool should_stop_idling;
+        {
+            ScopedSpinLock lock(g_kernel_lock);
+            restart_tick();
+            auto& data = local_data();
+            should_stop_idling = data.should_stop_idling;
+            data.should_stop_idling = false;
+        }
+        if (should_stop_idling)
+            yield();
     }
 }
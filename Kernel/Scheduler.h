@@ -4,22 +4,46 @@
 #include <AK/Types.h>
 #include <AK/Function.h>
 #include <AK/IntrusiveList.h>
+#include <Kernel/Arch/i386/Processor.h>
+#include <Kernel/SpinLock.h>
 
 class Process;
 class Thread;
 struct RegisterDump;
 struct SchedulerData;
 
-extern Thread* current;
-extern Thread* g_last_fpu_thread;
+// The thread running on the processor we're executing on.
+#define current (Processor::local().current_thread())
+
 extern Thread* g_finalizer;
 extern u64 g_uptime;
 extern SchedulerData* g_scheduler_data;
 
+// The big kernel lock. A processor holds it whenever it runs kernel code, so
+// the kernel still only ever runs on one processor at a time, and everything
+// it does under an InterruptDisabler stays safe with several processors
+// running threads. Processors drop it when they return to userspace or go
+// idle, and a thread that gets switched out keeps its hold on it until it's
+// switched back in, on whichever processor that happens.
+extern RecursiveSpinLock g_kernel_lock;
+
+// Holds the kernel lock for an entry into the kernel: a syscall, exception or
+// interrupt. Unlike ScopedSpinLock, this leaves interrupts as they were.
+class KernelLocker {
+    AK_MAKE_NONCOPYABLE(KernelLocker)
+public:
+    KernelLocker() { g_kernel_lock.lock(); }
+    ~KernelLocker() { g_kernel_lock.unlock(); }
+};
+
 class Scheduler {
 public:
     static void initialize();
+    static void start();
+    [[noreturn]] static void start_on_application_processor();
     static void timer_tick(RegisterDump&);
+    static void timer_deadline(RegisterDump&);
+    static void reschedule(RegisterDump&);
     static bool pick_next();
     static void pick_next_and_switch_now();
     static void switch_now();
@@ -28,6 +52,7 @@ public:
     static bool context_switch(Thread&);
     static void prepare_to_modify_tss(Thread&);
     static Process* colonel();
+    static bool is_idle_thread(const Thread&);
     static bool is_active();
     static void beep();
     static void idle_loop();
@@ -43,5 +68,7 @@ public:
     static void update_state_for_thread(Thread& thread);
 
 private:
-    static void prepare_for_iret_to_new_process();
+    static void preempt(RegisterDump&);
+    static Thread* steal_runnable_thread();
+    static u32 processor_for_woken_thread(const Thread&);
 };
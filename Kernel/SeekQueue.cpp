@@ -1,81 +1,160 @@
+#include <AK/StdLibExtras.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Arch/i386/PIT.h>
 #include <Kernel/SeekQueue.h>
 #include <Kernel/Thread.h>
 
-void SeekQueue::insert_request(Thread& thread, u32 namespace_id, u16 priority, u32 lbal, u32 lbah, u32 block_count, u16 flags, u8* buf)
-{
-    m_seek_requests.append(new SeekQueueEntry(entry_counter, namespace_id, priority, lbal, lbah, block_count, flags, buf, thread));
-    entry_counter++;
-}
-void SeekQueue::process_request()
-{
-}
-void SeekQueue::wake_one()
-{
-    m_seek_requests.take_first()->get_thread().unblock();
-}
-void SeekQueue::clear_all()
+// How long a request may be passed over by the elevator before it gets
+// serviced regardless of where the head is.
+static const u64 foreground_read_expiry = 500 * 1000000ull;
+static const u64 background_expiry = 5000 * 1000000ull;
+
+static u64 deadline_for(const DiskRequest& request)
 {
-    wake_all();
-    m_seek_requests.clear();
+    bool is_urgent = request.type() == DiskRequest::Type::Read && request.priority() == DiskRequest::Priority::Foreground;
+    return PIT::nanoseconds_since_boot() + (is_urgent ? foreground_read_expiry : background_expiry);
 }
-void SeekQueue::wake_all()
+
+bool DiskRequest::wait()
 {
-    AK::SinglyLinkedList<SeekQueueEntry*>::Iterator iterator = m_seek_requests.begin();
-    while (!iterator.is_end) {
-        SeekQueueEntry* entry = *iterator;
-        if (entry != nullptr) {
-            entry->get_thread().unblock();
-        }
-        ++iterator;
+    while (!m_complete) {
+        (void)current->block_until("DiskIO", [this] {
+            return m_complete;
+        });
     }
+    return m_succeeded;
 }
 
-SeekQueueEntry::SeekQueueEntry(u32 entry_id, u32 namespace_id, u16 priority, u32 lbal, u32 lbah, u32 block_count, u16 flags, u8* buf, Thread& thread)
-    : m_blocked_thread(thread)
-    , m_entry_id(entry_id)
-    , m_namespace_id(namespace_id)
-    , m_priority(priority)
-    , m_lbal(lbal)
-    , m_lbah(lbah)
-    , m_block_count(block_count)
-    , m_flags(flags)
-    , m_buf(buf)
+SeekQueueEntry::SeekQueueEntry(NonnullRefPtr<DiskRequest>&& request, u64 deadline)
+    : m_deadline(deadline)
 {
+    m_requests.append(move(request));
 }
 
-u32 SeekQueueEntry::get_entry_id()
+bool SeekQueueEntry::conflicts_with(const SeekQueueEntry& other) const
 {
-    return m_entry_id;
+    if (type() == DiskRequest::Type::Read && other.type() == DiskRequest::Type::Read)
+        return false;
+    return overlaps(other.block_index(), other.end_block());
 }
-u32 SeekQueueEntry::get_namespace_id()
+
+bool SeekQueueEntry::can_merge(const DiskRequest& request, u32 max_block_count) const
 {
-    return m_namespace_id;
+    if (request.type() != type())
+        return false;
+    if (block_count() + request.block_count() > max_block_count)
+        return false;
+    return request.block_index() == end_block() || request.end_block() == block_index();
 }
-u32 SeekQueueEntry::get_priority()
+
+void SeekQueueEntry::merge(NonnullRefPtr<DiskRequest>&& request, u64 deadline)
 {
-    return m_priority;
+    m_deadline = min(m_deadline, deadline);
+    if (request->end_block() == block_index())
+        m_requests.prepend(move(request));
+    else
+        m_requests.append(move(request));
 }
-u32 SeekQueueEntry::get_lba_low()
+
+u8* SeekQueueEntry::prepare_transfer(u8* bounce_buffer, size_t block_size)
 {
-    return m_lbal;
+    if (m_requests.size() == 1)
+        return m_requests.first().buffer();
+
+    m_bounce_buffer = bounce_buffer;
+    if (type() == DiskRequest::Type::Write) {
+        u8* out = m_bounce_buffer;
+        for (auto& request : m_requests) {
+            memcpy(out, request.buffer(), request.block_count() * block_size);
+            out += request.block_count() * block_size;
+        }
+    }
+    return m_bounce_buffer;
 }
-u32 SeekQueueEntry::get_lba_high()
+
+void SeekQueueEntry::complete(bool success, size_t block_size)
 {
-    return m_lbah;
+    const u8* in = m_bounce_buffer;
+    for (auto& request : m_requests) {
+        if (in && success && type() == DiskRequest::Type::Read)
+            memcpy(request.buffer(), in, request.block_count() * block_size);
+        if (in)
+            in += request.block_count() * block_size;
+        request.complete(success);
+    }
 }
-u32 SeekQueueEntry::get_block_count()
+
+void SeekQueue::enqueue(NonnullRefPtr<DiskRequest>&& request)
 {
-    return m_block_count;
+    InterruptDisabler disabler;
+    u64 deadline = deadline_for(*request);
+
+    // Only merge into a neighbor if nothing else in the queue touches these
+    // blocks, so merging can't reorder a read with respect to a write.
+    SeekQueueEntry* neighbor = nullptr;
+    for (auto& entry : m_entries) {
+        if (entry->overlaps(request->block_index(), request->end_block())) {
+            neighbor = nullptr;
+            break;
+        }
+        if (!neighbor && entry->can_merge(*request, max_merged_blocks))
+            neighbor = entry.ptr();
+    }
+    if (neighbor) {
+        neighbor->merge(move(request), deadline);
+        return;
+    }
+    m_entries.append(make<SeekQueueEntry>(move(request), deadline));
 }
-u16 SeekQueueEntry::get_flags()
+
+bool SeekQueue::is_blocked_by_older_entry(int index) const
 {
-    return m_flags;
+    for (int i = 0; i < index; ++i) {
+        if (m_entries[i]->conflicts_with(*m_entries[index]))
+            return true;
+    }
+    return false;
 }
-u8* SeekQueueEntry::get_io_buffer()
+
+OwnPtr<SeekQueueEntry> SeekQueue::take_next()
 {
-    return m_buf;
+    InterruptDisabler disabler;
+    if (m_entries.is_empty())
+        return nullptr;
+
+    // An entry that conflicts with an older one has to wait its turn.
+    // The oldest entry is never blocked, so nothing waits forever.
+
+    // Anything past its deadline goes first, most overdue first.
+    u64 now = PIT::nanoseconds_since_boot();
+    int chosen = -1;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries[i]->deadline() > now || is_blocked_by_older_entry(i))
+            continue;
+        if (chosen == -1 || m_entries[i]->deadline() < m_entries[chosen]->deadline())
+            chosen = i;
+    }
+
+    // Otherwise, the nearest entry ahead of the head. If there's nothing
+    // ahead, sweep back to the lowest block.
+    if (chosen == -1) {
+        int lowest = -1;
+        for (int i = 0; i < m_entries.size(); ++i) {
+            if (is_blocked_by_older_entry(i))
+                continue;
+            u32 block_index = m_entries[i]->block_index();
+            if (lowest == -1 || block_index < m_entries[lowest]->block_index())
+                lowest = i;
+            if (block_index >= m_head_position && (chosen == -1 || block_index < m_entries[chosen]->block_index()))
+                chosen = i;
+        }
+        if (chosen == -1)
+            chosen = lowest;
+    }
+    ASSERT(chosen != -1);
+
+    auto entry = move(m_entries[chosen]);
+    m_entries.remove(chosen);
+    m_head_position = entry->end_block();
+    return entry;
 }
-Thread& SeekQueueEntry::get_thread()
-{
-    return m_blocked_thread;
-}
\ No newline at end of file
@@ -1,49 +1,126 @@
 #pragma once
 
-#include <AK/SinglyLinkedList.h>
+#include <AK/ByteBuffer.h>
+#include <AK/NonnullRefPtrVector.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
 
-class Thread;
+// A read or write of a contiguous range of device blocks.
+// The buffer must stay alive until the request is complete.
+class DiskRequest : public RefCounted<DiskRequest> {
+public:
+    enum class Type {
+        Read,
+        Write,
+    };
 
-class SeekQueueEntry {
+    // Readahead and writeback are Background: nobody is waiting for them yet,
+    // so they can sit in the queue longer than a read someone is blocked on.
+    enum class Priority {
+        Foreground,
+        Background,
+    };
+
+    static NonnullRefPtr<DiskRequest> create(Type type, u32 block_index, u32 block_count, u8* buffer, Priority priority = Priority::Foreground)
+    {
+        return adopt(*new DiskRequest(type, block_index, block_count, buffer, priority));
+    }
+
+    // For readahead: the request owns its buffer.
+    static NonnullRefPtr<DiskRequest> create_with_buffer(Type type, u32 block_index, u32 block_count, size_t block_size, Priority priority = Priority::Background)
+    {
+        auto request = adopt(*new DiskRequest(type, block_index, block_count, nullptr, priority));
+        request->m_own_buffer = ByteBuffer::create_uninitialized(block_count * block_size);
+        request->m_buffer = request->m_own_buffer.data();
+        return request;
+    }
+
+    Type type() const { return m_type; }
+    Priority priority() const { return m_priority; }
+    u32 block_index() const { return m_block_index; }
+    u32 block_count() const { return m_block_count; }
+    u32 end_block() const { return m_block_index + m_block_count; }
+    u8* buffer() { return m_buffer; }
+
+    bool is_complete() const { return m_complete; }
+    bool succeeded() const { return m_succeeded; }
+
+    // Blocks the current thread until the device is done with this request.
+    bool wait();
+
+private:
+    friend class SeekQueueEntry;
+
+    DiskRequest(Type type, u32 block_index, u32 block_count, u8* buffer, Priority priority)
+        : m_type(type)
+        , m_priority(priority)
+        , m_block_index(block_index)
+        , m_block_count(block_count)
+        , m_buffer(buffer)
+    {
+    }
 
+    void complete(bool success)
+    {
+        m_succeeded = success;
+        m_complete = true;
+    }
+
+    Type m_type { Type::Read };
+    Priority m_priority { Priority::Foreground };
+    u32 m_block_index { 0 };
+    u32 m_block_count { 0 };
+    u8* m_buffer { nullptr };
+    ByteBuffer m_own_buffer;
+    volatile bool m_complete { false };
+    bool m_succeeded { false };
+};
+
+// One transfer as the device sees it: one or more requests of the same type
+// covering a contiguous range of blocks, in block order.
+class SeekQueueEntry {
 public:
-    SeekQueueEntry(u32, u32, u16, u32, u32, u32, u16, u8*, Thread&);
-    ~SeekQueueEntry();
-
-    u32 get_entry_id();
-    u32 get_namespace_id();
-    u32 get_priority();
-    u32 get_lba_low();
-    u32 get_lba_high();
-    u32 get_block_count();
-    u16 get_flags();
-    u8* get_io_buffer();
-    Thread& get_thread();
+    SeekQueueEntry(NonnullRefPtr<DiskRequest>&&, u64 deadline);
+
+    DiskRequest::Type type() const { return m_requests.first().type(); }
+    u32 block_index() const { return m_requests.first().block_index(); }
+    u32 end_block() const { return m_requests.last().end_block(); }
+    u32 block_count() const { return end_block() - block_index(); }
+    u64 deadline() const { return m_deadline; }
+
+    bool overlaps(u32 block_index, u32 end_block) const { return block_index < this->end_block() && this->block_index() < end_block; }
+    bool conflicts_with(const SeekQueueEntry&) const;
+    bool can_merge(const DiskRequest&, u32 max_block_count) const;
+    void merge(NonnullRefPtr<DiskRequest>&&, u64 deadline);
+
+    // A single request is transferred in place. Merged requests go through
+    // the bounce buffer, which must hold block_count() blocks.
+    u8* prepare_transfer(u8* bounce_buffer, size_t block_size);
+    void complete(bool success, size_t block_size);
 
 private:
-    u32 m_entry_id;
-    u32 m_namespace_id;
-    u16 m_priority;
-    u32 m_lbal;
-    u32 m_lbah;
-    u32 m_block_count;
-    u16 m_flags;
-    u8* m_buf;
-    Thread& m_blocked_thread;
+    NonnullRefPtrVector<DiskRequest> m_requests;
+    u8* m_bounce_buffer { nullptr };
+    u64 m_deadline { 0 };
 };
 
+// Per-device queue of pending transfers. Adjacent requests are merged, and
+// transfers are handed out in one-way elevator (C-LOOK) order from the
+// current head position, unless one has been waiting past its deadline.
 class SeekQueue {
 public:
-    SeekQueue();
-    ~SeekQueue();
+    static constexpr u32 max_merged_blocks = 128;
 
-    void insert_request(Thread&, u32 namespace_id, u16 priority, u32 lbal, u32 lbah, u32 block_count, u16 flags, u8* buf);
-    void process_request();
-    void wake_one();
-    void wake_all();
-    void clear_all();
+    bool is_empty() const { return m_entries.is_empty(); }
+    void enqueue(NonnullRefPtr<DiskRequest>&&);
+    OwnPtr<SeekQueueEntry> take_next();
 
 private:
-    u32 entry_counter;
-    SinglyLinkedList<SeekQueueEntry*> m_seek_requests;
-};
\ No newline at end of file
+    bool is_blocked_by_older_entry(int index) const;
+
+    // In arrival order.
+    Vector<NonnullOwnPtr<SeekQueueEntry>> m_entries;
+    u32 m_head_position { 0 };
+};
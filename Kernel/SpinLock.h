@@ -0,0 +1,148 @@
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Noncopyable.h>
+#include <AK/Types.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Arch/i386/Processor.h>
+
+// A busy-waiting lock for data shared between processors.
+// InterruptDisabler only keeps the local processor out, so anything that other
+// processors can touch concurrently needs one of these as well. Never block or
+// take a Lock while holding a SpinLock.
+class SpinLock {
+    AK_MAKE_NONCOPYABLE(SpinLock)
+public:
+    SpinLock() {}
+
+    void lock()
+    {
+        for (;;) {
+            if (!m_lock.exchange(1, AK::memory_order_acquire))
+                return;
+            while (m_lock.load(AK::memory_order_relaxed))
+                Processor::wait_for_lock();
+        }
+    }
+
+    void unlock()
+    {
+        ASSERT(is_locked());
+        m_lock.store(0, AK::memory_order_release);
+    }
+
+    bool is_locked() const { return m_lock.load(AK::memory_order_relaxed); }
+
+private:
+    Atomic<u32> m_lock { 0 };
+};
+
+// A SpinLock that the processor holding it may take again. It's safe to take
+// with interrupts enabled, since an interrupt handler taking it on the same
+// processor always puts it back the way it found it.
+class RecursiveSpinLock {
+    AK_MAKE_NONCOPYABLE(RecursiveSpinLock)
+public:
+    RecursiveSpinLock() {}
+
+    void lock()
+    {
+        InterruptFlagSaver saver;
+        cli();
+        u32 self = Processor::local().index() + 1;
+        if (m_owner.load(AK::memory_order_relaxed) == self) {
+            ++m_depth;
+            return;
+        }
+        for (;;) {
+            u32 expected = 0;
+            if (m_owner.compare_exchange_strong(expected, self, AK::memory_order_acquire))
+                break;
+            while (m_owner.load(AK::memory_order_relaxed))
+                Processor::wait_for_lock();
+        }
+        m_depth = 1;
+    }
+
+    void unlock()
+    {
+        InterruptFlagSaver saver;
+        cli();
+        ASSERT(is_locked_by_this_processor());
+        if (--m_depth == 0)
+            m_owner.store(0, AK::memory_order_release);
+    }
+
+    bool is_locked_by_this_processor() const
+    {
+        return m_owner.load(AK::memory_order_relaxed) == Processor::local().index() + 1;
+    }
+
+    // How many times this processor holds the lock, or 0 if it doesn't.
+    u32 depth() const { return is_locked_by_this_processor() ? m_depth : 0; }
+
+    // Sets how many times this processor holds the lock, releasing it at 0.
+    // Only for the scheduler, which keeps the lock held across a context
+    // switch and then gives the incoming thread the hold it had when it was
+    // switched out.
+    void set_depth(u32 depth)
+    {
+        ASSERT_INTERRUPTS_DISABLED();
+        ASSERT(is_locked_by_this_processor());
+        m_depth = depth;
+        if (!depth)
+            m_owner.store(0, AK::memory_order_release);
+    }
+
+    // Lets go of every hold this processor has, so that whoever we're about
+    // to spin on can get in. Hand the result back to relock() afterwards.
+    u32 unlock_all()
+    {
+        InterruptFlagSaver saver;
+        cli();
+        u32 depth = this->depth();
+        if (depth)
+            set_depth(0);
+        return depth;
+    }
+
+    void relock(u32 depth)
+    {
+        if (!depth)
+            return;
+        InterruptFlagSaver saver;
+        cli();
+        lock();
+        m_depth = depth;
+    }
+
+private:
+    Atomic<u32> m_owner { 0 };
+    u32 m_depth { 0 };
+};
+
+// Holds a spin lock with interrupts disabled on the local processor, so an
+// interrupt handler can't spin on a lock its own processor is holding.
+template<typename LockType>
+class ScopedSpinLock {
+    AK_MAKE_NONCOPYABLE(ScopedSpinLock)
+public:
+    explicit ScopedSpinLock(LockType& lock)
+        : m_lock(lock)
+    {
+        m_flags = cpu_flags();
+        cli();
+        m_lock.lock();
+    }
+
+    ~ScopedSpinLock()
+    {
+        m_lock.unlock();
+        if (m_flags & 0x200)
+            sti();
+    }
+
+private:
+    LockType& m_lock;
+    u32 m_flags { 0 };
+};
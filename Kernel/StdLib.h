@@ -21,3 +21,12 @@ void* memmove(void* dest, const void* src, size_t n);
 inline u16 ntohs(u16 w) { return (w & 0xff) << 8 | ((w >> 8) & 0xff); }
 inline u16 htons(u16 w) { return (w & 0xff) << 8 | ((w >> 8) & 0xff); }
 }
+
+// Picks the fastest memcpy/memset flavor the processor supports.
+void init_memory_routines();
+
+// dest must be page aligned.
+void copy_page(void* dest, const void* src);
+void zero_page(void* dest);
+
+void benchmark_memory_routines();
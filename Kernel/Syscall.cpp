@@ -97,6 +97,7 @@ int handle(RegisterDump& regs, u32 function, u32 arg1, u32 arg2, u32 arg3)
 
 void syscall_trap_entry(RegisterDump regs)
 {
+    KernelLocker locker;
     auto& process = current->process();
 
     if (!MM.validate_user_stack(process, VirtualAddress(regs.esp_if_crossRing))) {
@@ -139,7 +139,11 @@ typedef u32 socklen_t;
     __ENUMERATE_SYSCALL(clock_gettime)          \
     __ENUMERATE_SYSCALL(clock_nanosleep)        \
     __ENUMERATE_SYSCALL(openat)                 \
-    __ENUMERATE_SYSCALL(join_thread)
+    __ENUMERATE_SYSCALL(join_thread)            \
+    __ENUMERATE_SYSCALL(io_ring_enter)          \
+    __ENUMERATE_SYSCALL(profiling_enable)       \
+    __ENUMERATE_SYSCALL(profiling_disable)      \
+    __ENUMERATE_SYSCALL(get_time_page)
 
 namespace Syscall {
 
@@ -1,4 +1,5 @@
 #include <AK/StringBuilder.h>
+#include <Kernel/Arch/i386/PIT.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/Process.h>
 #include <Kernel/Scheduler.h>
@@ -81,6 +82,7 @@ Thread::Thread(Process& process)
         m_kernel_stack_base = (u32)kmalloc_eternal(default_kernel_stack_size);
         m_kernel_stack_top = (m_kernel_stack_base + default_kernel_stack_size) & 0xfffffff8u;
         m_tss.esp = m_kernel_stack_top;
+        m_kernel_lock_depth = 1;
 
     } else {
         // Ring3 processes need a separate stack for Ring0.
@@ -93,10 +95,9 @@ Thread::Thread(Process& process)
 
     // HACK: Ring2 SS in the TSS is the current PID.
     m_tss.ss2 = m_process.pid();
-    m_far_ptr.offset = 0x98765432;
 
     if (m_process.pid() != 0) {
-        InterruptDisabler disabler;
+        ScopedSpinLock lock(g_kernel_lock);
         thread_table().set(this);
         Scheduler::init_thread(*this);
     }
@@ -107,16 +108,14 @@ Thread::~Thread()
     dbgprintf("~Thread{%p}\n", this);
     kfree_aligned(m_fpu_state);
     {
-        InterruptDisabler disabler;
+        ScopedSpinLock lock(g_kernel_lock);
         thread_table().remove(this);
+        Processor::for_each([this](Processor& processor) {
+            if (processor.fpu_owner() == this)
+                processor.fpu_owner() = nullptr;
+        });
     }
 
-    if (g_last_fpu_thread == this)
-        g_last_fpu_thread = nullptr;
-
-    if (selector())
-        gdt_free_entry(selector());
-
     if (m_userspace_stack_region)
         m_process.deallocate_region(*m_userspace_stack_region);
 }
@@ -135,13 +134,18 @@ void Thread::set_should_die()
 {
     if (m_should_die)
         return;
-    InterruptDisabler disabler;
+    ScopedSpinLock lock(g_kernel_lock);
 
     // Remember that we should die instead of returning to
     // the userspace.
     m_should_die = true;
 
-    if (is_blocked()) {
+    if (state() == Thread::Running && current != this) {
+        // We're running on another processor, and our saved state says
+        // nothing about where. Have it switch away from us; if that finds us
+        // in userspace, it'll set us to dying right there.
+        Processor::for_index(m_processor_index).send_reschedule_ipi();
+    } else if (is_blocked()) {
         ASSERT(in_kernel());
         ASSERT(m_blocker != nullptr);
         // We're blocked in the kernel. Pretend to have
@@ -165,7 +169,7 @@ void Thread::die_if_needed()
     if (!m_should_die)
         return;
 
-    InterruptDisabler disabler;
+    ScopedSpinLock lock(g_kernel_lock);
     set_state(Thread::State::Dying);
     if (!Scheduler::is_active())
         Scheduler::pick_next_and_switch_now();
@@ -179,12 +183,12 @@ void Thread::yield_without_holding_big_lock()
         process().big_lock().lock();
 }
 
-u64 Thread::sleep(u32 ticks)
+u64 Thread::sleep(u64 nanoseconds)
 {
     ASSERT(state() == Thread::Running);
-    u64 wakeup_time = g_uptime + ticks;
+    u64 wakeup_time = PIT::nanoseconds_since_boot() + nanoseconds;
     auto ret = current->block<Thread::SleepBlocker>(wakeup_time);
-    if (wakeup_time > g_uptime) {
+    if (wakeup_time > PIT::nanoseconds_since_boot()) {
         ASSERT(ret == Thread::BlockResult::InterruptedBySignal);
     }
     return wakeup_time;
@@ -194,7 +198,7 @@ u64 Thread::sleep_until(u64 wakeup_time)
 {
     ASSERT(state() == Thread::Running);
     auto ret = current->block<Thread::SleepBlocker>(wakeup_time);
-    if (wakeup_time > g_uptime)
+    if (wakeup_time > PIT::nanoseconds_since_boot())
         ASSERT(ret == Thread::BlockResult::InterruptedBySignal);
     return wakeup_time;
 }
@@ -258,7 +262,7 @@ void Thread::finalize_dying_threads()
     ASSERT(current == g_finalizer);
     Vector<Thread*, 32> dying_threads;
     {
-        InterruptDisabler disabler;
+        ScopedSpinLock lock(g_kernel_lock);
         for_each_in_state(Thread::State::Dying, [&](Thread& thread) {
             dying_threads.append(&thread);
             return IterationDecision::Continue;
@@ -281,7 +285,7 @@ bool Thread::tick()
 void Thread::send_signal(u8 signal, Process* sender)
 {
     ASSERT(signal < 32);
-    InterruptDisabler disabler;
+    ScopedSpinLock lock(g_kernel_lock);
 
     // FIXME: Figure out what to do for masked signals. Should we also ignore them here?
     if (should_ignore_signal(signal)) {
@@ -620,7 +624,7 @@ void Thread::initialize()
 Vector<Thread*> Thread::all_threads()
 {
     Vector<Thread*> threads;
-    InterruptDisabler disabler;
+    ScopedSpinLock lock(g_kernel_lock);
     threads.ensure_capacity(thread_table().size());
     for (auto* thread : thread_table())
         threads.unchecked_append(thread);
@@ -635,7 +639,7 @@ bool Thread::is_thread(void* ptr)
 
 void Thread::set_state(State new_state)
 {
-    InterruptDisabler disabler;
+    ScopedSpinLock lock(g_kernel_lock);
     if (new_state == Blocked) {
         // we should always have a Blocker while blocked
         ASSERT(m_blocker != nullptr);
@@ -672,10 +676,13 @@ String Thread::backtrace_impl() const
         if (!symbol.address)
             break;
         if (!symbol.ksym) {
-            if (!Scheduler::is_active() && process.elf_loader() && process.elf_loader()->has_symbols())
-                builder.appendf("%p  %s\n", symbol.address, process.elf_loader()->symbolicate(symbol.address).characters());
-            else
+            String name;
+            if (!Scheduler::is_active())
+                name = symbolicate(process, symbol.address);
+            if (name.is_empty())
                 builder.appendf("%p\n", symbol.address);
+            else
+                builder.appendf("%p  %s\n", symbol.address, name.characters());
             continue;
         }
         unsigned offset = symbol.address - symbol.ksym->address;
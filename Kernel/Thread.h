@@ -87,14 +87,21 @@ public:
 
     class Blocker {
     public:
-        virtual ~Blocker() {}
+        virtual ~Blocker();
         virtual bool should_unblock(Thread&, time_t now_s, long us) = 0;
         virtual const char* state_string() const = 0;
         void set_interrupted_by_signal() { m_was_interrupted_while_blocked = true; }
         bool was_interrupted_by_signal() const { return m_was_interrupted_while_blocked; }
 
+    protected:
+        // Makes sure the scheduler runs at the given time, so should_unblock()
+        // gets a chance to notice a timeout even if the processor is idle.
+        void set_wakeup_deadline(u64 nanoseconds_since_boot);
+        void set_wakeup_deadline(const timeval&);
+
     private:
         bool m_was_interrupted_while_blocked { false };
+        u64 m_wakeup_timer_id { 0 };
         friend class Thread;
     };
 
@@ -169,6 +176,7 @@ public:
 
     class SleepBlocker final : public Blocker {
     public:
+        // The wakeup time is on the PIT::nanoseconds_since_boot() clock.
         explicit SleepBlocker(u64 wakeup_time);
         virtual bool should_unblock(Thread&, time_t, long) override;
         virtual const char* state_string() const override { return "Sleeping"; }
@@ -232,6 +240,7 @@ public:
 
     bool is_stopped() const { return m_state == Stopped; }
     bool is_blocked() const { return m_state == Blocked; }
+    bool has_blocker() const { return m_blocker; }
     bool in_kernel() const { return (m_tss.cs & 0x03) == 0; }
 
     u32 frame_ptr() const { return m_tss.ebp; }
@@ -239,7 +248,6 @@ public:
 
     RegisterDump& get_RegisterDump_from_stack();
 
-    u16 selector() const { return m_far_ptr.selector; }
     TSS32& tss() { return m_tss; }
     const TSS32& tss() const { return m_tss; }
     State state() const { return m_state; }
@@ -248,7 +256,9 @@ public:
 
     VirtualAddress thread_specific_data() const { return m_thread_specific_data; }
 
-    u64 sleep(u32 ticks);
+    // Both return the wakeup time in nanoseconds since boot. If that's still in
+    // the future when they return, the sleep was interrupted by a signal.
+    u64 sleep(u64 nanoseconds);
     u64 sleep_until(u64 wakeup_time);
 
     enum class BlockResult {
@@ -296,16 +306,16 @@ public:
     void set_should_die();
     void die_if_needed();
 
-    const FarPtr& far_ptr() const { return m_far_ptr; }
-
     bool tick();
     void set_ticks_left(u32 t) { m_ticks_left = t; }
     u32 ticks_left() const { return m_ticks_left; }
 
+    u32 kernel_lock_depth() const { return m_kernel_lock_depth; }
+    void set_kernel_lock_depth(u32 depth) { m_kernel_lock_depth = depth; }
+
     u32 kernel_stack_base() const { return m_kernel_stack_base; }
     u32 kernel_stack_top() const { return m_kernel_stack_top; }
 
-    void set_selector(u16 s) { m_far_ptr.selector = s; }
     void set_state(State);
 
     void send_urgent_signal_to_self(u8 signal);
@@ -357,7 +367,6 @@ private:
     Process& m_process;
     int m_tid { -1 };
     TSS32 m_tss;
-    FarPtr m_far_ptr;
     u32 m_ticks { 0 };
     u32 m_ticks_left { 0 };
     u32 m_times_scheduled { 0 };
@@ -383,6 +392,13 @@ private:
     bool m_dump_backtrace_on_finalization { false };
     bool m_should_die { false };
 
+    // The processor whose run queue we're on, or were last on.
+    u32 m_processor_index { 0 };
+
+    // How many times we held g_kernel_lock when we were last switched out.
+    // Ring 0 threads start out in the kernel, holding it.
+    u32 m_kernel_lock_depth { 0 };
+
     void yield_without_holding_big_lock();
 };
 
@@ -428,13 +444,15 @@ const LogStream& operator<<(const LogStream&, const Thread&);
 struct SchedulerData {
     typedef IntrusiveList<Thread, &Thread::m_runnable_list_node> ThreadList;
 
-    ThreadList m_runnable_threads;
+    // Every processor has its own run queue, which also holds the thread it's
+    // running right now (unless that's its idle thread).
+    ThreadList m_runnable_threads[Processor::max_count];
     ThreadList m_nonrunnable_threads;
 
-    ThreadList& thread_list_for_state(Thread::State state)
+    ThreadList& thread_list_for(const Thread& thread)
     {
-        if (Thread::is_runnable_state(state))
-            return m_runnable_threads;
+        if (Thread::is_runnable_state(thread.state()))
+            return m_runnable_threads[thread.m_processor_index];
         return m_nonrunnable_threads;
     }
 };
@@ -443,12 +461,13 @@ template<typename Callback>
 inline IterationDecision Scheduler::for_each_runnable(Callback callback)
 {
     ASSERT_INTERRUPTS_DISABLED();
-    auto& tl = g_scheduler_data->m_runnable_threads;
-    for (auto it = tl.begin(); it != tl.end();) {
-        auto& thread = *it;
-        it = ++it;
-        if (callback(thread) == IterationDecision::Break)
-            return IterationDecision::Break;
+    for (auto& tl : g_scheduler_data->m_runnable_threads) {
+        for (auto it = tl.begin(); it != tl.end();) {
+            auto& thread = *it;
+            it = ++it;
+            if (callback(thread) == IterationDecision::Break)
+                return IterationDecision::Break;
+        }
     }
 
     return IterationDecision::Continue;
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <AK/Types.h>
+
+// A page the kernel maps read-only into every process, so that LibC can tell
+// the time without making a syscall. Get its address with SC_get_time_page.
+//
+// The kernel bumps `sequence` before and after every update, so it is odd
+// while an update is in progress. Readers copy the fields out and retry if
+// `sequence` was odd or changed underneath them.
+struct TimePage {
+    volatile u32 sequence;
+
+    // Seconds since the epoch at boot, according to the RTC.
+    u32 boot_time;
+
+    // Monotonic time since boot, updated on every timer tick.
+    u64 uptime_ms;
+
+    // When tsc_ticks_per_ms is non-zero, the TSC has been calibrated and
+    // time since boot is (rdtsc - boot_tsc) / tsc_ticks_per_ms milliseconds.
+    u64 boot_tsc;
+    u64 tsc_ticks_per_ms;
+};
@@ -0,0 +1,83 @@
+#include <Kernel/Arch/i386/APIC.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Arch/i386/PIT.h>
+#include <Kernel/Arch/i386/Processor.h>
+#include <Kernel/TimerQueue.h>
+
+TimerQueue& TimerQueue::the()
+{
+    static TimerQueue* the;
+    if (!the)
+        the = new TimerQueue;
+    return *the;
+}
+
+u64 TimerQueue::add_timer(u64 deadline, Function<void()>&& callback)
+{
+    InterruptDisabler disabler;
+    auto timer = make<Timer>();
+    timer->id = m_next_id++;
+    timer->deadline = deadline;
+    timer->callback = move(callback);
+    u64 id = timer->id;
+
+    int index = 0;
+    while (index < m_timers.size() && m_timers[index]->deadline <= deadline)
+        ++index;
+    m_timers.insert(index, move(timer));
+
+    if (index == 0)
+        update_hardware_timer();
+    return id;
+}
+
+bool TimerQueue::cancel_timer(u64 id)
+{
+    InterruptDisabler disabler;
+    for (int i = 0; i < m_timers.size(); ++i) {
+        if (m_timers[i]->id != id)
+            continue;
+        m_timers.remove(i);
+        if (i == 0)
+            update_hardware_timer();
+        return true;
+    }
+    return false;
+}
+
+bool TimerQueue::fire()
+{
+    InterruptDisabler disabler;
+    if (m_timers.is_empty())
+        return false;
+
+    bool fired = false;
+    u64 now = PIT::nanoseconds_since_boot();
+    while (!m_timers.is_empty() && m_timers.first()->deadline <= now) {
+        auto timer = m_timers.take_first();
+        if (timer->callback)
+            timer->callback();
+        fired = true;
+    }
+
+    update_hardware_timer();
+    return fired;
+}
+
+void TimerQueue::update_hardware_timer()
+{
+    if (!APIC::has_timer())
+        return;
+    auto& bsp = Processor::for_index(0);
+    if (&Processor::local() != &bsp) {
+        bsp.send_reschedule_ipi();
+        return;
+    }
+    if (m_timers.is_empty()) {
+        APIC::disarm_timer();
+        return;
+    }
+    u64 now = PIT::nanoseconds_since_boot();
+    u64 deadline = m_timers.first()->deadline;
+    APIC::arm_timer(deadline > now ? deadline - now : 0);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+// Deadlines on the monotonic clock (PIT::nanoseconds_since_boot()), kept in
+// expiry order. The earliest one is programmed into the bootstrap processor's
+// local APIC timer as a one-shot, so we wake up when it's due instead of on
+// the next 1 ms tick. The other processors use their APIC timers as their tick.
+class TimerQueue {
+public:
+    static TimerQueue& the();
+
+    // The callback runs in interrupt context.
+    u64 add_timer(u64 deadline, Function<void()>&& callback);
+    bool cancel_timer(u64 id);
+
+    // Runs the callbacks of all expired timers and rearms the hardware timer
+    // for the next one. Returns true if anything expired.
+    bool fire();
+
+    // Programs the hardware timer for the earliest deadline. On any other
+    // processor than the bootstrap processor, this asks it to do that.
+    void update_hardware_timer();
+
+    bool is_empty() const { return m_timers.is_empty(); }
+    u64 next_deadline() const { return m_timers.is_empty() ? 0 : m_timers.first()->deadline; }
+
+private:
+    struct Timer {
+        u64 id { 0 };
+        u64 deadline { 0 };
+        Function<void()> callback;
+    };
+
+    TimerQueue() {}
+
+    u64 m_next_id { 1 };
+    Vector<NonnullOwnPtr<Timer>> m_timers;
+};
@@ -369,6 +369,43 @@ struct sockaddr_in {
     char sin_zero[8];
 };
 
+#define IORING_OP_NOP 0
+#define IORING_OP_READ 1
+#define IORING_OP_WRITE 2
+#define IORING_OP_SENDTO 3
+#define IORING_OP_RECVFROM 4
+#define IORING_OP_POLL 5
+
+struct io_ring {
+    u32 submission_head;
+    u32 submission_tail;
+    u32 completion_head;
+    u32 completion_tail;
+    u32 entry_count;
+};
+
+struct io_ring_submission {
+    u32 opcode;
+    u32 user_data;
+    int fd;
+    void* buffer;
+    size_t length;
+    int flags;
+    sockaddr* addr;
+    union {
+        socklen_t addr_length;
+        socklen_t* addr_length_ptr;
+    };
+    pollfd poll;
+    int timeout;
+};
+
+struct io_ring_completion {
+    u32 user_data;
+    i32 result;
+    u32 flags;
+};
+
 typedef u32 __u32;
 typedef u16 __u16;
 typedef u8 __u8;
@@ -4,6 +4,7 @@
 #include <AK/Assertions.h>
 #include <AK/kstdio.h>
 #include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Arch/i386/Processor.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/Multiboot.h>
 #include <Kernel/VM/AnonymousVMObject.h>
@@ -330,7 +331,7 @@ PageFaultResponse MemoryManager::handle_page_fault(const PageFault& fault)
         if (kernel_pde.is_present() && !current_pde.is_present()) {
             dbg() << "NP(kernel): Copying new kernel mapping for " << fault.vaddr() << " into current page directory";
             current_pde.copy_from({}, kernel_pde);
-            flush_tlb(fault.vaddr().page_base());
+            flush_tlb_local(fault.vaddr().page_base());
             return PageFaultResponse::Continue;
         }
     }
@@ -417,8 +418,7 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
 #endif
 
     if (should_zero_fill == ShouldZeroFill::Yes) {
-        auto* ptr = (u32*)quickmap_page(*page);
-        fast_u32_fill(ptr, 0, PAGE_SIZE / sizeof(u32));
+        zero_page(quickmap_page(*page));
         unquickmap_page();
     }
 
@@ -445,6 +445,28 @@ void MemoryManager::deallocate_supervisor_physical_page(PhysicalPage&& page)
     ASSERT_NOT_REACHED();
 }
 
+NonnullRefPtrVector<PhysicalPage> MemoryManager::allocate_contiguous_supervisor_physical_pages(unsigned count)
+{
+    InterruptDisabler disabler;
+    NonnullRefPtrVector<PhysicalPage> pages;
+
+    for (auto& region : m_super_physical_regions) {
+        pages = region.take_contiguous_free_pages(count, true);
+        if (!pages.is_empty())
+            break;
+    }
+
+    if (pages.is_empty()) {
+        kprintf("MM: no %u contiguous super physical pages available\n", count);
+        return pages;
+    }
+
+    for (auto& page : pages)
+        zero_page(page.paddr().as_ptr());
+    m_super_physical_pages_used += count;
+    return pages;
+}
+
 RefPtr<PhysicalPage> MemoryManager::allocate_supervisor_physical_page()
 {
     InterruptDisabler disabler;
@@ -470,7 +492,7 @@ RefPtr<PhysicalPage> MemoryManager::allocate_supervisor_physical_page()
     dbgprintf("MM: allocate_supervisor_physical_page vending P%p\n", page->paddr().get());
 #endif
 
-    fast_u32_fill((u32*)page->paddr().as_ptr(), 0, PAGE_SIZE / sizeof(u32));
+    zero_page(page->paddr().as_ptr());
     ++m_super_physical_pages_used;
     return page;
 }
@@ -490,9 +512,11 @@ void MemoryManager::flush_entire_tlb()
         "mov %%cr3, %%eax\n"
         "mov %%eax, %%cr3\n" ::
             : "%eax", "memory");
+    if (Processor::count() > 1)
+        Processor::flush_entire_tlb_on_other_processors();
 }
 
-void MemoryManager::flush_tlb(VirtualAddress vaddr)
+void MemoryManager::flush_tlb_local(VirtualAddress vaddr)
 {
     asm volatile("invlpg %0"
                  :
@@ -500,6 +524,13 @@ void MemoryManager::flush_tlb(VirtualAddress vaddr)
                  : "memory");
 }
 
+void MemoryManager::flush_tlb(VirtualAddress vaddr)
+{
+    flush_tlb_local(vaddr);
+    if (Processor::count() > 1)
+        Processor::flush_tlb_on_other_processors(vaddr);
+}
+
 void MemoryManager::map_for_kernel(VirtualAddress vaddr, PhysicalAddress paddr, bool cache_disabled)
 {
     auto& pte = ensure_pte(kernel_page_directory(), vaddr);
@@ -522,7 +553,8 @@ u8* MemoryManager::quickmap_page(PhysicalPage& physical_page)
     pte.set_present(true);
     pte.set_writable(true);
     pte.set_user_allowed(false);
-    flush_tlb(page_vaddr);
+    // The quickmap slot is only ever touched by whoever holds it, with interrupts disabled.
+    flush_tlb_local(page_vaddr);
     ASSERT((u32)pte.physical_page_base() == physical_page.paddr().get());
 #ifdef MM_DEBUG
     dbg() << "MM: >> quickmap_page " << page_vaddr << " => " << physical_page.paddr() << " @ PTE=" << (void*)pte.raw() << " {" << &pte << "}";
@@ -542,7 +574,7 @@ void MemoryManager::unquickmap_page()
     pte.set_physical_page_base(0);
     pte.set_present(false);
     pte.set_writable(false);
-    flush_tlb(page_vaddr);
+    flush_tlb_local(page_vaddr);
 #ifdef MM_DEBUG
     dbg() << "MM: >> unquickmap_page " << page_vaddr << " =/> " << old_physical_address;
 #endif
@@ -567,6 +599,17 @@ bool MemoryManager::validate_user_write(const Process& process, VirtualAddress v
     return region && region->is_writable();
 }
 
+bool MemoryManager::is_resident(Process& process, VirtualAddress vaddr)
+{
+    u32 page_directory_index = (vaddr.get() >> 22) & 0x3ff;
+    u32 page_table_index = (vaddr.get() >> 12) & 0x3ff;
+
+    auto& pde = process.page_directory().entries()[page_directory_index];
+    if (!pde.is_present())
+        return false;
+    return pde.page_table_base()[page_table_index].is_present();
+}
+
 void MemoryManager::register_vmo(VMObject& vmo)
 {
     InterruptDisabler disabler;
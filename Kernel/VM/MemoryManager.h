@@ -50,6 +50,10 @@ public:
     bool validate_user_read(const Process&, VirtualAddress) const;
     bool validate_user_write(const Process&, VirtualAddress) const;
 
+    // Whether the page is mapped in the process's page directory right now,
+    // i.e. reading from it won't fault. Safe to use from interrupt handlers.
+    bool is_resident(Process&, VirtualAddress);
+
     enum class ShouldZeroFill {
         No,
         Yes
@@ -57,6 +61,9 @@ public:
 
     RefPtr<PhysicalPage> allocate_user_physical_page(ShouldZeroFill);
     RefPtr<PhysicalPage> allocate_supervisor_physical_page();
+    // For device DMA: a physically contiguous, zeroed run of pages aligned to
+    // its own size. The count must be a power of two.
+    NonnullRefPtrVector<PhysicalPage> allocate_contiguous_supervisor_physical_pages(unsigned count);
     void deallocate_user_physical_page(PhysicalPage&&);
     void deallocate_supervisor_physical_page(PhysicalPage&&);
 
@@ -91,6 +98,7 @@ private:
     void initialize_paging();
     void flush_entire_tlb();
     void flush_tlb(VirtualAddress);
+    void flush_tlb_local(VirtualAddress);
 
     void map_protected(VirtualAddress, size_t length);
 
@@ -67,6 +67,42 @@ RefPtr<PhysicalPage> PhysicalRegion::take_free_page(bool supervisor)
     return nullptr;
 }
 
+NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(unsigned count, bool supervisor)
+{
+    ASSERT(m_pages);
+    ASSERT(count && !(count & (count - 1)));
+
+    NonnullRefPtrVector<PhysicalPage> pages;
+    if (m_pages - m_used < count)
+        return pages;
+
+    // Align the run to its own size in physical memory, so that e.g. an ISA
+    // DMA buffer never straddles a 64 KB boundary.
+    u32 alignment = count * PAGE_SIZE;
+    unsigned first = (((m_lower.get() + alignment - 1) & ~(alignment - 1)) - m_lower.get()) / PAGE_SIZE;
+    for (unsigned start = first; start + count <= m_pages; start += count) {
+        bool all_free = true;
+        for (unsigned page = start; page < start + count; ++page) {
+            if (m_bitmap.get(page)) {
+                all_free = false;
+                break;
+            }
+        }
+        if (!all_free)
+            continue;
+
+        pages.ensure_capacity(count);
+        for (unsigned page = start; page < start + count; ++page) {
+            m_bitmap.set(page, true);
+            pages.append(PhysicalPage::create(m_lower.offset(page * PAGE_SIZE), supervisor));
+        }
+        m_used += count;
+        return pages;
+    }
+
+    return pages;
+}
+
 void PhysicalRegion::return_page_at(PhysicalAddress addr)
 {
     ASSERT(m_pages);
@@ -3,6 +3,7 @@
 #include <AK/Bitmap.h>
 #include <AK/RefCounted.h>
 #include <AK/NonnullRefPtr.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <Kernel/VM/PhysicalPage.h>
 
 class PhysicalRegion : public RefCounted<PhysicalRegion> {
@@ -23,6 +24,7 @@ public:
     bool contains(PhysicalPage& page) const { return page.paddr() >= m_lower && page.paddr() <= m_upper; }
 
     RefPtr<PhysicalPage> take_free_page(bool supervisor);
+    NonnullRefPtrVector<PhysicalPage> take_contiguous_free_pages(unsigned count, bool supervisor);
     void return_page_at(PhysicalAddress addr);
     void return_page(PhysicalPage&& page) { return_page_at(page.paddr()); }
 
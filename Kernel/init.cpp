@@ -9,6 +9,7 @@
 #include <Kernel/Arch/i386/APIC.h>
 #include <Kernel/Arch/i386/PIC.h>
 #include <Kernel/Arch/i386/PIT.h>
+#include <Kernel/Arch/i386/Processor.h>
 #include <Kernel/CMOS.h>
 #include <Kernel/Devices/BXVGADevice.h>
 #include <Kernel/Devices/DebugLogDevice.h>
@@ -61,6 +62,9 @@ VFS* vfs;
 {
     Syscall::initialize();
 
+    if (KParams::the().has("memory_benchmark"))
+        benchmark_memory_routines();
+
     auto dev_zero = make<ZeroDevice>();
     auto dev_full = make<FullDevice>();
     auto dev_random = make<RandomDevice>();
@@ -79,6 +83,8 @@ VFS* vfs;
         hang();
     }
 
+    Process::create_kernel_process("DiskIO", DiskDevice::io_task_main);
+
     auto pata0 = PATAChannel::create(PATAChannel::ChannelType::Primary, force_pio);
     NonnullRefPtr<DiskDevice> root_dev = *pata0->master_device();
 
@@ -232,6 +238,7 @@ extern "C" [[noreturn]] void init(u32 physical_address_for_kernel_page_tables)
         set_serial_debug(true);
 
     sse_init();
+    init_memory_routines();
 
     kmalloc_init();
     slab_alloc_init();
@@ -274,10 +281,16 @@ extern "C" [[noreturn]] void init(u32 physical_address_for_kernel_page_tables)
 
     MemoryManager::initialize(physical_address_for_kernel_page_tables);
 
-    if (APIC::init())
+    bool has_apic = APIC::init();
+    if (has_apic)
         APIC::enable(0);
+    Processor::initialize_bsp();
+    if (has_apic)
+        APIC::boot_application_processors();
 
     PIT::initialize();
+    if (has_apic)
+        APIC::calibrate_timer();
 
     PCI::enumerate_all([](const PCI::Address& address, PCI::ID id) {
         kprintf("PCI device: bus=%d slot=%d function=%d id=%w:%w\n",
@@ -311,8 +324,8 @@ extern "C" [[noreturn]] void init(u32 physical_address_for_kernel_page_tables)
     Process::create_kernel_process("init_stage2", init_stage2);
     Process::create_kernel_process("syncd", [] {
         for (;;) {
-            VFS::the().sync();
-            current->sleep(1 * TICKS_PER_SECOND);
+            VFS::the().start_sync();
+            current->sleep(1000000000);
         }
     });
     Process::create_kernel_process("Finalizer", [] {
@@ -324,10 +337,25 @@ extern "C" [[noreturn]] void init(u32 physical_address_for_kernel_page_tables)
         }
     });
 
-    Scheduler::pick_next();
+    Scheduler::start();
 
     sti();
 
     Scheduler::idle_loop();
     ASSERT_NOT_REACHED();
 }
+
+// Application processors arrive here from the APIC trampoline, already in
+// protected mode with paging enabled and on their own stack.
+extern "C" [[noreturn]] void init_ap(u32 cpu)
+{
+    flush_gdt();
+    flush_idt();
+    sse_init();
+
+    auto& processor = Processor::initialize_ap(cpu);
+    APIC::enable(cpu);
+    processor.set_online();
+
+    Scheduler::start_on_application_processor();
+}
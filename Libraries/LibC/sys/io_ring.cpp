@@ -0,0 +1,12 @@
+#include <Kernel/Syscall.h>
+#include <errno.h>
+#include <sys/io_ring.h>
+
+extern "C" {
+
+int io_ring_enter(struct io_ring* ring, int to_submit)
+{
+    int rc = syscall(SC_io_ring_enter, ring, to_submit);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <poll.h>
+#include <sys/cdefs.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+#define IORING_OP_NOP 0
+#define IORING_OP_READ 1
+#define IORING_OP_WRITE 2
+#define IORING_OP_SENDTO 3
+#define IORING_OP_RECVFROM 4
+#define IORING_OP_POLL 5
+
+// A submission ring shared between userspace and the kernel.
+// The header is followed by entry_count submissions, then entry_count completions.
+// Userspace advances submission_tail and completion_head, the kernel advances
+// submission_head and completion_tail. entry_count must be a power of two.
+struct io_ring {
+    unsigned submission_head;
+    unsigned submission_tail;
+    unsigned completion_head;
+    unsigned completion_tail;
+    unsigned entry_count;
+};
+
+struct io_ring_submission {
+    unsigned opcode;
+    unsigned user_data;
+    int fd;
+    void* buffer;
+    size_t length;
+    int flags;
+    struct sockaddr* addr;
+    union {
+        socklen_t addr_length;
+        socklen_t* addr_length_ptr;
+    };
+    struct pollfd poll;
+    int timeout;
+};
+
+struct io_ring_completion {
+    unsigned user_data;
+    int result;
+    unsigned flags;
+};
+
+#define IO_RING_SIZE(entry_count) \
+    (sizeof(struct io_ring) + (entry_count) * (sizeof(struct io_ring_submission) + sizeof(struct io_ring_completion)))
+
+static inline struct io_ring_submission* io_ring_submissions(struct io_ring* ring)
+{
+    return (struct io_ring_submission*)(ring + 1);
+}
+
+static inline struct io_ring_completion* io_ring_completions(struct io_ring* ring)
+{
+    return (struct io_ring_completion*)(io_ring_submissions(ring) + ring->entry_count);
+}
+
+// Submit up to to_submit queued entries. Returns the number of entries consumed.
+int io_ring_enter(struct io_ring*, int to_submit);
+
+__END_DECLS
@@ -1,4 +1,5 @@
 #include <Kernel/Syscall.h>
+#include <Kernel/TimePage.h>
 #include <assert.h>
 #include <errno.h>
 #include <sys/time.h>
@@ -8,6 +9,59 @@
 
 extern "C" {
 
+static const TimePage* s_time_page;
+static bool s_time_page_unavailable;
+
+static const TimePage* time_page()
+{
+    if (!s_time_page && !s_time_page_unavailable) {
+        if (syscall(SC_get_time_page, &s_time_page) < 0)
+            s_time_page_unavailable = true;
+    }
+    return s_time_page;
+}
+
+static inline u64 read_tsc()
+{
+    u32 lsw;
+    u32 msw;
+    asm volatile("rdtsc"
+                 : "=a"(lsw), "=d"(msw));
+    return ((u64)msw << 32) | lsw;
+}
+
+// Reads the time from the shared time page, the same way the kernel would.
+// Returns false if there is no time page, so the caller can make a syscall.
+static bool read_time_page(time_t& boot_time, u64& nanoseconds_since_boot)
+{
+    auto* page = time_page();
+    if (!page)
+        return false;
+
+    for (;;) {
+        u32 sequence = page->sequence;
+        if (sequence & 1)
+            continue;
+        asm volatile("" ::: "memory");
+        boot_time = page->boot_time;
+        u64 uptime_ms = page->uptime_ms;
+        u64 boot_tsc = page->boot_tsc;
+        u64 ticks_per_ms = page->tsc_ticks_per_ms;
+        asm volatile("" ::: "memory");
+        if (page->sequence != sequence)
+            continue;
+
+        if (!ticks_per_ms) {
+            nanoseconds_since_boot = uptime_ms * 1000000;
+            return true;
+        }
+        u64 elapsed = read_tsc() - boot_tsc;
+        // Split the conversion so the multiplication can't overflow.
+        nanoseconds_since_boot = (elapsed / ticks_per_ms) * 1000000 + (elapsed % ticks_per_ms) * 1000000 / ticks_per_ms;
+        return true;
+    }
+}
+
 time_t time(time_t* tloc)
 {
     struct timeval tv;
@@ -21,6 +75,13 @@ time_t time(time_t* tloc)
 
 int gettimeofday(struct timeval* __restrict__ tv, void* __restrict__)
 {
+    time_t boot_time;
+    u64 nanoseconds;
+    if (read_time_page(boot_time, nanoseconds)) {
+        tv->tv_sec = boot_time + nanoseconds / 1000000000;
+        tv->tv_usec = (nanoseconds % 1000000000) / 1000;
+        return 0;
+    }
     int rc = syscall(SC_gettimeofday, tv);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
@@ -123,6 +184,13 @@ clock_t clock()
 
 int clock_gettime(clockid_t clock_id, struct timespec* ts)
 {
+    time_t boot_time;
+    u64 nanoseconds;
+    if (clock_id == CLOCK_MONOTONIC && read_time_page(boot_time, nanoseconds)) {
+        ts->tv_sec = nanoseconds / 1000000000;
+        ts->tv_nsec = nanoseconds % 1000000000;
+        return 0;
+    }
     int rc = syscall(SC_clock_gettime, clock_id, ts);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
@@ -134,6 +202,11 @@ int clock_nanosleep(clockid_t clock_id, int flags, const struct timespec* reques
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+int nanosleep(const struct timespec* requested_sleep, struct timespec* remaining_sleep)
+{
+    return clock_nanosleep(CLOCK_MONOTONIC, 0, requested_sleep, remaining_sleep);
+}
+
 int clock_getres(clockid_t, struct timespec*)
 {
     ASSERT_NOT_REACHED();
@@ -33,6 +33,8 @@ void dump_backtrace();
 int fsync(int fd);
 void sysbeep();
 int systrace(pid_t);
+int profiling_enable(pid_t);
+int profiling_disable(pid_t);
 int gettid();
 int donate(int tid);
 int create_shared_buffer(int, void** buffer);
@@ -1,8 +1,7 @@
 #include "CGzip.h"
 #include <AK/ByteBuffer.h>
 #include <AK/Optional.h>
-#include <LibCore/puff.h>
-#include <LibCore/puff.c>
+#include <LibCore/CInflater.h>
 #include <limits.h>
 #include <stddef.h>
 
@@ -88,35 +87,12 @@ Optional<ByteBuffer> CGzip::decompress(const ByteBuffer& data)
     }
 
     auto source = optional_payload.value();
-    unsigned long source_len = source.size();
-    auto destination = ByteBuffer::create_uninitialized(1024);
-    while (true) {
-        unsigned long destination_len = destination.size();
-        // FIXME: dbg() cannot take ulong?
-        // dbg() << "Gzip::decompress: Calling puff()\n"
-        //       << "  destination_data = " << destination.data() << "\n"
-        //       << "  destination_len = " << (int)destination_len << "\n"
-        //       << "  source_data = " << source.data() << "\n"
-        //       << "  source_len = " << (int)source_len;
-
-        auto puff_ret = puff(
-            destination.data(), &destination_len,
-            source.data(), &source_len);
-
-        if (puff_ret == 0) {
-            dbg() << "Gzip::decompress: Decompression success.";
-            break;
-        } 
-        
-        if (puff_ret == 1) {
-            // FIXME: Find a better way of decompressing without needing to try over and over again.
-            dbg() << "Gzip::decompress: Output buffer exhausted. Growing.";
-            destination.grow(destination.size() * 2);
-        } else {
-            dbg() << "Gzip::decompress: Error. puff() returned: " << puff_ret;
-            ASSERT_NOT_REACHED();
-        }
+    auto destination = CInflater::decompress_all(source.data(), source.size());
+    if (!destination.has_value()) {
+        dbg() << "Gzip::decompress: Error. The deflate stream is corrupt.";
+        return Optional<ByteBuffer>();
     }
 
+    dbg() << "Gzip::decompress: Decompression success.";
     return destination;
 }
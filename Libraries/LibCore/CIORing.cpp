@@ -0,0 +1,134 @@
+#include <AK/Assertions.h>
+#include <LibCore/CIORing.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+CIORing::CIORing(u32 entry_count)
+{
+    ASSERT(entry_count && !(entry_count & (entry_count - 1)));
+    m_ring_size = IO_RING_SIZE(entry_count);
+    void* memory = mmap_with_name(nullptr, m_ring_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, "CIORing");
+    if (memory == MAP_FAILED) {
+        perror("mmap");
+        return;
+    }
+    m_ring = (io_ring*)memory;
+    memset(m_ring, 0, sizeof(io_ring));
+    m_ring->entry_count = entry_count;
+}
+
+CIORing::~CIORing()
+{
+    if (m_ring)
+        munmap(m_ring, m_ring_size);
+}
+
+io_ring_submission* CIORing::next_submission(u32 opcode, u32 user_data)
+{
+    ASSERT(is_valid());
+    if (pending_count() >= m_ring->entry_count)
+        return nullptr;
+    auto& submission = io_ring_submissions(m_ring)[m_ring->submission_tail & (m_ring->entry_count - 1)];
+    memset(&submission, 0, sizeof(submission));
+    submission.opcode = opcode;
+    submission.user_data = user_data;
+    return &submission;
+}
+
+bool CIORing::prepare_nop(u32 user_data)
+{
+    if (!next_submission(IORING_OP_NOP, user_data))
+        return false;
+    ++m_ring->submission_tail;
+    return true;
+}
+
+bool CIORing::prepare_read(int fd, void* buffer, size_t size, u32 user_data)
+{
+    auto* submission = next_submission(IORING_OP_READ, user_data);
+    if (!submission)
+        return false;
+    submission->fd = fd;
+    submission->buffer = buffer;
+    submission->length = size;
+    ++m_ring->submission_tail;
+    return true;
+}
+
+bool CIORing::prepare_write(int fd, const void* data, size_t size, u32 user_data)
+{
+    auto* submission = next_submission(IORING_OP_WRITE, user_data);
+    if (!submission)
+        return false;
+    submission->fd = fd;
+    submission->buffer = const_cast<void*>(data);
+    submission->length = size;
+    ++m_ring->submission_tail;
+    return true;
+}
+
+bool CIORing::prepare_sendto(int fd, const void* data, size_t size, int flags, const sockaddr* addr, socklen_t addr_length, u32 user_data)
+{
+    auto* submission = next_submission(IORING_OP_SENDTO, user_data);
+    if (!submission)
+        return false;
+    submission->fd = fd;
+    submission->buffer = const_cast<void*>(data);
+    submission->length = size;
+    submission->flags = flags;
+    submission->addr = const_cast<sockaddr*>(addr);
+    submission->addr_length = addr_length;
+    ++m_ring->submission_tail;
+    return true;
+}
+
+bool CIORing::prepare_recvfrom(int fd, void* buffer, size_t size, int flags, sockaddr* addr, socklen_t* addr_length, u32 user_data)
+{
+    auto* submission = next_submission(IORING_OP_RECVFROM, user_data);
+    if (!submission)
+        return false;
+    submission->fd = fd;
+    submission->buffer = buffer;
+    submission->length = size;
+    submission->flags = flags;
+    submission->addr = addr;
+    submission->addr_length_ptr = addr_length;
+    ++m_ring->submission_tail;
+    return true;
+}
+
+bool CIORing::prepare_poll(int fd, short events, int timeout, u32 user_data)
+{
+    auto* submission = next_submission(IORING_OP_POLL, user_data);
+    if (!submission)
+        return false;
+    submission->poll.fd = fd;
+    submission->poll.events = events;
+    submission->timeout = timeout;
+    ++m_ring->submission_tail;
+    return true;
+}
+
+int CIORing::submit()
+{
+    ASSERT(is_valid());
+    int pending = (int)pending_count();
+    if (!pending)
+        return 0;
+    return io_ring_enter(m_ring, pending);
+}
+
+int CIORing::drain_completions(Function<void(const io_ring_completion&)> callback)
+{
+    ASSERT(is_valid());
+    auto* completions = io_ring_completions(m_ring);
+    u32 mask = m_ring->entry_count - 1;
+    int count = 0;
+    while (m_ring->completion_head != m_ring->completion_tail) {
+        callback(completions[m_ring->completion_head & mask]);
+        ++m_ring->completion_head;
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/Noncopyable.h>
+#include <AK/Types.h>
+#include <sys/io_ring.h>
+
+// Queues I/O operations in a ring shared with the kernel so that a whole batch
+// can be handed over with a single io_ring_enter() call.
+class CIORing {
+    AK_MAKE_NONCOPYABLE(CIORing)
+public:
+    explicit CIORing(u32 entry_count = 64);
+    ~CIORing();
+
+    bool is_valid() const { return m_ring; }
+    u32 entry_count() const { return m_ring->entry_count; }
+    u32 pending_count() const { return m_ring->submission_tail - m_ring->submission_head; }
+
+    bool prepare_nop(u32 user_data);
+    bool prepare_read(int fd, void* buffer, size_t, u32 user_data);
+    bool prepare_write(int fd, const void* data, size_t, u32 user_data);
+    bool prepare_sendto(int fd, const void* data, size_t, int flags, const sockaddr*, socklen_t, u32 user_data);
+    bool prepare_recvfrom(int fd, void* buffer, size_t, int flags, sockaddr*, socklen_t*, u32 user_data);
+    bool prepare_poll(int fd, short events, int timeout, u32 user_data);
+
+    // Returns the number of submissions consumed by the kernel, or -1 on error.
+    int submit();
+
+    // Invokes the callback for each completion in order and frees its slot.
+    int drain_completions(Function<void(const io_ring_completion&)>);
+
+private:
+    io_ring_submission* next_submission(u32 opcode, u32 user_data);
+
+    io_ring* m_ring { nullptr };
+    size_t m_ring_size { 0 };
+};
@@ -0,0 +1,326 @@
+#include <AK/StdLibExtras.h>
+#include <LibCore/CInflater.h>
+#include <string.h>
+
+#pragma GCC optimize("O3")
+
+static const u16 length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const u8 length_extra_bits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const u16 distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const u8 distance_extra_bits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const u8 code_length_order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// Huffman codes are packed starting with their most significant bit, but we
+// read the stream from the least significant bit up, so codes come out reversed.
+static inline u32 reverse_bits(u32 value, int count)
+{
+    u32 result = 0;
+    for (int i = 0; i < count; ++i) {
+        result = (result << 1) | (value & 1);
+        value >>= 1;
+    }
+    return result;
+}
+
+bool CInflater::HuffmanTable::build(const u8* code_lengths, int count)
+{
+    int length_counts[16] = {};
+    for (int i = 0; i < count; ++i)
+        ++length_counts[code_lengths[i]];
+    length_counts[0] = 0;
+
+    // Assign the canonical codes (RFC 1951, section 3.2.2), rejecting sets of
+    // lengths that have more codes than fit. Incomplete sets are fine.
+    int next_code[16];
+    int code = 0;
+    int symbol_index = 0;
+    for (int length = 1; length < 16; ++length) {
+        next_code[length] = code;
+        first_code[length] = code;
+        first_symbol[length] = symbol_index;
+        code += length_counts[length];
+        if (length_counts[length] && code - 1 >= (1 << length))
+            return false;
+        max_code[length] = code << (16 - length);
+        code <<= 1;
+        symbol_index += length_counts[length];
+    }
+    max_code[16] = 0x10000;
+
+    memset(fast, 0, sizeof(fast));
+    for (int symbol = 0; symbol < count; ++symbol) {
+        int length = code_lengths[symbol];
+        if (!length)
+            continue;
+        int index = next_code[length] - first_code[length] + first_symbol[length];
+        symbols[index] = symbol;
+        if (length <= fast_bits) {
+            // Every lookup whose low bits are this code resolves to it.
+            u16 entry = (length << fast_bits) | symbol;
+            for (u32 i = reverse_bits(next_code[length], length); i < (1 << fast_bits); i += 1 << length)
+                fast[i] = entry;
+        }
+        ++next_code[length];
+    }
+    return true;
+}
+
+CInflater::CInflater(const u8* data, int size)
+    : m_window_buffer(ByteBuffer::create_uninitialized(window_size))
+    , m_window(m_window_buffer.data())
+{
+    m_bits.in = data;
+    m_bits.end = data + size;
+}
+
+// Keeps at least 25 bits in the buffer, which is enough for any one code or
+// any one run of extra bits.
+ALWAYS_INLINE void CInflater::BitStream::refill()
+{
+    while (bit_count <= 24) {
+        u32 byte = 0;
+        if (in < end)
+            byte = *in++;
+        else
+            ++overrun;
+        buffer |= byte << bit_count;
+        bit_count += 8;
+    }
+}
+
+ALWAYS_INLINE u32 CInflater::BitStream::read_bits(int count)
+{
+    refill();
+    u32 value = buffer & ((1u << count) - 1);
+    buffer >>= count;
+    bit_count -= count;
+    return value;
+}
+
+// Returns the symbol, or -1 if the bits don't make a code.
+ALWAYS_INLINE int CInflater::BitStream::decode_symbol(const HuffmanTable& table)
+{
+    refill();
+    u16 entry = table.fast[buffer & ((1 << fast_bits) - 1)];
+    if (entry) {
+        int length = entry >> fast_bits;
+        buffer >>= length;
+        bit_count -= length;
+        return entry & ((1 << fast_bits) - 1);
+    }
+
+    u32 code = reverse_bits(buffer, 16);
+    int length = fast_bits + 1;
+    while (code >= table.max_code[length])
+        ++length;
+    if (length >= 16)
+        return -1;
+    int index = (code >> (16 - length)) - table.first_code[length] + table.first_symbol[length];
+    buffer >>= length;
+    bit_count -= length;
+    return table.symbols[index];
+}
+
+bool CInflater::read_dynamic_tables()
+{
+    int literal_count = m_bits.read_bits(5) + 257;
+    int distance_count = m_bits.read_bits(5) + 1;
+    int code_length_count = m_bits.read_bits(4) + 4;
+    if (literal_count > 286 || distance_count > 30)
+        return false;
+
+    u8 code_length_lengths[19] = {};
+    for (int i = 0; i < code_length_count; ++i)
+        code_length_lengths[code_length_order[i]] = m_bits.read_bits(3);
+    HuffmanTable code_length_table;
+    if (!code_length_table.build(code_length_lengths, 19))
+        return false;
+
+    // The literal and distance code lengths are one sequence, and repeats may
+    // run from one into the other.
+    u8 lengths[286 + 30];
+    int total = literal_count + distance_count;
+    for (int i = 0; i < total;) {
+        int symbol = m_bits.decode_symbol(code_length_table);
+        if (symbol < 0)
+            return false;
+        if (symbol < 16) {
+            lengths[i++] = symbol;
+            continue;
+        }
+        u8 value = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (!i)
+                return false;
+            value = lengths[i - 1];
+            repeat = 3 + m_bits.read_bits(2);
+        } else if (symbol == 17) {
+            repeat = 3 + m_bits.read_bits(3);
+        } else {
+            repeat = 11 + m_bits.read_bits(7);
+        }
+        if (i + repeat > total)
+            return false;
+        while (repeat--)
+            lengths[i++] = value;
+    }
+
+    // A block has to be able to end.
+    if (!lengths[256])
+        return false;
+    return m_literal_table.build(lengths, literal_count) && m_distance_table.build(lengths + literal_count, distance_count);
+}
+
+bool CInflater::read_block_header()
+{
+    m_final_block = m_bits.read_bits(1);
+    switch (m_bits.read_bits(2)) {
+    case 0: {
+        // Stored blocks start at the next byte boundary.
+        m_bits.read_bits(m_bits.bit_count % 8);
+        u32 length = m_bits.read_bits(16);
+        u32 complement = m_bits.read_bits(16);
+        if ((length ^ 0xffff) != complement)
+            return false;
+        m_stored_remaining = length;
+        m_state = State::StoredBlock;
+        return true;
+    }
+    case 1: {
+        u8 lengths[288 + 30];
+        memset(lengths, 8, 144);
+        memset(lengths + 144, 9, 112);
+        memset(lengths + 256, 7, 24);
+        memset(lengths + 280, 8, 8);
+        memset(lengths + 288, 5, 30);
+        if (!m_literal_table.build(lengths, 288) || !m_distance_table.build(lengths + 288, 30))
+            return false;
+        m_state = State::HuffmanBlock;
+        return true;
+    }
+    case 2:
+        if (!read_dynamic_tables())
+            return false;
+        m_state = State::HuffmanBlock;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void CInflater::emit(u8* buffer, int& written, u8 byte)
+{
+    buffer[written++] = byte;
+    m_window[m_total_out++ & (window_size - 1)] = byte;
+}
+
+// Returns the new count of bytes written, or -1 if the stream is corrupt.
+int CInflater::read_huffman_block(u8* buffer, int written, int count)
+{
+    BitStream bits = m_bits;
+    u8* window = m_window;
+    u32 total_out = m_total_out;
+    auto emit = [&](u8 byte) {
+        buffer[written++] = byte;
+        window[total_out++ & (window_size - 1)] = byte;
+    };
+
+    while (written < count) {
+        int symbol = bits.decode_symbol(m_literal_table);
+        if (symbol < 256) {
+            if (symbol < 0)
+                return -1;
+            emit(symbol);
+            continue;
+        }
+        if (symbol == 256) {
+            m_state = m_final_block ? State::Finished : State::BlockHeader;
+            break;
+        }
+        symbol -= 257;
+        if (symbol >= 29)
+            return -1;
+        int length = length_base[symbol] + bits.read_bits(length_extra_bits[symbol]);
+        int distance_symbol = bits.decode_symbol(m_distance_table);
+        if (distance_symbol < 0 || distance_symbol >= 30)
+            return -1;
+        u32 distance = distance_base[distance_symbol] + bits.read_bits(distance_extra_bits[distance_symbol]);
+        if (distance > min(total_out, (u32)window_size))
+            return -1;
+
+        // Whatever doesn't fit in the buffer is left for the next read().
+        int copy_length = min(length, count - written);
+        m_match_length = length - copy_length;
+        m_match_distance = distance;
+        while (copy_length--)
+            emit(window[(total_out - distance) & (window_size - 1)]);
+    }
+
+    m_bits = bits;
+    m_total_out = total_out;
+    return written;
+}
+
+int CInflater::read(u8* buffer, int count)
+{
+    int written = 0;
+    while (written < count) {
+        // Finish off a match that didn't fit last time.
+        if (m_match_length) {
+            int length = min(m_match_length, count - written);
+            m_match_length -= length;
+            while (length--)
+                emit(buffer, written, m_window[(m_total_out - m_match_distance) & (window_size - 1)]);
+            continue;
+        }
+
+        switch (m_state) {
+        case State::BlockHeader:
+            if (!read_block_header())
+                return -1;
+            break;
+
+        case State::StoredBlock:
+            while (m_stored_remaining && written < count) {
+                emit(buffer, written, m_bits.read_bits(8));
+                --m_stored_remaining;
+            }
+            if (!m_stored_remaining)
+                m_state = m_final_block ? State::Finished : State::BlockHeader;
+            break;
+
+        case State::HuffmanBlock:
+            written = read_huffman_block(buffer, written, count);
+            if (written < 0)
+                return -1;
+            break;
+
+        case State::Finished:
+            return written;
+        }
+
+        if (m_bits.has_overrun())
+            return -1;
+    }
+    return written;
+}
+
+Optional<ByteBuffer> CInflater::decompress_all(const u8* data, int size)
+{
+    CInflater inflater(data, size);
+    auto output = ByteBuffer::create_uninitialized(max(size * 4, 1024));
+    int total = 0;
+    for (;;) {
+        if (total == output.size())
+            output.grow(output.size() * 2);
+        int written = inflater.read(output.data() + total, output.size() - total);
+        if (written < 0)
+            return {};
+        total += written;
+        if (total < output.size())
+            break;
+    }
+    output.trim(total);
+    return output;
+}
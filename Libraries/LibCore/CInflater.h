@@ -0,0 +1,88 @@
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/Optional.h>
+#include <AK/Types.h>
+
+// Decompresses a raw DEFLATE stream (RFC 1951) that is held in memory, handing
+// out the output a piece at a time as the caller asks for it. Only the last
+// 32 KiB of output is kept around, since that's as far back as a match can
+// reach, so a caller that consumes the output as it goes never needs a buffer
+// for all of it.
+//
+// Huffman codes are decoded through a lookup table that resolves any code of
+// up to fast_bits bits with a single lookup; only longer codes, which are rare
+// by construction, are decoded a bit length at a time.
+class CInflater {
+public:
+    CInflater(const u8* data, int size);
+
+    // Writes up to count bytes of output into the buffer and returns how many
+    // were written. That's fewer than count only once the stream is done, and
+    // -1 if the stream is corrupt.
+    int read(u8* buffer, int count);
+
+    static Optional<ByteBuffer> decompress_all(const u8* data, int size);
+
+private:
+    static const int fast_bits = 9;
+    static const int window_size = 32768;
+
+    struct HuffmanTable {
+        bool build(const u8* code_lengths, int count);
+
+        // (code length << fast_bits) | symbol, or 0 for codes longer than fast_bits.
+        u16 fast[1 << fast_bits];
+        // For the codes of each length: the first code, the index of its symbol
+        // in symbols, and the first code past them, shifted up to 16 bits.
+        u16 first_code[16];
+        u16 first_symbol[16];
+        u32 max_code[17];
+        u16 symbols[288];
+    };
+
+    enum class State {
+        BlockHeader,
+        StoredBlock,
+        HuffmanBlock,
+        Finished,
+    };
+
+    // Everything about where we are in the input. The hot loop works on a
+    // copy of this in locals: stores through the u8 output buffer could alias
+    // any member, which would make the compiler reload them after every byte.
+    struct BitStream {
+        void refill();
+        u32 read_bits(int count);
+        int decode_symbol(const HuffmanTable&);
+        // Reading past the end feeds in zeros, which is fine as long as none
+        // of them get consumed.
+        bool has_overrun() const { return overrun * 8 > bit_count; }
+
+        const u8* in { nullptr };
+        const u8* end { nullptr };
+        int overrun { 0 };
+        u32 buffer { 0 };
+        int bit_count { 0 };
+    };
+
+    bool read_block_header();
+    bool read_dynamic_tables();
+    int read_huffman_block(u8* buffer, int written, int count);
+    void emit(u8* buffer, int& written, u8 byte);
+
+    BitStream m_bits;
+
+    State m_state { State::BlockHeader };
+    bool m_final_block { false };
+    int m_stored_remaining { 0 };
+    int m_match_length { 0 };
+    int m_match_distance { 0 };
+
+    ByteBuffer m_window_buffer;
+    u8* m_window { nullptr };
+    u32 m_total_out { 0 };
+
+    HuffmanTable m_literal_table;
+    HuffmanTable m_distance_table;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <AK/Types.h>
+
+// SIMD code is compiled function by function with __attribute__((target(...))),
+// so callers have to check that the CPU can run it before calling into it.
+inline bool has_sse2()
+{
+    static int s_has_sse2 = -1;
+    if (s_has_sse2 < 0) {
+        u32 eax = 1;
+        u32 ebx;
+        u32 ecx;
+        u32 edx;
+        asm("cpuid"
+            : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+        s_has_sse2 = (edx >> 26) & 1;
+    }
+    return s_has_sse2;
+}
@@ -1,45 +1,286 @@
 #include <LibDraw/DisjointRectSet.h>
+#include <limits.h>
+
+// A horizontal run [left, right) within a band.
+struct Span {
+    int left;
+    int right;
+};
+
+using SpanVector = Vector<Span, 32>;
+
+// Appends bands in top to bottom order, merging each band into the one
+// above it when they touch and have the same spans.
+class BandBuilder {
+public:
+    explicit BandBuilder(Vector<Rect, 32>& rects)
+        : m_rects(rects)
+    {
+    }
+
+    void append_band(int top, int bottom, const SpanVector& spans)
+    {
+        if (spans.is_empty() || top >= bottom)
+            return;
+        if (can_extend_last_band(top, spans)) {
+            for (int i = m_last_band_start; i < m_rects.size(); ++i)
+                m_rects[i].set_height(bottom - m_rects[i].y());
+            return;
+        }
+        m_last_band_start = m_rects.size();
+        for (auto& span : spans)
+            m_rects.append({ span.left, top, span.right - span.left, bottom - top });
+    }
+
+private:
+    bool can_extend_last_band(int top, const SpanVector& spans) const
+    {
+        if (m_last_band_start < 0)
+            return false;
+        if (m_rects.size() - m_last_band_start != spans.size())
+            return false;
+        if (m_rects[m_last_band_start].bottom() + 1 != top)
+            return false;
+        for (int i = 0; i < spans.size(); ++i) {
+            auto& rect = m_rects[m_last_band_start + i];
+            if (rect.x() != spans[i].left || rect.right() + 1 != spans[i].right)
+                return false;
+        }
+        return true;
+    }
+
+    Vector<Rect, 32>& m_rects;
+    int m_last_band_start { -1 };
+};
+
+static int band_end(const Vector<Rect, 32>& rects, int band_start)
+{
+    int i = band_start;
+    while (i < rects.size() && rects[i].y() == rects[band_start].y())
+        ++i;
+    return i;
+}
+
+static void collect_spans(const Vector<Rect, 32>& rects, int band_start, int band_end, SpanVector& spans)
+{
+    for (int i = band_start; i < band_end; ++i)
+        spans.append({ rects[i].x(), rects[i].right() + 1 });
+}
+
+static void unite_spans(const SpanVector& a, const SpanVector& b, SpanVector& output)
+{
+    int i = 0;
+    int j = 0;
+    while (i < a.size() || j < b.size()) {
+        const Span& next = (j >= b.size() || (i < a.size() && a[i].left <= b[j].left)) ? a[i++] : b[j++];
+        if (!output.is_empty() && next.left <= output.last().right)
+            output.last().right = max(output.last().right, next.right);
+        else
+            output.append(next);
+    }
+}
+
+static void intersect_spans(const SpanVector& a, const SpanVector& b, SpanVector& output)
+{
+    int i = 0;
+    int j = 0;
+    while (i < a.size() && j < b.size()) {
+        int left = max(a[i].left, b[j].left);
+        int right = min(a[i].right, b[j].right);
+        if (left < right)
+            output.append({ left, right });
+        if (a[i].right < b[j].right)
+            ++i;
+        else
+            ++j;
+    }
+}
+
+static void subtract_spans(const SpanVector& a, const SpanVector& b, SpanVector& output)
+{
+    int j = 0;
+    for (auto& span : a) {
+        int left = span.left;
+        while (j < b.size() && b[j].right <= left)
+            ++j;
+        for (int k = j; left < span.right; ++k) {
+            if (k >= b.size() || b[k].left >= span.right) {
+                output.append({ left, span.right });
+                break;
+            }
+            if (b[k].left > left)
+                output.append({ left, b[k].left });
+            left = max(left, b[k].right);
+        }
+    }
+}
+
+DisjointRectSet DisjointRectSet::from_rect(const Rect& rect)
+{
+    DisjointRectSet set;
+    if (!rect.is_empty())
+        set.m_rects.append(rect);
+    return set;
+}
+
+DisjointRectSet DisjointRectSet::combine(const DisjointRectSet& a_set, const DisjointRectSet& b_set, Operation operation)
+{
+    auto& a = a_set.m_rects;
+    auto& b = b_set.m_rects;
+    DisjointRectSet result;
+    BandBuilder builder(result.m_rects);
+    SpanVector a_spans;
+    SpanVector b_spans;
+    SpanVector spans;
+
+    // Sweep down through both sets, one interval of rows at a time, such that
+    // neither set's bands start or end within an interval.
+    int a_index = 0;
+    int b_index = 0;
+    int y = INT_MIN;
+    while (a_index < a.size() || b_index < b.size()) {
+        if (operation == Operation::Intersection && (a_index >= a.size() || b_index >= b.size()))
+            break;
+        if (operation == Operation::Difference && a_index >= a.size())
+            break;
+
+        int a_top = a_index < a.size() ? a[a_index].y() : INT_MAX;
+        int b_top = b_index < b.size() ? b[b_index].y() : INT_MAX;
+        y = max(y, min(a_top, b_top));
+        bool a_active = a_top <= y;
+        bool b_active = b_top <= y;
+
+        int next_y = INT_MAX;
+        next_y = min(next_y, a_active ? a[a_index].bottom() + 1 : a_top);
+        next_y = min(next_y, b_active ? b[b_index].bottom() + 1 : b_top);
+
+        int a_band_end = a_active ? band_end(a, a_index) : a_index;
+        int b_band_end = b_active ? band_end(b, b_index) : b_index;
+        a_spans.clear_with_capacity();
+        b_spans.clear_with_capacity();
+        spans.clear_with_capacity();
+        collect_spans(a, a_index, a_band_end, a_spans);
+        collect_spans(b, b_index, b_band_end, b_spans);
+
+        switch (operation) {
+        case Operation::Union:
+            unite_spans(a_spans, b_spans, spans);
+            break;
+        case Operation::Intersection:
+            intersect_spans(a_spans, b_spans, spans);
+            break;
+        case Operation::Difference:
+            subtract_spans(a_spans, b_spans, spans);
+            break;
+        }
+        builder.append_band(y, next_y, spans);
+
+        y = next_y;
+        if (a_active && a[a_index].bottom() + 1 <= y)
+            a_index = a_band_end;
+        if (b_active && b[b_index].bottom() + 1 <= y)
+            b_index = b_band_end;
+    }
+    return result;
+}
 
 void DisjointRectSet::add(const Rect& new_rect)
+{
+    if (new_rect.is_empty())
+        return;
+    *this = combine(*this, from_rect(new_rect), Operation::Union);
+}
+
+void DisjointRectSet::add(const DisjointRectSet& other)
+{
+    *this = combine(*this, other, Operation::Union);
+}
+
+DisjointRectSet DisjointRectSet::shatter(const Rect& hammer) const
+{
+    return combine(*this, from_rect(hammer), Operation::Difference);
+}
+
+DisjointRectSet DisjointRectSet::shatter(const DisjointRectSet& hammer) const
+{
+    return combine(*this, hammer, Operation::Difference);
+}
+
+DisjointRectSet DisjointRectSet::intersected(const Rect& rect) const
+{
+    return combine(*this, from_rect(rect), Operation::Intersection);
+}
+
+DisjointRectSet DisjointRectSet::intersected(const DisjointRectSet& other) const
+{
+    return combine(*this, other, Operation::Intersection);
+}
+
+DisjointRectSet DisjointRectSet::translated(const Point& delta) const
+{
+    DisjointRectSet set;
+    for (auto& rect : m_rects)
+        set.m_rects.append(rect.translated(delta));
+    return set;
+}
+
+bool DisjointRectSet::intersects(const Rect& other) const
 {
     for (auto& rect : m_rects) {
-        if (rect.contains(new_rect))
-            return;
+        if (rect.y() > other.bottom())
+            break;
+        if (rect.intersects(other))
+            return true;
     }
+    return false;
+}
 
-    m_rects.append(new_rect);
-    if (m_rects.size() > 1)
-        shatter();
-}
-
-void DisjointRectSet::shatter()
-{
-    Vector<Rect, 32> output;
-    output.ensure_capacity(m_rects.size());
-    bool pass_had_intersections = false;
-    do {
-        pass_had_intersections = false;
-        output.clear_with_capacity();
-        for (int i = 0; i < m_rects.size(); ++i) {
-            auto& r1 = m_rects[i];
-            for (int j = 0; j < m_rects.size(); ++j) {
-                if (i == j)
-                    continue;
-                auto& r2 = m_rects[j];
-                if (!r1.intersects(r2))
-                    continue;
-                pass_had_intersections = true;
-                auto pieces = r1.shatter(r2);
-                for (auto& piece : pieces)
-                    output.append(piece);
-                m_rects.remove(i);
-                for (; i < m_rects.size(); ++i)
-                    output.append(m_rects[i]);
-                goto next_pass;
-            }
-            output.append(r1);
+Rect DisjointRectSet::bounding_rect() const
+{
+    if (m_rects.is_empty())
+        return {};
+    int left = INT_MAX;
+    int right = INT_MIN;
+    for (auto& rect : m_rects) {
+        left = min(left, rect.x());
+        right = max(right, rect.right());
+    }
+    int top = m_rects.first().y();
+    int bottom = m_rects.last().bottom();
+    return { left, top, right - left + 1, bottom - top + 1 };
+}
+
+void DisjointRectSet::simplify(int max_rect_count)
+{
+    ASSERT(max_rect_count > 0);
+    if (m_rects.size() <= max_rect_count)
+        return;
+
+    // First, replace each band with its bounding span.
+    Vector<Rect, 32> bands;
+    {
+        BandBuilder builder(bands);
+        SpanVector span;
+        for (int band_start = 0; band_start < m_rects.size();) {
+            int end = band_end(m_rects, band_start);
+            span.clear_with_capacity();
+            span.append({ m_rects[band_start].x(), m_rects[end - 1].right() + 1 });
+            builder.append_band(m_rects[band_start].y(), m_rects[band_start].bottom() + 1, span);
+            band_start = end;
         }
-    next_pass:
-        swap(output, m_rects);
-    } while (pass_had_intersections);
+    }
+
+    // Then keep merging pairs of neighbouring bands until there are few enough.
+    // Bands don't overlap vertically, so their bounding rects don't either.
+    while (bands.size() > max_rect_count) {
+        Vector<Rect, 32> merged;
+        for (int i = 0; i < bands.size(); i += 2) {
+            if (i + 1 < bands.size())
+                merged.append(bands[i].united(bands[i + 1]));
+            else
+                merged.append(bands[i]);
+        }
+        swap(bands, merged);
+    }
+    m_rects = move(bands);
 }
@@ -3,6 +3,13 @@
 #include <AK/Vector.h>
 #include <LibDraw/Rect.h>
 
+// A region of the plane, stored as disjoint rects in y-x banded order:
+// the rects are sorted top to bottom and then left to right, rects that
+// share any rows span exactly the same rows (a "band"), rects within a band
+// never touch, and vertically adjacent bands with the same rects are merged.
+//
+// Every operation walks its operands' bands in order, so it is linear in
+// the number of rects involved.
 class DisjointRectSet {
 public:
     DisjointRectSet() {}
@@ -11,8 +18,34 @@ public:
         : m_rects(move(other.m_rects))
     {
     }
+    DisjointRectSet& operator=(DisjointRectSet&& other)
+    {
+        if (this != &other)
+            m_rects = move(other.m_rects);
+        return *this;
+    }
 
     void add(const Rect&);
+    void add(const DisjointRectSet&);
+
+    // The parts of this set outside the hammer.
+    DisjointRectSet shatter(const Rect& hammer) const;
+    DisjointRectSet shatter(const DisjointRectSet& hammer) const;
+
+    DisjointRectSet intersected(const Rect&) const;
+    DisjointRectSet intersected(const DisjointRectSet&) const;
+
+    // Moving every rect by the same amount keeps them banded.
+    DisjointRectSet translated(const Point&) const;
+
+    bool intersects(const Rect&) const;
+    Rect bounding_rect() const;
+
+    // Grows the set until it has at most max_rect_count rects, by merging
+    // neighbouring rects into their bounding rects. That's fine for damage,
+    // where painting a bit more beats painting many tiny rects, but not for
+    // anything that has to be exact.
+    void simplify(int max_rect_count);
 
     bool is_empty() const { return m_rects.is_empty(); }
     int size() const { return m_rects.size(); }
@@ -22,7 +55,13 @@ public:
     const Vector<Rect, 32>& rects() const { return m_rects; }
 
 private:
-    void shatter();
+    enum class Operation {
+        Union,
+        Intersection,
+        Difference,
+    };
+    static DisjointRectSet combine(const DisjointRectSet&, const DisjointRectSet&, Operation);
+    static DisjointRectSet from_rect(const Rect&);
 
     Vector<Rect, 32> m_rects;
 };
@@ -1,6 +1,7 @@
 #include <AK/MappedFile.h>
 #include <LibDraw/GraphicsBitmap.h>
 #include <LibDraw/PNGLoader.h>
+#include <LibDraw/SharedImageCache.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
@@ -31,6 +32,8 @@ NonnullRefPtr<GraphicsBitmap> GraphicsBitmap::create_wrapper(Format format, cons
 
 RefPtr<GraphicsBitmap> GraphicsBitmap::load_from_file(const StringView& path)
 {
+    if (auto* cache = SharedImageCache::the())
+        return cache->load(path);
     return load_png(path);
 }
 
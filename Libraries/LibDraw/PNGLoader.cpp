@@ -1,16 +1,19 @@
 #include <AK/FileSystemPath.h>
 #include <AK/MappedFile.h>
 #include <AK/NetworkOrdered.h>
-#include <LibCore/puff.h>
+#include <LibCore/CInflater.h>
+#include <LibDraw/CPUFeatures.h>
 #include <LibDraw/PNGLoader.h>
+#include <emmintrin.h>
 #include <fcntl.h>
 #include <serenity.h>
 #include <stdio.h>
 #include <string.h>
-#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#pragma GCC optimize("O3")
+
 //#define PNG_STOPWATCH_DEBUG
 
 static const u8 png_header[8] = { 0x89, 'P', 'N', 'G', 13, 10, 26, 10 };
@@ -27,11 +30,6 @@ struct PNG_IHDR {
 
 static_assert(sizeof(PNG_IHDR) == 13);
 
-struct Scanline {
-    u8 filter { 0 };
-    ByteBuffer data {};
-};
-
 struct [[gnu::packed]] PaletteEntry
 {
     u8 r;
@@ -40,28 +38,6 @@ struct [[gnu::packed]] PaletteEntry
     //u8 a;
 };
 
-struct [[gnu::packed]] Triplet
-{
-    u8 r;
-    u8 g;
-    u8 b;
-};
-
-struct [[gnu::packed]] Triplet16
-{
-    u16 r;
-    u16 g;
-    u16 b;
-};
-
-struct [[gnu::packed]] Quad16
-{
-    u16 r;
-    u16 g;
-    u16 b;
-    u16 a;
-};
-
 struct PNGLoadingContext {
     enum State {
         NotDecoded = 0,
@@ -84,10 +60,7 @@ struct PNGLoadingContext {
     u8 bytes_per_pixel { 0 };
     bool has_seen_zlib_header { false };
     bool has_alpha() const { return color_type & 4 || palette_transparency_data.size() > 0; }
-    Vector<Scanline> scanlines;
     RefPtr<GraphicsBitmap> bitmap;
-    u8* decompression_buffer { nullptr };
-    int decompression_buffer_size { 0 };
     Vector<u8> compressed_data;
     Vector<PaletteEntry> palette_data;
     Vector<u8> palette_transparency_data;
@@ -144,7 +117,7 @@ private:
 };
 
 static RefPtr<GraphicsBitmap> load_png_impl(const u8*, int);
-static bool process_chunk(Streamer&, PNGLoadingContext& context, bool decode_size_only);
+static bool process_chunk(Streamer&, PNGLoadingContext& context);
 
 RefPtr<GraphicsBitmap> load_png(const StringView& path)
 {
@@ -178,221 +151,256 @@ RefPtr<GraphicsBitmap> load_png_from_memory(const u8* data, size_t length)
     return c;
 }
 
-union [[gnu::packed]] Pixel
+// Undoes a filter on a row of bytes in place, from byte start on, given the
+// row above it, already unfiltered. Each byte is predicted from the same byte
+// of the pixel to its left ("a"), of the pixel above ("b"), and of the pixel
+// above and to the left ("c"), which are zero beyond the edges of the image.
+static void unfilter_row(u8 filter, u8* row, const u8* prior, int size, int bytes_per_pixel, int start = 0)
 {
-    RGBA32 rgba { 0 };
-    u8 v[4];
-    struct {
-        u8 r;
-        u8 g;
-        u8 b;
-        u8 a;
-    };
-};
-static_assert(sizeof(Pixel) == 4);
+    int first_pixel_size = min(bytes_per_pixel, size);
+    switch (filter) {
+    case 1:
+        for (int i = max(start, bytes_per_pixel); i < size; ++i)
+            row[i] += row[i - bytes_per_pixel];
+        break;
+    case 2:
+        for (int i = start; i < size; ++i)
+            row[i] += prior[i];
+        break;
+    case 3:
+        for (int i = start; i < first_pixel_size; ++i)
+            row[i] += prior[i] / 2;
+        for (int i = max(start, bytes_per_pixel); i < size; ++i)
+            row[i] += (row[i - bytes_per_pixel] + prior[i]) / 2;
+        break;
+    case 4:
+        for (int i = start; i < first_pixel_size; ++i)
+            row[i] += prior[i];
+        for (int i = max(start, bytes_per_pixel); i < size; ++i)
+            row[i] += paeth_predictor(row[i - bytes_per_pixel], prior[i], prior[i - bytes_per_pixel]);
+        break;
+    }
+}
+
+// SSE2 versions of the filters for rows of four-byte pixels. Sub and Up do
+// four pixels at a time, and return how many they did. Average and Paeth
+// predict each pixel from the one just before it, so they go a pixel at a time,
+// but with all four of its channels at once.
 
-template<bool has_alpha, u8 filter_type>
-[[gnu::always_inline]] static inline void unfilter_impl(GraphicsBitmap& bitmap, int y, const void* dummy_scanline_data)
+__attribute__((target("sse2"))) static inline __m128i sse2_load_pixel(const u8* pixel)
 {
-    auto* dummy_scanline = (const Pixel*)dummy_scanline_data;
-    if constexpr (filter_type == 0) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-        }
+    u32 value;
+    memcpy(&value, pixel, sizeof(value));
+    return _mm_cvtsi32_si128(value);
+}
+
+__attribute__((target("sse2"))) static inline void sse2_store_pixel(u8* pixel, __m128i value)
+{
+    u32 low = _mm_cvtsi128_si32(value);
+    memcpy(pixel, &low, sizeof(low));
+}
+
+__attribute__((target("sse2"))) static int sse2_unfilter_sub(u8* row, int width)
+{
+    __m128i last = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        // A running sum across the four pixels, on top of the last one before them.
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(row + x * 4));
+        pixels = _mm_add_epi8(pixels, _mm_slli_si128(pixels, 4));
+        pixels = _mm_add_epi8(pixels, _mm_slli_si128(pixels, 8));
+        pixels = _mm_add_epi8(pixels, last);
+        _mm_storeu_si128((__m128i*)(row + x * 4), pixels);
+        last = _mm_shuffle_epi32(pixels, 0xff);
     }
+    return x;
+}
 
-    if constexpr (filter_type == 1) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        swap(pixels[0].r, pixels[0].b);
-        for (int i = 1; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            auto& a = (const Pixel&)pixels[i - 1];
-            x.v[0] += a.v[0];
-            x.v[1] += a.v[1];
-            x.v[2] += a.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += a.v[3];
-        }
-        return;
+__attribute__((target("sse2"))) static int sse2_unfilter_up(u8* row, const u8* prior, int width)
+{
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(row + x * 4));
+        __m128i above = _mm_loadu_si128((const __m128i*)(prior + x * 4));
+        _mm_storeu_si128((__m128i*)(row + x * 4), _mm_add_epi8(pixels, above));
     }
-    if constexpr (filter_type == 2) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] += b.v[0];
-            x.v[1] += b.v[1];
-            x.v[2] += b.v[2];
-            if constexpr (has_alpha)
-                x.v[3] += b.v[3];
-        }
-        return;
+    return x;
+}
+
+__attribute__((target("sse2"))) static void sse2_unfilter_average(u8* row, const u8* prior, int width)
+{
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i a = _mm_setzero_si128();
+    for (int x = 0; x < width; ++x) {
+        __m128i b = sse2_load_pixel(prior + x * 4);
+        // _mm_avg_epu8() rounds up, and the filter rounds down.
+        __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+        a = _mm_add_epi8(sse2_load_pixel(row + x * 4), average);
+        sse2_store_pixel(row + x * 4, a);
     }
-    if constexpr (filter_type == 3) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            if (i != 0)
-                a = pixels[i - 1];
-            const Pixel& b = pixels_y_minus_1[i];
-            x.v[0] = x.v[0] + ((a.v[0] + b.v[0]) / 2);
-            x.v[1] = x.v[1] + ((a.v[1] + b.v[1]) / 2);
-            x.v[2] = x.v[2] + ((a.v[2] + b.v[2]) / 2);
-            if constexpr (has_alpha)
-                x.v[3] = x.v[3] + ((a.v[3] + b.v[3]) / 2);
-        }
+}
+
+__attribute__((target("sse2"))) static inline __m128i sse2_abs_epi16(__m128i value)
+{
+    return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+}
+
+__attribute__((target("sse2"))) static void sse2_unfilter_paeth(u8* row, const u8* prior, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    // One 16-bit lane per channel, so the differences below don't overflow.
+    __m128i a = zero;
+    __m128i c = zero;
+    for (int x = 0; x < width; ++x) {
+        __m128i b = _mm_unpacklo_epi8(sse2_load_pixel(prior + x * 4), zero);
+        // The same distances as in paeth_predictor(), with p = a + b - c.
+        __m128i b_minus_c = _mm_sub_epi16(b, c);
+        __m128i a_minus_c = _mm_sub_epi16(a, c);
+        __m128i pa = sse2_abs_epi16(b_minus_c);
+        __m128i pb = sse2_abs_epi16(a_minus_c);
+        __m128i pc = sse2_abs_epi16(_mm_add_epi16(b_minus_c, a_minus_c));
+
+        __m128i not_a = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+        __m128i use_c = _mm_cmpgt_epi16(pb, pc);
+        __m128i b_or_c = _mm_or_si128(_mm_andnot_si128(use_c, b), _mm_and_si128(use_c, c));
+        __m128i predictor = _mm_or_si128(_mm_andnot_si128(not_a, a), _mm_and_si128(not_a, b_or_c));
+
+        __m128i pixel = _mm_add_epi8(sse2_load_pixel(row + x * 4), _mm_packus_epi16(predictor, predictor));
+        sse2_store_pixel(row + x * 4, pixel);
+        a = _mm_unpacklo_epi8(pixel, zero);
+        c = b;
+    }
+}
+
+static void unfilter_pixels(u8 filter, u8* row, const u8* prior, int width)
+{
+    int size = width * 4;
+    if (!has_sse2()) {
+        unfilter_row(filter, row, prior, size, 4);
         return;
     }
-    if constexpr (filter_type == 4) {
-        auto* pixels = (Pixel*)bitmap.scanline(y);
-        auto* pixels_y_minus_1 = y == 0 ? dummy_scanline : (Pixel*)bitmap.scanline(y - 1);
-        for (int i = 0; i < bitmap.width(); ++i) {
-            auto& x = pixels[i];
-            swap(x.r, x.b);
-            Pixel a;
-            const Pixel& b = pixels_y_minus_1[i];
-            Pixel c;
-            if (i != 0) {
-                a = pixels[i - 1];
-                c = pixels_y_minus_1[i - 1];
-            }
-            x.v[0] += paeth_predictor(a.v[0], b.v[0], c.v[0]);
-            x.v[1] += paeth_predictor(a.v[1], b.v[1], c.v[1]);
-            x.v[2] += paeth_predictor(a.v[2], b.v[2], c.v[2]);
-            if constexpr (has_alpha)
-                x.v[3] += paeth_predictor(a.v[3], b.v[3], c.v[3]);
-        }
+    switch (filter) {
+    case 1:
+        unfilter_row(filter, row, prior, size, 4, sse2_unfilter_sub(row, width) * 4);
+        break;
+    case 2:
+        unfilter_row(filter, row, prior, size, 4, sse2_unfilter_up(row, prior, width) * 4);
+        break;
+    case 3:
+        sse2_unfilter_average(row, prior, width);
+        break;
+    case 4:
+        sse2_unfilter_paeth(row, prior, width);
+        break;
     }
 }
 
-[[gnu::noinline]] static void unfilter(PNGLoadingContext& context)
+// Rows are unfiltered with their channels in PNG's order, R, G, B, A, since
+// the row below is predicted from them that way. Only once that's done are
+// they turned into our BGRA. Formats without alpha get it made opaque here,
+// whatever the filters did with it.
+__attribute__((target("sse2"))) static int sse2_finish_row(RGBA32* pixels, int width, u32 alpha)
 {
-    {
-#ifdef PNG_STOPWATCH_DEBUG
-        Stopwatch sw("load_png_impl: unfilter: unpack");
-#endif
-        // First unpack the scanlines to RGBA:
-        switch (context.color_type) {
-        case 2:
-            if (context.bit_depth == 8) {
-                for (int y = 0; y < context.height; ++y) {
-                    auto* triplets = (Triplet*)context.scanlines[y].data.data();
-                    for (int i = 0; i < context.width; ++i) {
-                        auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                        pixel.r = triplets[i].r;
-                        pixel.g = triplets[i].g;
-                        pixel.b = triplets[i].b;
-                        pixel.a = 0xff;
-                    }
-                }
-            } else if (context.bit_depth == 16) {
-                for (int y = 0; y < context.height; ++y) {
-                    auto* triplets = (Triplet16*)context.scanlines[y].data.data();
-                    for (int i = 0; i < context.width; ++i) {
-                        auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                        pixel.r = triplets[i].r & 0xFF;
-                        pixel.g = triplets[i].g & 0xFF;
-                        pixel.b = triplets[i].b & 0xFF;
-                        pixel.a = 0xff;
-                    }
-                }
-            } else {
-                ASSERT_NOT_REACHED();
-            }
-            break;
-        case 6:
-            if (context.bit_depth == 8) {
-                for (int y = 0; y < context.height; ++y) {
-                    memcpy(context.bitmap->scanline(y), context.scanlines[y].data.data(), context.scanlines[y].data.size());
-                }
-            } else if (context.bit_depth == 16) {
-                for (int y = 0; y < context.height; ++y) {
-                    auto* triplets = (Quad16*)context.scanlines[y].data.data();
-                    for (int i = 0; i < context.width; ++i) {
-                        auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                        pixel.r = triplets[i].r & 0xFF;
-                        pixel.g = triplets[i].g & 0xFF;
-                        pixel.b = triplets[i].b & 0xFF;
-                        pixel.a = triplets[i].a & 0xFF;
-                    }
-                }
-            } else {
-                ASSERT_NOT_REACHED();
-            }
-            break;
-        case 3:
-            for (int y = 0; y < context.height; ++y) {
-                auto* palette_index = (u8*)context.scanlines[y].data.data();
-                for (int i = 0; i < context.width; ++i) {
-                    auto& pixel = (Pixel&)context.bitmap->scanline(y)[i];
-                    auto& color = context.palette_data.at((int)palette_index[i]);
-                    auto transparency = context.palette_transparency_data.size() >= palette_index[i] + 1
-                        ? (int)context.palette_transparency_data.data()[palette_index[i]]
-                        : 0xFF;
-                    pixel.r = color.r;
-                    pixel.g = color.g;
-                    pixel.b = color.b;
-                    pixel.a = transparency;
-                }
-            }
-            break;
-        default:
-            ASSERT_NOT_REACHED();
-            break;
-        }
+    const __m128i red_and_blue = _mm_set1_epi32(0xff);
+    const __m128i green_and_alpha = _mm_set1_epi32(0xff00ff00);
+    const __m128i forced_alpha = _mm_set1_epi32(alpha);
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i rgba = _mm_loadu_si128((const __m128i*)(pixels + x));
+        __m128i red = _mm_slli_epi32(_mm_and_si128(rgba, red_and_blue), 16);
+        __m128i blue = _mm_and_si128(_mm_srli_epi32(rgba, 16), red_and_blue);
+        __m128i bgra = _mm_or_si128(_mm_or_si128(_mm_and_si128(rgba, green_and_alpha), forced_alpha), _mm_or_si128(red, blue));
+        _mm_storeu_si128((__m128i*)(pixels + x), bgra);
+    }
+    return x;
+}
+
+static void finish_row(RGBA32* pixels, int width, bool has_alpha)
+{
+    u32 alpha = has_alpha ? 0 : 0xff000000;
+    int x = has_sse2() ? sse2_finish_row(pixels, width, alpha) : 0;
+    for (; x < width; ++x) {
+        u32 rgba = pixels[x];
+        pixels[x] = (rgba & 0xff00ff00) | alpha | ((rgba & 0xff) << 16) | ((rgba >> 16) & 0xff);
     }
+}
 
-    auto dummy_scanline = ByteBuffer::create_zeroed(context.width * sizeof(RGBA32));
+// Unpacks a row of samples to four-byte pixels, still in PNG's channel order,
+// so the filters can be undone on those. That works for 16-bit samples cut
+// down to their high byte too: the filters work on each byte separately.
+static void unpack_row(const PNGLoadingContext& context, const u8* row, u8* pixels)
+{
+    int sample_size = context.bit_depth / 8;
+    int channels = context.color_type == 6 ? 4 : 3;
+    for (int x = 0; x < context.width; ++x) {
+        const u8* samples = row + x * channels * sample_size;
+        u8* pixel = pixels + x * 4;
+        pixel[0] = samples[0];
+        pixel[1] = samples[sample_size];
+        pixel[2] = samples[2 * sample_size];
+        pixel[3] = channels == 4 ? samples[3 * sample_size] : 0;
+    }
+}
+
+// Inflates one row at a time and undoes its filter right in the bitmap, with
+// the row above it still there to predict from. Only palette indices need to
+// be unfiltered before they turn into pixels, so those rows go through a pair
+// of buffers.
+static bool decode_rows(PNGLoadingContext& context, CInflater& inflater)
+{
+    auto& bitmap = *context.bitmap;
+    int width = context.width;
+    int row_size = width * context.bytes_per_pixel;
+    bool is_indexed = context.color_type == 3;
+    bool inflates_into_bitmap = context.color_type == 6 && context.bit_depth == 8;
+
+    auto zero_row = ByteBuffer::create_zeroed(width * sizeof(RGBA32));
+    ByteBuffer row_buffer;
+    ByteBuffer prior_row_buffer;
+    if (!inflates_into_bitmap)
+        row_buffer = ByteBuffer::create_uninitialized(row_size);
+    if (is_indexed)
+        prior_row_buffer = ByteBuffer::create_zeroed(row_size);
+
+    RGBA32 palette[256];
+    int palette_size = min(context.palette_data.size(), 256);
+    for (int i = 0; i < palette_size; ++i) {
+        auto& entry = context.palette_data[i];
+        u8 alpha = i < context.palette_transparency_data.size() ? context.palette_transparency_data[i] : 0xff;
+        palette[i] = Color(entry.r, entry.g, entry.b, alpha).value();
+    }
 
-#ifdef PNG_STOPWATCH_DEBUG
-    Stopwatch sw("load_png_impl: unfilter: process");
-#endif
     for (int y = 0; y < context.height; ++y) {
-        auto filter = context.scanlines[y].filter;
-        if (filter == 0) {
-            if (context.has_alpha())
-                unfilter_impl<true, 0>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 0>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 1) {
-            if (context.has_alpha())
-                unfilter_impl<true, 1>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 1>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 2) {
-            if (context.has_alpha())
-                unfilter_impl<true, 2>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 2>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 3) {
-            if (context.has_alpha())
-                unfilter_impl<true, 3>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 3>(*context.bitmap, y, dummy_scanline.data());
-            continue;
-        }
-        if (filter == 4) {
-            if (context.has_alpha())
-                unfilter_impl<true, 4>(*context.bitmap, y, dummy_scanline.data());
-            else
-                unfilter_impl<false, 4>(*context.bitmap, y, dummy_scanline.data());
+        u8 filter;
+        if (inflater.read(&filter, 1) != 1 || filter > 4)
+            return false;
+        auto* pixels = bitmap.scanline(y);
+        u8* row = inflates_into_bitmap ? (u8*)pixels : row_buffer.data();
+        if (inflater.read(row, row_size) != row_size)
+            return false;
+
+        if (is_indexed) {
+            unfilter_row(filter, row, prior_row_buffer.data(), row_size, 1);
+            for (int x = 0; x < width; ++x) {
+                if (row[x] >= palette_size)
+                    return false;
+                pixels[x] = palette[row[x]];
+            }
+            swap(row_buffer, prior_row_buffer);
             continue;
         }
+
+        if (!inflates_into_bitmap)
+            unpack_row(context, row, (u8*)pixels);
+        const u8* prior = y ? (const u8*)bitmap.scanline(y - 1) : zero_row.data();
+        unfilter_pixels(filter, (u8*)pixels, prior, width);
+        if (y)
+            finish_row(bitmap.scanline(y - 1), width, context.has_alpha());
     }
+
+    if (!is_indexed && context.height)
+        finish_row(bitmap.scanline(context.height - 1), width, context.has_alpha());
+    return true;
 }
 
 static bool decode_png_header(PNGLoadingContext& context)
@@ -425,7 +433,7 @@ static bool decode_png_size(PNGLoadingContext& context)
 
     Streamer streamer(data_ptr, data_remaining);
     while (!streamer.at_end()) {
-        if (!process_chunk(streamer, context, true)) {
+        if (!process_chunk(streamer, context)) {
             context.state = PNGLoadingContext::State::Error;
             return false;
         }
@@ -455,7 +463,7 @@ static bool decode_png_chunks(PNGLoadingContext& context)
 
     Streamer streamer(data_ptr, data_remaining);
     while (!streamer.at_end()) {
-        if (!process_chunk(streamer, context, false)) {
+        if (!process_chunk(streamer, context)) {
             context.state = PNGLoadingContext::State::Error;
             return false;
         }
@@ -475,55 +483,32 @@ static bool decode_png_bitmap(PNGLoadingContext& context)
     if (context.state >= PNGLoadingContext::State::BitmapDecoded)
         return true;
 
-    {
-#ifdef PNG_STOPWATCH_DEBUG
-        Stopwatch sw("load_png_impl: uncompress");
-#endif
-        unsigned long srclen = context.compressed_data.size() - 6;
-        unsigned long destlen = context.decompression_buffer_size;
-        int ret = puff(context.decompression_buffer, &destlen, context.compressed_data.data() + 2, &srclen);
-        if (ret < 0) {
-            context.state = PNGLoadingContext::State::Error;
-            return false;
-        }
-        context.compressed_data.clear();
+    // Skip the zlib header; the Adler-32 checksum at the end goes unread.
+    if (context.compressed_data.size() < 2) {
+        context.state = PNGLoadingContext::State::Error;
+        return false;
     }
 
     {
 #ifdef PNG_STOPWATCH_DEBUG
-        Stopwatch sw("load_png_impl: extract scanlines");
+        Stopwatch sw("load_png_impl: create bitmap");
 #endif
-        context.scanlines.ensure_capacity(context.height);
-        Streamer streamer(context.decompression_buffer, context.decompression_buffer_size);
-        for (int y = 0; y < context.height; ++y) {
-            u8 filter;
-            if (!streamer.read(filter)) {
-                context.state = PNGLoadingContext::State::Error;
-                return false;
-            }
-
-            context.scanlines.append({ filter });
-            auto& scanline_buffer = context.scanlines.last().data;
-            if (!streamer.wrap_bytes(scanline_buffer, context.width * context.bytes_per_pixel)) {
-                context.state = PNGLoadingContext::State::Error;
-                return false;
-            }
-        }
+        context.bitmap = GraphicsBitmap::create(context.has_alpha() ? GraphicsBitmap::Format::RGBA32 : GraphicsBitmap::Format::RGB32, { context.width, context.height });
     }
 
     {
 #ifdef PNG_STOPWATCH_DEBUG
-        Stopwatch sw("load_png_impl: create bitmap");
+        Stopwatch sw("load_png_impl: decode rows");
 #endif
-        context.bitmap = GraphicsBitmap::create(context.has_alpha() ? GraphicsBitmap::Format::RGBA32 : GraphicsBitmap::Format::RGB32, { context.width, context.height });
+        CInflater inflater(context.compressed_data.data() + 2, context.compressed_data.size() - 2);
+        if (!decode_rows(context, inflater)) {
+            context.bitmap = nullptr;
+            context.state = PNGLoadingContext::State::Error;
+            return false;
+        }
+        context.compressed_data.clear();
     }
 
-    unfilter(context);
-
-    munmap(context.decompression_buffer, context.decompression_buffer_size);
-    context.decompression_buffer = nullptr;
-    context.decompression_buffer_size = 0;
-
     context.state = PNGLoadingContext::State::BitmapDecoded;
     return true;
 }
@@ -543,7 +528,7 @@ static RefPtr<GraphicsBitmap> load_png_impl(const u8* data, int data_size)
     return context.bitmap;
 }
 
-static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context, bool decode_size_only = false)
+static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context)
 {
     if (data.size() < (int)sizeof(PNG_IHDR))
         return false;
@@ -576,7 +561,11 @@ static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context, boo
         // FIXME: Implement grayscale PNG support.
         dbgprintf("PNGLoader::process_IHDR: Unsupported grayscale format.\n");
         return false;
-    case 2:
+    case 2: // Each pixel is an R,G,B triple.
+        if (ihdr.bit_depth != 8 && ihdr.bit_depth != 16) {
+            dbgprintf("PNGLoader::process_IHDR: Invalid RGB format (%d bpp).\n", context.bit_depth);
+            return false;
+        }
         context.bytes_per_pixel = 3 * (ihdr.bit_depth / 8);
         break;
     case 3: // Each pixel is a palette index; a PLTE chunk must appear.
@@ -587,17 +576,16 @@ static bool process_IHDR(const ByteBuffer& data, PNGLoadingContext& context, boo
         }
         context.bytes_per_pixel = 1;
         break;
-    case 6:
+    case 6: // Each pixel is an R,G,B triple, followed by an alpha sample.
+        if (ihdr.bit_depth != 8 && ihdr.bit_depth != 16) {
+            dbgprintf("PNGLoader::process_IHDR: Invalid RGBA format (%d bpp).\n", context.bit_depth);
+            return false;
+        }
         context.bytes_per_pixel = 4 * (ihdr.bit_depth / 8);
         break;
     default:
         ASSERT_NOT_REACHED();
     }
-
-    if (!decode_size_only) {
-        context.decompression_buffer_size = (context.width * context.height * context.bytes_per_pixel + context.height);
-        context.decompression_buffer = (u8*)mmap_with_name(nullptr, context.decompression_buffer_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, "PNG decompression buffer");
-    }
     return true;
 }
 
@@ -623,7 +611,7 @@ static bool process_tRNS(const ByteBuffer& data, PNGLoadingContext& context)
     return true;
 }
 
-static bool process_chunk(Streamer& streamer, PNGLoadingContext& context, bool decode_size_only)
+static bool process_chunk(Streamer& streamer, PNGLoadingContext& context)
 {
     u32 chunk_size;
     if (!streamer.read(chunk_size)) {
@@ -651,7 +639,7 @@ static bool process_chunk(Streamer& streamer, PNGLoadingContext& context, bool d
 #endif
 
     if (!strcmp((const char*)chunk_type, "IHDR"))
-        return process_IHDR(chunk_data, context, decode_size_only);
+        return process_IHDR(chunk_data, context);
     if (!strcmp((const char*)chunk_type, "IDAT"))
         return process_IDAT(chunk_data, context);
     if (!strcmp((const char*)chunk_type, "PLTE"))
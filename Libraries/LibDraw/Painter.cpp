@@ -6,9 +6,12 @@
 #include <AK/StdLibExtras.h>
 #include <AK/StringBuilder.h>
 #include <AK/Utf8View.h>
+#include <LibDraw/CPUFeatures.h>
 #include <LibDraw/CharacterBitmap.h>
+#include <emmintrin.h>
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #pragma GCC optimize("O3")
@@ -25,6 +28,217 @@ static ALWAYS_INLINE Color get_pixel(const GraphicsBitmap& bitmap, int x, int y)
     return bitmap.get_pixel(x, y);
 }
 
+// The blend kernels below draw onto an opaque destination, which is what
+// Color::blend() reduces to when the destination alpha is 255:
+//
+//     out = (src * alpha + dst * (255 - alpha)) / 255
+//
+// i.e. the source is premultiplied by its alpha and added to what shows
+// through. The results are bit-identical to Color::blend().
+
+static ALWAYS_INLINE RGBA32 blend_over_opaque(RGBA32 dst, RGBA32 src, u32 alpha)
+{
+    u32 inverse_alpha = 255 - alpha;
+    u32 r = (((src >> 16) & 0xff) * alpha + ((dst >> 16) & 0xff) * inverse_alpha) / 255;
+    u32 g = (((src >> 8) & 0xff) * alpha + ((dst >> 8) & 0xff) * inverse_alpha) / 255;
+    u32 b = ((src & 0xff) * alpha + (dst & 0xff) * inverse_alpha) / 255;
+    return 0xff000000 | (r << 16) | (g << 8) | b;
+}
+
+// Blends two pixels, unpacked to one 16-bit lane per channel, with the alpha
+// of each already broadcast to all four of its lanes.
+__attribute__((target("sse2"))) static inline __m128i sse2_blend_unpacked(__m128i src, __m128i dst, __m128i alpha)
+{
+    __m128i inverse_alpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, inverse_alpha));
+    // x / 255 == (x * 0x8081) >> 23 for every x we can get here.
+    return _mm_srli_epi16(_mm_mulhi_epu16(sum, _mm_set1_epi16((short)0x8081)), 7);
+}
+
+// Returns how many pixels were blended: all of them but the last count % 4.
+__attribute__((target("sse2"))) static int sse2_blend_row_with_alpha(RGBA32* dst, const RGBA32* src, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i source = _mm_loadu_si128((const __m128i*)(src + x));
+        int opaque = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(source, alpha_mask), alpha_mask));
+        if (opaque == 0xffff) {
+            _mm_storeu_si128((__m128i*)(dst + x), source);
+            continue;
+        }
+        int transparent = _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(source, alpha_mask), zero));
+        if (transparent == 0xffff)
+            continue;
+
+        __m128i destination = _mm_loadu_si128((const __m128i*)(dst + x));
+        __m128i src_low = _mm_unpacklo_epi8(source, zero);
+        __m128i src_high = _mm_unpackhi_epi8(source, zero);
+        __m128i alpha_low = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src_low, 0xff), 0xff);
+        __m128i alpha_high = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src_high, 0xff), 0xff);
+        __m128i low = sse2_blend_unpacked(src_low, _mm_unpacklo_epi8(destination, zero), alpha_low);
+        __m128i high = sse2_blend_unpacked(src_high, _mm_unpackhi_epi8(destination, zero), alpha_high);
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_packus_epi16(low, high), alpha_mask));
+    }
+    return x;
+}
+
+__attribute__((target("sse2"))) static int sse2_blend_row_with_constant_alpha(RGBA32* dst, const RGBA32* src, int count, u8 alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+    const __m128i alpha_lanes = _mm_set1_epi16(alpha);
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i source = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i destination = _mm_loadu_si128((const __m128i*)(dst + x));
+        __m128i low = sse2_blend_unpacked(_mm_unpacklo_epi8(source, zero), _mm_unpacklo_epi8(destination, zero), alpha_lanes);
+        __m128i high = sse2_blend_unpacked(_mm_unpackhi_epi8(source, zero), _mm_unpackhi_epi8(destination, zero), alpha_lanes);
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_packus_epi16(low, high), alpha_mask));
+    }
+    return x;
+}
+
+// Blends each source pixel by its own alpha.
+static void blend_row_with_alpha(RGBA32* dst, const RGBA32* src, int count)
+{
+    int x = has_sse2() ? sse2_blend_row_with_alpha(dst, src, count) : 0;
+    for (; x < count; ++x) {
+        u32 alpha = src[x] >> 24;
+        if (alpha == 0xff)
+            dst[x] = src[x];
+        else if (alpha)
+            dst[x] = blend_over_opaque(dst[x], src[x], alpha);
+    }
+}
+
+// Blends every source pixel by the same alpha, ignoring its own.
+static void blend_row_with_constant_alpha(RGBA32* dst, const RGBA32* src, int count, u8 alpha)
+{
+    int x = has_sse2() ? sse2_blend_row_with_constant_alpha(dst, src, count, alpha) : 0;
+    for (; x < count; ++x)
+        dst[x] = blend_over_opaque(dst[x], src[x], alpha);
+}
+
+// What Color::to_grayscale().lightened() makes of a pixel, indexed by the sum
+// of its color channels.
+static const u8* dimmed_gray_table()
+{
+    static u8* s_table;
+    if (!s_table) {
+        s_table = new u8[3 * 255 + 1];
+        for (int sum = 0; sum <= 3 * 255; ++sum)
+            s_table[sum] = Color(sum / 3, sum / 3, sum / 3).lightened().red();
+    }
+    return s_table;
+}
+
+static void dim_row(RGBA32* dst, const RGBA32* src, int count)
+{
+    auto* table = dimmed_gray_table();
+    for (int x = 0; x < count; ++x) {
+        u32 gray = table[((src[x] >> 16) & 0xff) + ((src[x] >> 8) & 0xff) + (src[x] & 0xff)];
+        dst[x] = (src[x] & 0xff000000) | (gray << 16) | (gray << 8) | gray;
+    }
+}
+
+// Smooth scaling works on whole rows of source pixels. Pixels with an alpha
+// channel are premultiplied first, so fully transparent pixels don't bleed
+// their (meaningless) color into their neighbours.
+
+static ALWAYS_INLINE RGBA32 premultiplied(RGBA32 pixel)
+{
+    u32 alpha = pixel >> 24;
+    u32 r = ((pixel >> 16) & 0xff) * alpha / 255;
+    u32 g = ((pixel >> 8) & 0xff) * alpha / 255;
+    u32 b = (pixel & 0xff) * alpha / 255;
+    return (alpha << 24) | (r << 16) | (g << 8) | b;
+}
+
+static ALWAYS_INLINE RGBA32 unpremultiplied(RGBA32 pixel)
+{
+    u32 alpha = pixel >> 24;
+    if (!alpha)
+        return 0;
+    u32 r = min(255u, ((pixel >> 16) & 0xff) * 255 / alpha);
+    u32 g = min(255u, ((pixel >> 8) & 0xff) * 255 / alpha);
+    u32 b = min(255u, (pixel & 0xff) * 255 / alpha);
+    return (alpha << 24) | (r << 16) | (g << 8) | b;
+}
+
+static void premultiply_row(RGBA32* dst, const RGBA32* src, int count)
+{
+    for (int x = 0; x < count; ++x)
+        dst[x] = premultiplied(src[x]);
+}
+
+// (a * (256 - weight) + b * weight) / 256 for each channel, two channels
+// at a time: every product fits in 16 bits, so they can't carry into
+// each other.
+static ALWAYS_INLINE RGBA32 lerp_pixel(RGBA32 a, RGBA32 b, u32 weight)
+{
+    u32 inverse_weight = 256 - weight;
+    u32 red_blue = (((a & 0xff00ff) * inverse_weight + (b & 0xff00ff) * weight) >> 8) & 0xff00ff;
+    u32 alpha_green = (((a >> 8) & 0xff00ff) * inverse_weight + ((b >> 8) & 0xff00ff) * weight) & 0xff00ff00;
+    return red_blue | alpha_green;
+}
+
+// Returns how many pixels were interpolated: all of them but the last count % 4.
+__attribute__((target("sse2"))) static int sse2_lerp_rows(RGBA32* dst, const RGBA32* top, const RGBA32* bottom, int count, u32 weight)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i top_weight = _mm_set1_epi16(256 - weight);
+    const __m128i bottom_weight = _mm_set1_epi16(weight);
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(top + x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(bottom + x));
+        __m128i low = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), top_weight), _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), bottom_weight));
+        __m128i high = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), top_weight), _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), bottom_weight));
+        _mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(_mm_srli_epi16(low, 8), _mm_srli_epi16(high, 8)));
+    }
+    return x;
+}
+
+static void lerp_rows(RGBA32* dst, const RGBA32* top, const RGBA32* bottom, int count, u32 weight)
+{
+    int x = has_sse2() ? sse2_lerp_rows(dst, top, bottom, count, weight) : 0;
+    for (; x < count; ++x)
+        dst[x] = lerp_pixel(top[x], bottom[x], weight);
+}
+
+// Adds each channel of each pixel to its own 32-bit sum, four sums per pixel
+// in memory order (blue, green, red, alpha).
+// Returns how many pixels were added: all of them but the last count % 4.
+__attribute__((target("sse2"))) static int sse2_accumulate_row(u32* sums, const RGBA32* src, int count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i low = _mm_unpacklo_epi8(pixels, zero);
+        __m128i high = _mm_unpackhi_epi8(pixels, zero);
+        __m128i* s = (__m128i*)(sums + 4 * x);
+        _mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), _mm_unpacklo_epi16(low, zero)));
+        _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(low, zero)));
+        _mm_storeu_si128(s + 2, _mm_add_epi32(_mm_loadu_si128(s + 2), _mm_unpacklo_epi16(high, zero)));
+        _mm_storeu_si128(s + 3, _mm_add_epi32(_mm_loadu_si128(s + 3), _mm_unpackhi_epi16(high, zero)));
+    }
+    return x;
+}
+
+static void accumulate_row(u32* sums, const RGBA32* src, int count)
+{
+    int x = has_sse2() ? sse2_accumulate_row(sums, src, count) : 0;
+    for (; x < count; ++x) {
+        sums[4 * x] += src[x] & 0xff;
+        sums[4 * x + 1] += (src[x] >> 8) & 0xff;
+        sums[4 * x + 2] += (src[x] >> 16) & 0xff;
+        sums[4 * x + 3] += src[x] >> 24;
+    }
+}
+
 Painter::Painter(GraphicsBitmap& bitmap)
     : m_target(bitmap)
 {
@@ -245,22 +459,35 @@ void Painter::blit_scaled(const Rect& dst_rect_raw, const GraphicsBitmap& source
     RGBA32* dst = m_target->scanline(clipped_rect.y()) + clipped_rect.x();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
+    // Step through the source in 16.16 fixed point, rather than multiplying
+    // floats for every pixel. Every row samples the same columns, starting
+    // with the first one that isn't left of the source.
+    u32 hstep = hscale * 0x10000;
+    u32 vstep = vscale * 0x10000;
+    u32 source_width = source.size().width();
     int x_start = first_column + src_rect.left();
+    int x_end = x_start + clipped_rect.width();
+    int x_first = max(x_start, 0);
+    u64 first_position = (u64)x_first * hstep;
+    if (first_position >= (u64)source_width << 16)
+        return;
+
     for (int row = first_row; row <= last_row; ++row) {
-        int sr = (row + src_rect.top()) * vscale;
+        int sr = ((i64)(row + src_rect.top()) * vstep) >> 16;
         if (sr >= source.size().height() || sr < 0) {
             dst += dst_skip;
             continue;
         }
         const RGBA32* sl = source.scanline(sr);
-        for (int x = x_start; x < clipped_rect.width() + x_start; ++x) {
-            int sx = x * hscale;
-            if (sx < source.size().width() && sx >= 0)
-                dst[x - x_start] = sl[sx];
+        u32 position = first_position;
+        for (int x = x_first; x < x_end; ++x, position += hstep) {
+            u32 sx = position >> 16;
+            if (sx >= source_width)
+                break;
+            dst[x - x_start] = sl[sx];
         }
         dst += dst_skip;
     }
-    return;
 }
 
 void Painter::blit_with_opacity(const Point& position, const GraphicsBitmap& source, const Rect& src_rect, float opacity)
@@ -290,12 +517,7 @@ void Painter::blit_with_opacity(const Point& position, const GraphicsBitmap& sou
     const unsigned src_skip = source.pitch() / sizeof(RGBA32);
 
     for (int row = first_row; row <= last_row; ++row) {
-        for (int x = 0; x <= (last_column - first_column); ++x) {
-            Color src_color_with_alpha = Color::from_rgb(src[x]);
-            src_color_with_alpha.set_alpha(alpha);
-            Color dst_color = Color::from_rgb(dst[x]);
-            dst[x] = dst_color.blend(src_color_with_alpha).value();
-        }
+        blend_row_with_constant_alpha(dst, src, last_column - first_column + 1, alpha);
         dst += dst_skip;
         src += src_skip;
     }
@@ -317,6 +539,19 @@ void Painter::blit_dimmed(const Point& position, const GraphicsBitmap& source, c
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const size_t src_skip = source.pitch() / sizeof(RGBA32);
 
+    if (!m_target->has_alpha_channel()) {
+        int width = last_column - first_column + 1;
+        Vector<RGBA32, 256> dimmed_row;
+        dimmed_row.resize(width);
+        for (int row = first_row; row <= last_row; ++row) {
+            dim_row(dimmed_row.data(), src, width);
+            blend_row_with_alpha(dst, dimmed_row.data(), width);
+            dst += dst_skip;
+            src += src_skip;
+        }
+        return;
+    }
+
     for (int row = first_row; row <= last_row; ++row) {
         for (int x = 0; x <= (last_column - first_column); ++x) {
             u8 alpha = Color::from_rgba(src[x]).alpha();
@@ -414,6 +649,15 @@ void Painter::blit_with_alpha(const Point& position, const GraphicsBitmap& sourc
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const size_t src_skip = source.pitch() / sizeof(RGBA32);
 
+    if (!m_target->has_alpha_channel()) {
+        for (int row = first_row; row <= last_row; ++row) {
+            blend_row_with_alpha(dst, src, last_column - first_column + 1);
+            dst += dst_skip;
+            src += src_skip;
+        }
+        return;
+    }
+
     for (int row = first_row; row <= last_row; ++row) {
         for (int x = 0; x <= (last_column - first_column); ++x) {
             u8 alpha = Color::from_rgba(src[x]).alpha();
@@ -509,12 +753,16 @@ ALWAYS_INLINE static void do_draw_scaled_bitmap(GraphicsBitmap& target, const Re
         return do_draw_integer_scaled_bitmap<has_alpha_channel>(target, dst_rect, source, hfactor, vfactor, get_pixel);
     }
 
-    for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
+    // hscale and vscale are 16.16 fixed point, so step through the source
+    // by adding them rather than multiplying for every pixel.
+    int first_x_position = (clipped_rect.left() - dst_rect.x()) * hscale;
+    int y_position = (clipped_rect.top() - dst_rect.y()) * vscale;
+    for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y, y_position += vscale) {
         auto* scanline = (Color*)target.scanline(y);
-        for (int x = clipped_rect.left(); x <= clipped_rect.right(); ++x) {
-            auto scaled_x = ((x - dst_rect.x()) * hscale) >> 16;
-            auto scaled_y = ((y - dst_rect.y()) * vscale) >> 16;
-            auto src_pixel = get_pixel(source, scaled_x, scaled_y);
+        int scaled_y = src_rect.y() + (y_position >> 16);
+        int x_position = first_x_position;
+        for (int x = clipped_rect.left(); x <= clipped_rect.right(); ++x, x_position += hscale) {
+            auto src_pixel = get_pixel(source, src_rect.x() + (x_position >> 16), scaled_y);
 
             if constexpr (has_alpha_channel) {
                 scanline[x] = scanline[x].blend(src_pixel);
@@ -524,7 +772,148 @@ ALWAYS_INLINE static void do_draw_scaled_bitmap(GraphicsBitmap& target, const Re
     }
 }
 
-void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const GraphicsBitmap& source, const Rect& src_rect)
+// Where each destination pixel samples the source along one axis, in 16.16
+// fixed point: at the center of the pixel, so (i + 0.5) * scale - 0.5.
+struct BilinearSample {
+    int index;
+    int next_index;
+    u32 weight;
+};
+
+static void compute_bilinear_samples(Vector<BilinearSample>& samples, int first, int count, int src_size, int dst_size)
+{
+    int scale = (src_size << 16) / dst_size;
+    int position = first * scale + scale / 2 - 0x8000;
+    for (int i = 0; i < count; ++i, position += scale) {
+        int clamped_position = max(0, position);
+        int index = min(clamped_position >> 16, src_size - 1);
+        samples.append({ index, min(index + 1, src_size - 1), (u32)(clamped_position >> 8) & 0xff });
+    }
+}
+
+// Which source pixels each destination pixel covers along one axis:
+// [starts[i], max(starts[i + 1], starts[i] + 1)).
+static void compute_box_starts(Vector<int>& starts, int first, int count, int src_size, int dst_size)
+{
+    for (int i = first; i <= first + count; ++i)
+        starts.append(i * src_size / dst_size);
+}
+
+// Draws src_rect scaled to dst_rect, within clipped_rect. Shrinking averages
+// all the source pixels a destination pixel covers (a box filter), and
+// enlarging interpolates between the four closest ones (bilinear).
+static void draw_smooth_scaled_bitmap(GraphicsBitmap& target, const Rect& dst_rect, const Rect& clipped_rect, const GraphicsBitmap& source, const Rect& src_rect)
+{
+    bool has_alpha_channel = source.has_alpha_channel();
+    int first_column = clipped_rect.left() - dst_rect.left();
+    int first_row = clipped_rect.top() - dst_rect.top();
+    int width = clipped_rect.width();
+
+    Vector<RGBA32> output_row;
+    output_row.resize(width);
+    auto write_output_row = [&](int row) {
+        RGBA32* dst = target.scanline(clipped_rect.top() + row) + clipped_rect.left();
+        if (!has_alpha_channel) {
+            fast_u32_copy(dst, output_row.data(), width);
+        } else if (!target.has_alpha_channel()) {
+            blend_row_with_alpha(dst, output_row.data(), width);
+        } else {
+            for (int x = 0; x < width; ++x)
+                dst[x] = Color::from_rgba(dst[x]).blend(Color::from_rgba(output_row[x])).value();
+        }
+    };
+
+    if (dst_rect.width() >= src_rect.width() && dst_rect.height() >= src_rect.height()) {
+        Vector<BilinearSample> columns;
+        Vector<BilinearSample> rows;
+        compute_bilinear_samples(columns, first_column, width, src_rect.width(), dst_rect.width());
+        compute_bilinear_samples(rows, first_row, clipped_rect.height(), src_rect.height(), dst_rect.height());
+
+        // Only the source columns the clipped destination samples.
+        int span_start = columns.first().index;
+        int span_width = columns.last().next_index - span_start + 1;
+        Vector<RGBA32> top_row;
+        Vector<RGBA32> bottom_row;
+        Vector<RGBA32> lerped_row;
+        top_row.resize(span_width);
+        bottom_row.resize(span_width);
+        lerped_row.resize(span_width);
+
+        for (int row = 0; row < rows.size(); ++row) {
+            auto& sample = rows[row];
+            const RGBA32* top = source.scanline(src_rect.top() + sample.index) + src_rect.left() + span_start;
+            const RGBA32* bottom = source.scanline(src_rect.top() + sample.next_index) + src_rect.left() + span_start;
+            if (has_alpha_channel) {
+                premultiply_row(top_row.data(), top, span_width);
+                premultiply_row(bottom_row.data(), bottom, span_width);
+                top = top_row.data();
+                bottom = bottom_row.data();
+            }
+            lerp_rows(lerped_row.data(), top, bottom, span_width, sample.weight);
+            for (int x = 0; x < width; ++x) {
+                auto& column = columns[x];
+                RGBA32 pixel = lerp_pixel(lerped_row[column.index - span_start], lerped_row[column.next_index - span_start], column.weight);
+                output_row[x] = has_alpha_channel ? unpremultiplied(pixel) : (pixel | 0xff000000);
+            }
+            write_output_row(row);
+        }
+        return;
+    }
+
+    Vector<int> column_starts;
+    Vector<int> row_starts;
+    compute_box_starts(column_starts, first_column, width, src_rect.width(), dst_rect.width());
+    compute_box_starts(row_starts, first_row, clipped_rect.height(), src_rect.height(), dst_rect.height());
+
+    int span_start = column_starts.first();
+    int span_width = max(column_starts.last(), column_starts[width - 1] + 1) - span_start;
+    Vector<u32> sums;
+    Vector<RGBA32> premultiplied_row;
+    sums.resize(4 * span_width);
+    premultiplied_row.resize(span_width);
+
+    for (int row = 0; row < clipped_rect.height(); ++row) {
+        int top = row_starts[row];
+        int bottom = max(row_starts[row + 1], top + 1);
+        memset(sums.data(), 0, sums.size() * sizeof(u32));
+        for (int y = top; y < bottom; ++y) {
+            const RGBA32* src = source.scanline(src_rect.top() + y) + src_rect.left() + span_start;
+            if (has_alpha_channel) {
+                premultiply_row(premultiplied_row.data(), src, span_width);
+                src = premultiplied_row.data();
+            }
+            accumulate_row(sums.data(), src, span_width);
+        }
+
+        for (int x = 0; x < width; ++x) {
+            int left = column_starts[x];
+            int right = max(column_starts[x + 1], left + 1);
+            u64 b = 0;
+            u64 g = 0;
+            u64 r = 0;
+            u64 a = 0;
+            for (int i = left - span_start; i < right - span_start; ++i) {
+                b += sums[4 * i];
+                g += sums[4 * i + 1];
+                r += sums[4 * i + 2];
+                a += sums[4 * i + 3];
+            }
+            u32 count = (right - left) * (bottom - top);
+            if (!has_alpha_channel) {
+                output_row[x] = 0xff000000 | (u32)(r / count) << 16 | (u32)(g / count) << 8 | (u32)(b / count);
+            } else if (!a) {
+                output_row[x] = 0;
+            } else {
+                // The sums are premultiplied, so dividing by the summed alpha
+                // gives the average color weighted by how opaque each pixel is.
+                output_row[x] = (u32)(a / count) << 24 | (u32)min<u64>(255, r * 255 / a) << 16 | (u32)min<u64>(255, g * 255 / a) << 8 | (u32)min<u64>(255, b * 255 / a);
+            }
+        }
+        write_output_row(row);
+    }
+}
+
+void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const GraphicsBitmap& source, const Rect& src_rect, ScalingMode scaling_mode)
 {
     auto dst_rect = a_dst_rect;
     if (dst_rect.size() == src_rect.size())
@@ -537,6 +926,9 @@ void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const GraphicsBitmap& s
     if (clipped_rect.is_empty())
         return;
 
+    if (scaling_mode == ScalingMode::Smooth && (source.format() == GraphicsBitmap::Format::RGB32 || source.format() == GraphicsBitmap::Format::RGBA32))
+        return draw_smooth_scaled_bitmap(*m_target, dst_rect, clipped_rect, source, src_rect);
+
     int hscale = (src_rect.width() << 16) / dst_rect.width();
     int vscale = (src_rect.height() << 16) / dst_rect.height();
 
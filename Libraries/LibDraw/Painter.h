@@ -27,7 +27,14 @@ public:
     void draw_bitmap(const Point&, const GlyphBitmap&, Color = Color());
     void set_pixel(const Point&, Color);
     void draw_line(const Point&, const Point&, Color, int thickness = 1);
-    void draw_scaled_bitmap(const Rect& dst_rect, const GraphicsBitmap&, const Rect& src_rect);
+    enum class ScalingMode {
+        NearestNeighbor,
+        // Averages the covered source pixels when shrinking, and interpolates
+        // bilinearly when enlarging. Only for 32-bit bitmaps; others are
+        // scaled by nearest neighbor.
+        Smooth,
+    };
+    void draw_scaled_bitmap(const Rect& dst_rect, const GraphicsBitmap&, const Rect& src_rect, ScalingMode = ScalingMode::NearestNeighbor);
     void blit(const Point&, const GraphicsBitmap&, const Rect& src_rect, float opacity = 1.0f);
     void blit_dimmed(const Point&, const GraphicsBitmap&, const Rect& src_rect);
     void draw_tiled_bitmap(const Rect& dst_rect, const GraphicsBitmap&);
@@ -0,0 +1,65 @@
+#include <AK/FileSystemPath.h>
+#include <LibDraw/PNGLoader.h>
+#include <LibDraw/SharedImageCache.h>
+#include <SharedBuffer.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static SharedImageCache* s_the;
+static int s_thread_id;
+
+SharedImageCache* SharedImageCache::the()
+{
+    if (!s_the || gettid() != s_thread_id)
+        return nullptr;
+    return s_the;
+}
+
+void SharedImageCache::install(SharedImageCache& cache)
+{
+    s_the = &cache;
+    s_thread_id = gettid();
+}
+
+RefPtr<GraphicsBitmap> SharedImageCache::load(const StringView& requested_path)
+{
+    auto path = canonicalized_path(requested_path);
+    if (!path.starts_with("/res/"))
+        return load_png(requested_path);
+
+    struct stat st;
+    if (stat(path.characters(), &st) < 0)
+        return nullptr;
+
+    auto it = m_loaded_images.find(path);
+    if (it != m_loaded_images.end() && (*it).value.mtime == st.st_mtime)
+        return (*it).value.bitmap;
+
+    RefPtr<GraphicsBitmap> bitmap;
+    Entry entry;
+    if (lookup(path, st.st_mtime, entry))
+        bitmap = map(entry);
+
+    // Not shared (too big, or the directory is full), so decode a private copy.
+    if (!bitmap)
+        return load_png(path);
+
+    m_loaded_images.set(path, { st.st_mtime, bitmap });
+    return bitmap;
+}
+
+RefPtr<GraphicsBitmap> SharedImageCache::map(const Entry& entry)
+{
+    if (entry.format != GraphicsBitmap::Format::RGB32 && entry.format != GraphicsBitmap::Format::RGBA32)
+        return nullptr;
+    if (entry.size.is_empty())
+        return nullptr;
+    auto shared_buffer = SharedBuffer::create_from_shared_buffer_id(entry.shared_buffer_id);
+    if (!shared_buffer)
+        return nullptr;
+    int buffer_size = shared_buffer->size();
+    auto bitmap = GraphicsBitmap::create_with_shared_buffer(entry.format, shared_buffer.release_nonnull(), entry.size);
+    if (bitmap->size_in_bytes() > (size_t)buffer_size)
+        return nullptr;
+    return bitmap;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/String.h>
+#include <LibDraw/GraphicsBitmap.h>
+#include <sys/types.h>
+
+// Decoded system images in shared buffers, so that an image is decoded once
+// and every process maps those pixels instead of decoding a private copy.
+// Images are keyed by path and modification time. Subclasses say where the
+// shared directory of images lives: GUI processes ask the WindowServer, which
+// decodes every shared image itself and keeps it for as long as it runs.
+//
+// Only small images under /res get shared: icons, cursors and the like, which
+// lots of processes load and nobody draws into. Shared bitmaps are sealed, so
+// drawing into one faults; load_png() still decodes a private, writable copy.
+class SharedImageCache {
+public:
+    struct Entry {
+        int shared_buffer_id { -1 };
+        GraphicsBitmap::Format format { GraphicsBitmap::Format::Invalid };
+        Size size;
+    };
+
+    static const int max_shared_pixel_count = 256 * 256;
+
+    virtual ~SharedImageCache() {}
+
+    // The cache that GraphicsBitmap::load_from_file() goes through, if one has
+    // been installed by this thread. Other threads can't safely talk to it.
+    static SharedImageCache* the();
+    static void install(SharedImageCache&);
+
+    RefPtr<GraphicsBitmap> load(const StringView& path);
+
+protected:
+    virtual bool lookup(const String& path, time_t mtime, Entry&) = 0;
+
+private:
+    RefPtr<GraphicsBitmap> map(const Entry&);
+
+    // Everything this process has loaded through the cache, so that loading
+    // the same image again doesn't even have to ask.
+    struct LoadedImage {
+        time_t mtime { 0 };
+        RefPtr<GraphicsBitmap> bitmap;
+    };
+    HashMap<String, LoadedImage> m_loaded_images;
+};
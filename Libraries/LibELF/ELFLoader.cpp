@@ -133,13 +133,20 @@ String ELFLoader::symbolicate(u32 address) const
     sorted_symbols = m_sorted_symbols.data();
 #endif
 
-    for (size_t i = 0; i < m_image.symbol_count(); ++i) {
-        if (sorted_symbols[i].address > address) {
-            if (i == 0)
-                return "!!";
-            auto& symbol = sorted_symbols[i - 1];
-            return String::format("%s +%u", symbol.name, address - symbol.address);
-        }
+    // Find the first symbol past the address, the one before it contains it.
+    size_t low = 0;
+    size_t high = m_image.symbol_count();
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (sorted_symbols[middle].address > address)
+            high = middle;
+        else
+            low = middle + 1;
     }
-    return "??";
+    if (low == m_image.symbol_count())
+        return "??";
+    if (low == 0)
+        return "!!";
+    auto& symbol = sorted_symbols[low - 1];
+    return String::format("%s +%u", symbol.name, address - symbol.address);
 }
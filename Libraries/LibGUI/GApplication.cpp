@@ -3,6 +3,7 @@
 #include <LibGUI/GLabel.h>
 #include <LibGUI/GMenuBar.h>
 #include <LibGUI/GPainter.h>
+#include <LibGUI/GSharedImageCache.h>
 #include <LibGUI/GWindow.h>
 #include <LibGUI/GWindowServerConnection.h>
 #include <WindowServer/WSAPITypes.h>
@@ -23,6 +24,7 @@ GApplication::GApplication(int argc, char** argv)
     s_the = this;
     m_event_loop = make<CEventLoop>();
     GWindowServerConnection::the();
+    SharedImageCache::install(GSharedImageCache::the());
     if (argc > 0)
         m_invoked_as = argv[0];
     for (int i = 1; i < argc; i++)
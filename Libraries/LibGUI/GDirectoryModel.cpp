@@ -3,6 +3,7 @@
 #include <AK/StringBuilder.h>
 #include <LibCore/CDirIterator.h>
 #include <LibDraw/GraphicsBitmap.h>
+#include <LibDraw/PNGLoader.h>
 #include <LibGUI/GPainter.h>
 #include <LibThread/BackgroundAction.h>
 #include <dirent.h>
@@ -13,14 +14,16 @@
 
 static HashMap<String, RefPtr<GraphicsBitmap>> s_thumbnail_cache;
 
+// This runs on a background thread, and only keeps the scaled down copy, so
+// there's no point going through the shared image cache.
 static RefPtr<GraphicsBitmap> render_thumbnail(const StringView& path)
 {
-    auto png_bitmap = GraphicsBitmap::load_from_file(path);
+    auto png_bitmap = load_png(path);
     if (!png_bitmap)
         return nullptr;
     auto thumbnail = GraphicsBitmap::create(png_bitmap->format(), { 32, 32 });
     Painter painter(*thumbnail);
-    painter.draw_scaled_bitmap(thumbnail->rect(), *png_bitmap, png_bitmap->rect());
+    painter.draw_scaled_bitmap(thumbnail->rect(), *png_bitmap, png_bitmap->rect(), Painter::ScalingMode::Smooth);
     return thumbnail;
 }
 
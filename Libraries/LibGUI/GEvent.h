@@ -34,6 +34,7 @@ public:
         WindowCloseRequest,
         ContextMenu,
         EnabledChange,
+        FrameDone,
 
         __Begin_WM_Events,
         WM_WindowRemoved,
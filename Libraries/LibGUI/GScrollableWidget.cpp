@@ -1,22 +1,25 @@
 #include <LibGUI/GScrollBar.h>
 #include <LibGUI/GScrollableWidget.h>
+#include <LibGUI/GWindow.h>
 
 GScrollableWidget::GScrollableWidget(GWidget* parent)
     : GFrame(parent)
 {
     m_vertical_scrollbar = GScrollBar::construct(Orientation::Vertical, this);
     m_vertical_scrollbar->set_step(4);
-    m_vertical_scrollbar->on_change = [this](int) {
+    m_vertical_scrollbar->on_change = [this](int value) {
+        scroll_contents_by({ 0, m_painted_scroll_position.y() - value });
+        m_painted_scroll_position.set_y(value);
         did_scroll();
-        update();
     };
 
     m_horizontal_scrollbar = GScrollBar::construct(Orientation::Horizontal, this);
     m_horizontal_scrollbar->set_step(4);
     m_horizontal_scrollbar->set_big_step(30);
-    m_horizontal_scrollbar->on_change = [this](int) {
+    m_horizontal_scrollbar->on_change = [this](int value) {
+        scroll_contents_by({ m_painted_scroll_position.x() - value, 0 });
+        m_painted_scroll_position.set_x(value);
         did_scroll();
-        update();
     };
 
     m_corner_widget = GWidget::construct(this);
@@ -27,6 +30,32 @@ GScrollableWidget::~GScrollableWidget()
 {
 }
 
+// Moves the contents that are already painted, so only what scrolls into view
+// has to be painted again. Fixed elements along the top and left edges (like
+// column headers or a ruler) stay put in the direction they're fixed in.
+void GScrollableWidget::scroll_contents_by(const Point& delta)
+{
+    auto* window = this->window();
+    if (!window || !is_visible() || !updates_enabled() || !can_copy_on_scroll()) {
+        update();
+        return;
+    }
+
+    auto rect = widget_inner_rect();
+    int fixed_width = delta.x() ? m_size_occupied_by_fixed_elements.width() : 0;
+    int fixed_height = delta.y() ? m_size_occupied_by_fixed_elements.height() : 0;
+    rect = { rect.x() + fixed_width, rect.y() + fixed_height, rect.width() - fixed_width, rect.height() - fixed_height };
+    rect.move_by(window_relative_rect().location());
+    for (auto* ancestor = parent_widget(); ancestor; ancestor = ancestor->parent_widget()) {
+        if (!ancestor->is_visible() || !ancestor->updates_enabled()) {
+            update();
+            return;
+        }
+        rect.intersect(ancestor->window_relative_rect());
+    }
+    window->scroll_rect(rect, delta);
+}
+
 void GScrollableWidget::mousewheel_event(GMouseEvent& event)
 {
     // FIXME: The wheel delta multiplier should probably come from... somewhere?
@@ -50,17 +50,23 @@ protected:
     virtual void resize_event(GResizeEvent&) override;
     virtual void mousewheel_event(GMouseEvent&) override;
     virtual void did_scroll() {}
+    // Return false if what's painted depends on where the viewport is, not just
+    // on the scroll position, so moving it on screen wouldn't be right.
+    virtual bool can_copy_on_scroll() const { return true; }
     void set_content_size(const Size&);
     void set_size_occupied_by_fixed_elements(const Size&);
 
 private:
     void update_scrollbar_ranges();
+    void scroll_contents_by(const Point& delta);
 
     RefPtr<GScrollBar> m_vertical_scrollbar;
     RefPtr<GScrollBar> m_horizontal_scrollbar;
     RefPtr<GWidget> m_corner_widget;
     Size m_content_size;
     Size m_size_occupied_by_fixed_elements;
+    // The scrollbar values the contents on screen were painted at.
+    Point m_painted_scroll_position;
     bool m_scrollbars_enabled { true };
     bool m_should_hide_unnecessary_scrollbars { false };
 };
@@ -0,0 +1,34 @@
+#include <LibGUI/GSharedImageCache.h>
+#include <LibGUI/GWindowServerConnection.h>
+#include <WindowServer/WSAPITypes.h>
+#include <string.h>
+
+GSharedImageCache& GSharedImageCache::the()
+{
+    static GSharedImageCache* s_the;
+    if (!s_the)
+        s_the = new GSharedImageCache;
+    return *s_the;
+}
+
+GSharedImageCache::GSharedImageCache()
+{
+}
+
+bool GSharedImageCache::lookup(const String& path, time_t mtime, Entry& entry)
+{
+    WSAPI_ClientMessage request;
+    if (path.length() >= (int)sizeof(request.text))
+        return false;
+    request.type = WSAPI_ClientMessage::Type::GetSharedImage;
+    memcpy(request.text, path.characters(), path.length() + 1);
+    request.text_length = path.length();
+    request.image.mtime = mtime;
+    auto response = GWindowServerConnection::the().sync_request(request, WSAPI_ServerMessage::Type::DidGetSharedImage);
+    if (response.image.shared_buffer_id < 0)
+        return false;
+    entry.shared_buffer_id = response.image.shared_buffer_id;
+    entry.format = response.image.has_alpha_channel ? GraphicsBitmap::Format::RGBA32 : GraphicsBitmap::Format::RGB32;
+    entry.size = response.image.size;
+    return true;
+}
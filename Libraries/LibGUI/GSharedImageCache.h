@@ -0,0 +1,14 @@
+#pragma once
+
+#include <LibDraw/SharedImageCache.h>
+
+// Looks system images up in the WindowServer's directory of shared images.
+class GSharedImageCache final : public SharedImageCache {
+public:
+    static GSharedImageCache& the();
+
+private:
+    GSharedImageCache();
+
+    virtual bool lookup(const String& path, time_t mtime, Entry&) override;
+};
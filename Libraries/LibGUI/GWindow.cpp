@@ -4,6 +4,7 @@
 #include <LibC/SharedBuffer.h>
 #include <LibC/stdio.h>
 #include <LibC/stdlib.h>
+#include <LibC/string.h>
 #include <LibC/unistd.h>
 #include <LibDraw/GraphicsBitmap.h>
 #include <LibGUI/GApplication.h>
@@ -99,6 +100,10 @@ void GWindow::hide()
     GWindowServerConnection::the().sync_request(request, WSAPI_ServerMessage::Type::DidDestroyWindow);
     m_window_id = 0;
     m_pending_paint_event_rects.clear();
+    m_unpainted_rects.clear();
+    m_pending_scroll_rect = {};
+    m_scrolled_rects.clear();
+    m_waiting_for_frame_done = false;
     m_back_bitmap = nullptr;
     m_front_bitmap = nullptr;
 
@@ -246,15 +251,27 @@ void GWindow::event(CEvent& event)
             rects.clear();
             rects.append({ {}, paint_event.window_size() });
         }
+        if (created_new_backing_store) {
+            m_pending_scroll_rect = {};
+            m_scrolled_rects.clear();
+        }
 
+        for (auto& rect : rects)
+            m_unpainted_rects = m_unpainted_rects.shatter(rect);
         for (auto& rect : rects)
             m_main_widget->dispatch_event(*make<GPaintEvent>(rect), this);
 
         paint_keybinds();
 
-        if (m_double_buffering_enabled)
+        m_waiting_for_frame_done = true;
+
+        if (m_double_buffering_enabled) {
+            // The flip carries the damage, so there's nothing more to tell the server.
             flip(rects);
-        else if (created_new_backing_store)
+            return;
+        }
+
+        if (created_new_backing_store)
             set_current_backing_bitmap(*m_back_bitmap, true);
 
         if (m_window_id) {
@@ -342,6 +359,12 @@ void GWindow::event(CEvent& event)
         return;
     }
 
+    if (event.type() == GEvent::FrameDone) {
+        m_waiting_for_frame_done = false;
+        flush_pending_paint_event_rects();
+        return;
+    }
+
     if (event.type() == GEvent::Resize) {
         auto new_size = static_cast<GResizeEvent&>(event).size();
         if (m_back_bitmap && m_back_bitmap->size() != new_size)
@@ -441,6 +464,9 @@ void GWindow::update(const Rect& a_rect)
     if (!m_window_id)
         return;
 
+    m_unpainted_rects.add(a_rect.is_empty() ? Rect { {}, m_rect_when_windowless.size() } : a_rect);
+    m_unpainted_rects.simplify(WSAPI_ClientMessage::max_inline_rect_count);
+
     for (auto& pending_rect : m_pending_paint_event_rects) {
         if (pending_rect.contains(a_rect)) {
 #ifdef UPDATE_COALESCING_DEBUG
@@ -450,26 +476,73 @@ void GWindow::update(const Rect& a_rect)
         }
     }
 
-    if (m_pending_paint_event_rects.is_empty()) {
+    if (m_pending_paint_event_rects.is_empty() && !m_waiting_for_frame_done) {
         deferred_invoke([this](auto&) {
-            auto rects = move(m_pending_paint_event_rects);
-            if (rects.is_empty())
-                return;
-            WSAPI_ClientMessage request;
-            request.type = WSAPI_ClientMessage::Type::InvalidateRect;
-            request.window_id = m_window_id;
-            for (int i = 0; i < min(WSAPI_ClientMessage::max_inline_rect_count, rects.size()); ++i)
-                request.rects[i] = rects[i];
-            ByteBuffer extra_data;
-            if (rects.size() > WSAPI_ClientMessage::max_inline_rect_count)
-                extra_data = ByteBuffer::wrap(&rects[WSAPI_ClientMessage::max_inline_rect_count], (rects.size() - WSAPI_ClientMessage::max_inline_rect_count) * sizeof(WSAPI_Rect));
-            request.rect_count = rects.size();
-            GWindowServerConnection::the().post_message_to_server(request, move(extra_data));
+            flush_pending_paint_event_rects();
         });
     }
     m_pending_paint_event_rects.append(a_rect);
 }
 
+void GWindow::scroll_rect(const Rect& a_rect, const Point& delta)
+{
+    if (!m_window_id || delta.is_null())
+        return;
+    if (!m_double_buffering_enabled || !m_back_bitmap) {
+        update(a_rect);
+        return;
+    }
+    auto rect = a_rect.intersected(m_back_bitmap->rect());
+    auto destination = rect.intersected(rect.translated(delta));
+    if (destination.is_empty()) {
+        update(rect);
+        return;
+    }
+
+    // Like memmove, go through the rows in the order that doesn't overwrite
+    // any before they've been copied.
+    auto source = destination.translated(-delta);
+    for (int row = 0; row < destination.height(); ++row) {
+        int i = delta.y() > 0 ? destination.height() - 1 - row : row;
+        memmove(m_back_bitmap->scanline(destination.y() + i) + destination.x(), m_back_bitmap->scanline(source.y() + i) + source.x(), destination.width() * sizeof(RGBA32));
+    }
+
+    if (m_pending_scroll_rect.is_empty() && m_scrolled_rects.is_empty()) {
+        m_pending_scroll_rect = rect;
+        m_pending_scroll_delta = delta;
+    } else {
+        m_scrolled_rects.add(m_pending_scroll_rect);
+        m_scrolled_rects.add(rect);
+        m_pending_scroll_rect = {};
+    }
+
+    // Whatever moved in that hadn't been painted yet is still stale.
+    auto stale_rects = m_unpainted_rects.intersected(source).translated(delta);
+    for (auto& exposed_rect : rect.shatter(destination))
+        update(exposed_rect);
+    for (auto& stale_rect : stale_rects.rects())
+        update(stale_rect);
+}
+
+void GWindow::flush_pending_paint_event_rects()
+{
+    if (!m_window_id || m_waiting_for_frame_done)
+        return;
+    auto rects = move(m_pending_paint_event_rects);
+    if (rects.is_empty())
+        return;
+    WSAPI_ClientMessage request;
+    request.type = WSAPI_ClientMessage::Type::InvalidateRect;
+    request.window_id = m_window_id;
+    for (int i = 0; i < min(WSAPI_ClientMessage::max_inline_rect_count, rects.size()); ++i)
+        request.rects[i] = rects[i];
+    ByteBuffer extra_data;
+    if (rects.size() > WSAPI_ClientMessage::max_inline_rect_count)
+        extra_data = ByteBuffer::wrap(&rects[WSAPI_ClientMessage::max_inline_rect_count], (rects.size() - WSAPI_ClientMessage::max_inline_rect_count) * sizeof(WSAPI_Rect));
+    request.rect_count = rects.size();
+    GWindowServerConnection::the().post_message_to_server(request, move(extra_data));
+}
+
 void GWindow::set_main_widget(GWidget* widget)
 {
     if (m_main_widget == widget)
@@ -576,8 +649,9 @@ void GWindow::set_hovered_widget(GWidget* widget)
         CEventLoop::current().post_event(*m_hovered_widget, make<GEvent>(GEvent::Enter));
 }
 
-void GWindow::set_current_backing_bitmap(GraphicsBitmap& bitmap, bool flush_immediately)
+void GWindow::set_current_backing_bitmap(GraphicsBitmap& bitmap, bool flush_immediately, const DisjointRectSet& dirty_rects, const Rect& scroll_rect, const Point& scroll_delta)
 {
+    ASSERT(dirty_rects.size() <= WSAPI_ClientMessage::max_inline_rect_count);
     WSAPI_ClientMessage message;
     message.type = WSAPI_ClientMessage::Type::SetWindowBackingStore;
     message.window_id = m_window_id;
@@ -587,6 +661,11 @@ void GWindow::set_current_backing_bitmap(GraphicsBitmap& bitmap, bool flush_imme
     message.backing.has_alpha_channel = bitmap.has_alpha_channel();
     message.backing.size = bitmap.size();
     message.backing.flush_immediately = flush_immediately;
+    message.backing.scroll_rect = scroll_rect;
+    message.backing.scroll_delta = scroll_delta;
+    message.rect_count = dirty_rects.size();
+    for (int i = 0; i < dirty_rects.size(); ++i)
+        message.rects[i] = dirty_rects.rects()[i];
     GWindowServerConnection::the().sync_request(message, WSAPI_ServerMessage::Type::DidSetWindowBackingStore);
 }
 
@@ -594,7 +673,18 @@ void GWindow::flip(const Vector<Rect, 32>& dirty_rects)
 {
     swap(m_front_bitmap, m_back_bitmap);
 
-    set_current_backing_bitmap(*m_front_bitmap);
+    // Paint rects often overlap, so coalesce them before copying anything,
+    // and send the server only as many as fit in the flip message.
+    DisjointRectSet damage;
+    for (auto& dirty_rect : dirty_rects)
+        damage.add(dirty_rect.intersected(m_front_bitmap->rect()));
+    damage.add(m_scrolled_rects.intersected(m_front_bitmap->rect()));
+    damage.simplify(WSAPI_ClientMessage::max_inline_rect_count);
+    auto copied_rect = m_pending_scroll_rect.intersected(m_front_bitmap->rect());
+    m_pending_scroll_rect = {};
+    m_scrolled_rects.clear();
+
+    set_current_backing_bitmap(*m_front_bitmap, false, damage, copied_rect, m_pending_scroll_delta);
 
     if (!m_back_bitmap || m_back_bitmap->size() != m_front_bitmap->size()) {
         m_back_bitmap = create_backing_bitmap(m_front_bitmap->size());
@@ -602,10 +692,14 @@ void GWindow::flip(const Vector<Rect, 32>& dirty_rects)
         return;
     }
 
-    // Copy whatever was painted from the front to the back.
-    Painter painter(*m_back_bitmap);
-    for (auto& dirty_rect : dirty_rects)
-        painter.blit(dirty_rect.location(), *m_front_bitmap, dirty_rect);
+    // Copy whatever was painted from the front to the back, so the back is
+    // current again. This is a plain copy: blitting would blend translucent
+    // pixels over stale ones.
+    damage.add(copied_rect);
+    for (auto& rect : damage.rects()) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y)
+            fast_u32_copy(m_back_bitmap->scanline(y) + rect.x(), m_front_bitmap->scanline(y) + rect.x(), rect.width());
+    }
 }
 
 NonnullRefPtr<GraphicsBitmap> GWindow::create_shared_bitmap(GraphicsBitmap::Format format, const Size& size)
@@ -4,6 +4,7 @@
 #include <AK/HashMap.h>
 #include <AK/WeakPtr.h>
 #include <LibCore/CObject.h>
+#include <LibDraw/DisjointRectSet.h>
 #include <LibDraw/GraphicsBitmap.h>
 #include <LibDraw/Rect.h>
 #include <LibGUI/GWindowType.h>
@@ -101,6 +102,11 @@ public:
 
     void update(const Rect& = Rect());
 
+    // Moves the contents of rect by delta, clipped to the rect, and updates
+    // whatever that exposes. With double buffering the pixels are copied
+    // instead of painted again, and the server copies them on screen too.
+    void scroll_rect(const Rect&, const Point& delta);
+
     void set_global_cursor_tracking_widget(GWidget*);
     GWidget* global_cursor_tracking_widget() { return m_global_cursor_tracking_widget.ptr(); }
     const GWidget* global_cursor_tracking_widget() const { return m_global_cursor_tracking_widget.ptr(); }
@@ -146,8 +152,9 @@ private:
 
     NonnullRefPtr<GraphicsBitmap> create_backing_bitmap(const Size&);
     NonnullRefPtr<GraphicsBitmap> create_shared_bitmap(GraphicsBitmap::Format, const Size&);
-    void set_current_backing_bitmap(GraphicsBitmap&, bool flush_immediately = false);
+    void set_current_backing_bitmap(GraphicsBitmap&, bool flush_immediately = false, const DisjointRectSet& dirty_rects = {}, const Rect& scroll_rect = {}, const Point& scroll_delta = {});
     void flip(const Vector<Rect, 32>& dirty_rects);
+    void flush_pending_paint_event_rects();
 
     RefPtr<GraphicsBitmap> m_front_bitmap;
     RefPtr<GraphicsBitmap> m_back_bitmap;
@@ -162,6 +169,17 @@ private:
     Rect m_rect_when_windowless;
     String m_title_when_windowless;
     Vector<Rect, 32> m_pending_paint_event_rects;
+    // Everything updated but not painted yet, so scrolling can tell which
+    // of the pixels it moves are stale.
+    DisjointRectSet m_unpainted_rects;
+    // Scrolls done in the back bitmap since the last flip. The server can
+    // only repeat one of them on screen; the rest are sent as damage.
+    Rect m_pending_scroll_rect;
+    Point m_pending_scroll_delta;
+    DisjointRectSet m_scrolled_rects;
+    // Set from the time we hand the server a frame until it has been composed.
+    // Invalidations wait until then, so we don't paint faster than the screen.
+    bool m_waiting_for_frame_done { false };
     Size m_size_increment;
     Size m_base_size;
     Color m_background_color { Color::WarmGray };
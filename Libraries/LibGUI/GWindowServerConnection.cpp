@@ -77,6 +77,11 @@ void GWindowServerConnection::handle_window_close_request_event(const WSAPI_Serv
     CEventLoop::current().post_event(window, make<GEvent>(GEvent::WindowCloseRequest));
 }
 
+void GWindowServerConnection::handle_frame_done_event(const WSAPI_ServerMessage&, GWindow& window)
+{
+    CEventLoop::current().post_event(window, make<GEvent>(GEvent::FrameDone));
+}
+
 void GWindowServerConnection::handle_window_entered_or_left_event(const WSAPI_ServerMessage& message, GWindow& window)
 {
     CEventLoop::current().post_event(window, make<GEvent>(message.type == WSAPI_ServerMessage::Type::WindowEntered ? GEvent::WindowEntered : GEvent::WindowLeft));
@@ -281,6 +286,9 @@ void GWindowServerConnection::postprocess_bundles(Vector<IncomingMessageBundle>&
         case WSAPI_ServerMessage::Type::WindowCloseRequest:
             handle_window_close_request_event(event, *window);
             break;
+        case WSAPI_ServerMessage::Type::FrameDone:
+            handle_frame_done_event(event, *window);
+            break;
         case WSAPI_ServerMessage::Type::KeyDown:
         case WSAPI_ServerMessage::Type::KeyUp:
             handle_key_event(event, *window);
@@ -28,6 +28,7 @@ private:
     void handle_key_event(const WSAPI_ServerMessage&, GWindow&);
     void handle_window_activation_event(const WSAPI_ServerMessage&, GWindow&);
     void handle_window_close_request_event(const WSAPI_ServerMessage&, GWindow&);
+    void handle_frame_done_event(const WSAPI_ServerMessage&, GWindow&);
     void handle_menu_event(const WSAPI_ServerMessage&);
     void handle_window_entered_or_left_event(const WSAPI_ServerMessage&, GWindow&);
     void handle_wm_event(const WSAPI_ServerMessage&, GWindow&);
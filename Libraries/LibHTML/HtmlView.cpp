@@ -135,6 +135,13 @@ void HtmlView::paint_event(GPaintEvent& event)
     layout_root()->render(context);
 }
 
+// The background image is tiled from the corner of the viewport, so it
+// doesn't move along with the rest of the page.
+bool HtmlView::can_copy_on_scroll() const
+{
+    return !document() || !document()->background_image();
+}
+
 void HtmlView::mousemove_event(GMouseEvent& event)
 {
     if (!layout_root())
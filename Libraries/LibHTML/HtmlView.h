@@ -45,6 +45,7 @@ protected:
     virtual void mousedown_event(GMouseEvent&) override;
     virtual void mouseup_event(GMouseEvent&) override;
     virtual void keydown_event(GKeyEvent&) override;
+    virtual bool can_copy_on_scroll() const override;
 
 private:
     void layout_and_sync_size();
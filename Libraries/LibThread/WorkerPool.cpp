@@ -0,0 +1,94 @@
+#include <LibThread/WorkerPool.h>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// Idle workers block reading the wake pipe, and the caller blocks reading
+// the done pipe until every worker it woke has written to it.
+
+static void read_bytes(int fd, int count)
+{
+    char buffer[16];
+    while (count > 0) {
+        int nread = read(fd, buffer, min(count, (int)sizeof(buffer)));
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("WorkerPool: read");
+            ASSERT_NOT_REACHED();
+        }
+        count -= nread;
+    }
+}
+
+static void write_bytes(int fd, int count)
+{
+    char buffer[16] = {};
+    while (count > 0) {
+        int nwritten = write(fd, buffer, min(count, (int)sizeof(buffer)));
+        if (nwritten < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("WorkerPool: write");
+            ASSERT_NOT_REACHED();
+        }
+        count -= nwritten;
+    }
+}
+
+LibThread::WorkerPool::WorkerPool(int thread_count)
+{
+    if (thread_count <= 0)
+        return;
+
+    if (pipe(m_wake_fds) < 0 || pipe(m_done_fds) < 0) {
+        perror("WorkerPool: pipe");
+        ASSERT_NOT_REACHED();
+    }
+
+    for (int i = 0; i < thread_count; ++i) {
+        auto* thread = &Thread::construct([this] { return worker_main(); }).leak_ref();
+        thread->set_name("Worker thread");
+        thread->start();
+        m_threads.append(thread);
+    }
+}
+
+int LibThread::WorkerPool::worker_main()
+{
+    for (;;) {
+        read_bytes(m_wake_fds[0], 1);
+        run_jobs();
+        write_bytes(m_done_fds[1], 1);
+    }
+    ASSERT_NOT_REACHED();
+}
+
+void LibThread::WorkerPool::run_jobs()
+{
+    for (;;) {
+        int index = m_next_job.fetch_add(1);
+        if (index >= m_job_count)
+            return;
+        (*m_job)(index);
+    }
+}
+
+void LibThread::WorkerPool::run(int job_count, Function<void(int)> job)
+{
+    if (job_count <= 0)
+        return;
+
+    m_job = &job;
+    m_job_count = job_count;
+    m_next_job.store(0);
+
+    // The calling thread takes a share of the jobs too.
+    int woken_count = min(thread_count(), job_count - 1);
+    write_bytes(m_wake_fds[1], woken_count);
+    run_jobs();
+    read_bytes(m_done_fds[0], woken_count);
+
+    m_job = nullptr;
+    m_job_count = 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/Vector.h>
+#include <LibThread/Thread.h>
+
+namespace LibThread {
+
+// A fixed set of threads for splitting up work that the caller has to wait
+// for anyway, like painting different parts of the screen.
+// The threads run for the rest of the process, like the background thread.
+class WorkerPool {
+public:
+    explicit WorkerPool(int thread_count);
+
+    int thread_count() const { return m_threads.size(); }
+
+    // Calls job(0) through job(job_count - 1), spread over the pool's threads
+    // and the calling thread, and returns once all of them have returned.
+    void run(int job_count, Function<void(int)> job);
+
+private:
+    int worker_main();
+    void run_jobs();
+
+    Vector<Thread*> m_threads;
+    int m_wake_fds[2] { -1, -1 };
+    int m_done_fds[2] { -1, -1 };
+    Function<void(int)>* m_job { nullptr };
+    int m_job_count { 0 };
+    AK::Atomic<int> m_next_job { 0 };
+};
+
+}
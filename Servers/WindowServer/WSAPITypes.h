@@ -113,6 +113,9 @@ struct WSAPI_ServerMessage {
         ScreenRectChanged,
         ClipboardContentsChanged,
         DidSetFullscreen,
+        FrameDone,
+        DidGetCompositorStatistics,
+        DidGetSharedImage,
 
         __Begin_WM_Events__,
         WM_WindowRemoved,
@@ -194,6 +197,23 @@ struct WSAPI_ServerMessage {
             int shared_buffer_id;
             int contents_size;
         } clipboard;
+        struct {
+            unsigned frame_rate;
+            unsigned frame_count;
+            unsigned frame_sample_count;
+            unsigned last_compose_us;
+            unsigned last_flush_us;
+            unsigned last_rect_count;
+            unsigned average_compose_us;
+            unsigned average_flush_us;
+            unsigned max_compose_us;
+            unsigned max_flush_us;
+        } compositor;
+        struct {
+            int shared_buffer_id;
+            WSAPI_Size size;
+            bool has_alpha_channel;
+        } image;
     };
 };
 
@@ -238,6 +258,8 @@ struct WSAPI_ClientMessage {
         MoveWindowToFront,
         SetWindowIconBitmap,
         SetFullscreen,
+        GetCompositorStatistics,
+        GetSharedImage,
     };
     Type type { Invalid };
     int window_id { -1 };
@@ -302,6 +324,9 @@ struct WSAPI_ClientMessage {
             int shared_buffer_id;
             bool has_alpha_channel;
             bool flush_immediately;
+            // Contents of this rect scrolled by delta since the last flip.
+            WSAPI_Rect scroll_rect;
+            WSAPI_Point scroll_delta;
         } backing;
         struct {
             int shared_buffer_id;
@@ -310,6 +335,9 @@ struct WSAPI_ClientMessage {
         struct {
             WSAPI_StandardCursor cursor;
         } cursor;
+        struct {
+            unsigned mtime;
+        } image;
     };
 };
 
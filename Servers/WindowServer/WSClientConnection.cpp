@@ -6,6 +6,7 @@
 #include <WindowServer/WSClipboard.h>
 #include <WindowServer/WSCompositor.h>
 #include <WindowServer/WSEventLoop.h>
+#include <WindowServer/WSImageCache.h>
 #include <WindowServer/WSMenu.h>
 #include <WindowServer/WSMenuBar.h>
 #include <WindowServer/WSMenuItem.h>
@@ -288,9 +289,17 @@ bool WSClientConnection::handle_message(const WSAPI_ClientMessage& message, cons
     case WSAPI_ClientMessage::Type::GetWindowBackingStore:
         CEventLoop::current().post_event(*this, make<WSAPIGetWindowBackingStoreRequest>(client_id(), message.window_id));
         break;
-    case WSAPI_ClientMessage::Type::SetWindowBackingStore:
-        CEventLoop::current().post_event(*this, make<WSAPISetWindowBackingStoreRequest>(client_id(), message.window_id, message.backing.shared_buffer_id, message.backing.size, message.backing.bpp, message.backing.pitch, message.backing.has_alpha_channel, message.backing.flush_immediately));
+    case WSAPI_ClientMessage::Type::SetWindowBackingStore: {
+        if (message.rect_count < 0 || message.rect_count > WSAPI_ClientMessage::max_inline_rect_count) {
+            did_misbehave();
+            return false;
+        }
+        Vector<Rect, 32> dirty_rects;
+        for (int i = 0; i < message.rect_count; ++i)
+            dirty_rects.append(message.rects[i]);
+        CEventLoop::current().post_event(*this, make<WSAPISetWindowBackingStoreRequest>(client_id(), message.window_id, message.backing.shared_buffer_id, message.backing.size, message.backing.bpp, message.backing.pitch, message.backing.has_alpha_channel, message.backing.flush_immediately, dirty_rects, message.backing.scroll_rect, message.backing.scroll_delta));
         break;
+    }
     case WSAPI_ClientMessage::Type::SetGlobalCursorTracking:
         CEventLoop::current().post_event(*this, make<WSAPISetGlobalCursorTrackingRequest>(client_id(), message.window_id, message.value));
         break;
@@ -304,6 +313,16 @@ bool WSClientConnection::handle_message(const WSAPI_ClientMessage& message, cons
     case WSAPI_ClientMessage::Type::GetWallpaper:
         CEventLoop::current().post_event(*this, make<WSAPIGetWallpaperRequest>(client_id()));
         break;
+    case WSAPI_ClientMessage::Type::GetCompositorStatistics:
+        CEventLoop::current().post_event(*this, make<WSAPIGetCompositorStatisticsRequest>(client_id()));
+        break;
+    case WSAPI_ClientMessage::Type::GetSharedImage:
+        if (message.text_length > (int)sizeof(message.text)) {
+            did_misbehave();
+            return false;
+        }
+        CEventLoop::current().post_event(*this, make<WSAPIGetSharedImageRequest>(client_id(), String(message.text, message.text_length), message.image.mtime));
+        break;
     case WSAPI_ClientMessage::Type::SetResolution:
         CEventLoop::current().post_event(*this, make<WSAPISetResolutionRequest>(client_id(), message.wm_conf.resolution.width, message.wm_conf.resolution.height));
         break;
@@ -596,6 +615,54 @@ void WSClientConnection::handle_request(const WSAPIGetWallpaperRequest&)
     post_message(response);
 }
 
+void WSClientConnection::handle_request(const WSAPIGetCompositorStatisticsRequest&)
+{
+    auto& compositor = WSCompositor::the();
+    auto& timings = compositor.frame_timings();
+    WSAPI_ServerMessage response;
+    response.type = WSAPI_ServerMessage::Type::DidGetCompositorStatistics;
+    response.compositor.frame_rate = WSCompositor::frame_rate;
+    response.compositor.frame_count = compositor.frame_count();
+    response.compositor.frame_sample_count = timings.size();
+    response.compositor.last_compose_us = 0;
+    response.compositor.last_flush_us = 0;
+    response.compositor.last_rect_count = 0;
+    response.compositor.average_compose_us = 0;
+    response.compositor.average_flush_us = 0;
+    response.compositor.max_compose_us = 0;
+    response.compositor.max_flush_us = 0;
+    if (!timings.is_empty()) {
+        u64 total_compose_us = 0;
+        u64 total_flush_us = 0;
+        for (auto& timing : timings) {
+            total_compose_us += timing.compose_us;
+            total_flush_us += timing.flush_us;
+            response.compositor.max_compose_us = max(response.compositor.max_compose_us, timing.compose_us);
+            response.compositor.max_flush_us = max(response.compositor.max_flush_us, timing.flush_us);
+        }
+        response.compositor.average_compose_us = total_compose_us / timings.size();
+        response.compositor.average_flush_us = total_flush_us / timings.size();
+        response.compositor.last_compose_us = timings.last().compose_us;
+        response.compositor.last_flush_us = timings.last().flush_us;
+        response.compositor.last_rect_count = timings.last().rect_count;
+    }
+    post_message(response);
+}
+
+void WSClientConnection::handle_request(const WSAPIGetSharedImageRequest& request)
+{
+    WSAPI_ServerMessage response;
+    response.type = WSAPI_ServerMessage::Type::DidGetSharedImage;
+    response.image.shared_buffer_id = -1;
+    SharedImageCache::Entry entry;
+    if (WSImageCache::the().lookup(request.path(), request.mtime(), entry)) {
+        response.image.shared_buffer_id = entry.shared_buffer_id;
+        response.image.size = entry.size;
+        response.image.has_alpha_channel = entry.format == GraphicsBitmap::Format::RGBA32;
+    }
+    post_message(response);
+}
+
 void WSClientConnection::handle_request(const WSAPISetResolutionRequest& request)
 {
     WSWindowManager::the().set_resolution(request.resolution().width(), request.resolution().height());
@@ -816,8 +883,10 @@ void WSClientConnection::handle_request(const WSAPIDidFinishPaintingNotification
         return;
     }
     auto& window = *(*it).value;
+    window.invalidate_backing_store_opacity();
     for (auto& rect : request.rects())
         WSWindowManager::the().invalidate(window, rect);
+    WSCompositor::the().request_frame_callback(window);
 
     WSWindowSwitcher::the().refresh_if_needed();
 }
@@ -869,6 +938,19 @@ void WSClientConnection::handle_request(const WSAPISetWindowBackingStoreRequest&
     if (request.flush_immediately())
         window.invalidate();
 
+    // A flip from a double-buffered client says what changed, so only that
+    // needs to be composed again. What it scrolled can be copied on screen.
+    if (!request.scroll_rect().is_empty())
+        WSCompositor::the().scroll_window_rect(window, request.scroll_rect(), request.scroll_delta());
+    for (auto& rect : request.dirty_rects())
+        WSWindowManager::the().invalidate(window, rect);
+    if (!request.dirty_rects().is_empty() || !request.scroll_rect().is_empty())
+        WSWindowSwitcher::the().refresh_if_needed();
+
+    // The client waits for a frame callback after every flip, even one that
+    // changed nothing, before it paints again.
+    WSCompositor::the().request_frame_callback(window);
+
     WSAPI_ServerMessage response;
     response.type = WSAPI_ServerMessage::Type::DidSetWindowBackingStore;
     response.window_id = window_id;
@@ -1040,6 +1122,10 @@ void WSClientConnection::on_request(const WSAPIClientRequest& request)
         return handle_request(static_cast<const WSAPISetWallpaperRequest&>(request));
     case WSEvent::APIGetWallpaperRequest:
         return handle_request(static_cast<const WSAPIGetWallpaperRequest&>(request));
+    case WSEvent::APIGetCompositorStatisticsRequest:
+        return handle_request(static_cast<const WSAPIGetCompositorStatisticsRequest&>(request));
+    case WSEvent::APIGetSharedImageRequest:
+        return handle_request(static_cast<const WSAPIGetSharedImageRequest&>(request));
     case WSEvent::APISetResolutionRequest:
         return handle_request(static_cast<const WSAPISetResolutionRequest&>(request));
     case WSEvent::APISetWindowOverrideCursorRequest:
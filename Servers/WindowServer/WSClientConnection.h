@@ -77,6 +77,8 @@ private:
     void handle_request(const WSAPISetWindowOpacityRequest&);
     void handle_request(const WSAPISetWallpaperRequest&);
     void handle_request(const WSAPIGetWallpaperRequest&);
+    void handle_request(const WSAPIGetCompositorStatisticsRequest&);
+    void handle_request(const WSAPIGetSharedImageRequest&);
     void handle_request(const WSAPISetResolutionRequest&);
     void handle_request(const WSAPISetWindowOverrideCursorRequest&);
     void handle_request(const WSWMAPISetActiveWindowRequest&);
@@ -1,16 +1,76 @@
 #include "WSCompositor.h"
+#include "WSClientConnection.h"
 #include "WSEvent.h"
 #include "WSEventLoop.h"
 #include "WSScreen.h"
 #include "WSWindow.h"
 #include "WSWindowManager.h"
+#include <AK/NonnullOwnPtrVector.h>
 #include <LibDraw/Font.h>
 #include <LibDraw/PNGLoader.h>
 #include <LibDraw/Painter.h>
 #include <LibThread/BackgroundAction.h>
+#include <string.h>
+#include <time.h>
 
 // #define COMPOSITOR_DEBUG
 
+static const int max_dirty_rect_count = 32;
+
+// Splits the rows of a rect into at most max_band_count bands of roughly the
+// same height, but not into bands so thin they aren't worth a thread.
+static Vector<Rect, 8> split_into_bands(const Rect& rect, int max_band_count)
+{
+    static const int min_band_height = 32;
+    int band_count = max(1, min(max_band_count, rect.height() / min_band_height));
+    Vector<Rect, 8> bands;
+    for (int i = 0; i < band_count; ++i) {
+        int top = rect.top() + rect.height() * i / band_count;
+        int bottom = rect.top() + rect.height() * (i + 1) / band_count;
+        bands.append({ rect.x(), top, rect.width(), bottom - top });
+    }
+    return bands;
+}
+
+// Moves the pixels of each destination rect from where they are minus delta.
+// One rect's source may overlap another's destination, so go through the
+// rows in the order that never reads a row after it has been written to:
+// bottom up when moving down, and within a row, right to left when moving right.
+static void copy_rects_within(GraphicsBitmap& bitmap, const DisjointRectSet& destination_rects, const Point& delta)
+{
+    auto& rects = destination_rects.rects();
+    Vector<int, 32> band_starts;
+    for (int i = 0; i < rects.size(); ++i) {
+        if (i == 0 || rects[i].y() != rects[i - 1].y())
+            band_starts.append(i);
+    }
+    band_starts.append(rects.size());
+
+    bool bottom_up = delta.y() > 0;
+    bool right_to_left = delta.x() > 0;
+    int band_count = band_starts.size() - 1;
+    for (int i = 0; i < band_count; ++i) {
+        int band = bottom_up ? band_count - 1 - i : i;
+        int start = band_starts[band];
+        int end = band_starts[band + 1];
+        auto& band_rect = rects[start];
+        for (int row = 0; row < band_rect.height(); ++row) {
+            int y = bottom_up ? band_rect.bottom() - row : band_rect.top() + row;
+            for (int j = 0; j < end - start; ++j) {
+                auto& rect = rects[right_to_left ? end - 1 - j : start + j];
+                memmove(bitmap.scanline(y) + rect.x(), bitmap.scanline(y - delta.y()) + rect.x() - delta.x(), rect.width() * sizeof(RGBA32));
+            }
+        }
+    }
+}
+
+static u64 current_time_us()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 WSCompositor& WSCompositor::the()
 {
     static WSCompositor s_the;
@@ -33,28 +93,17 @@ WallpaperMode mode_to_enum(const String& name)
 WSCompositor::WSCompositor()
 {
     m_compose_timer = CTimer::construct(this);
-    m_immediate_compose_timer = CTimer::construct(this);
-
-    m_screen_can_set_buffer = WSScreen::the().can_set_buffer();
-
-    init_bitmaps();
-
-    m_compose_timer->on_timeout = [&]() {
-#if defined(COMPOSITOR_DEBUG)
-        dbgprintf("WSCompositor: delayed frame callback: %d rects\n", m_dirty_rects.size());
-#endif
-        compose();
-    };
     m_compose_timer->set_single_shot(true);
-    m_compose_timer->set_interval(1000 / 60);
-    m_immediate_compose_timer->on_timeout = [=]() {
+    m_compose_timer->on_timeout = [this] {
 #if defined(COMPOSITOR_DEBUG)
-        dbgprintf("WSCompositor: immediate frame callback: %d rects\n", m_dirty_rects.size());
+        dbgprintf("WSCompositor: frame callback: %d rects\n", m_dirty_rects.size());
 #endif
         compose();
     };
-    m_immediate_compose_timer->set_single_shot(true);
-    m_immediate_compose_timer->set_interval(0);
+
+    m_screen_can_set_buffer = WSScreen::the().can_set_buffer();
+
+    init_bitmaps();
 }
 
 void WSCompositor::init_bitmaps()
@@ -73,7 +122,9 @@ void WSCompositor::init_bitmaps()
     m_back_painter = make<Painter>(*m_back_bitmap);
 
     m_buffers_are_flipped = false;
+    m_scaled_wallpaper = nullptr;
 
+    invalidate_occlusions();
     invalidate();
 }
 
@@ -82,15 +133,27 @@ void WSCompositor::compose()
     auto& wm = WSWindowManager::the();
     if (m_wallpaper_mode == WallpaperMode::Unchecked)
         m_wallpaper_mode = mode_to_enum(wm.wm_config()->read_entry("Background", "Mode", "simple"));
+    if (!m_workers) {
+        int thread_count = wm.wm_config()->read_num_entry("Compositor", "WorkerThreads", 0);
+        // Workers paint window titles, so load the font before they start.
+        if (thread_count > 0)
+            wm.window_title_font();
+        m_workers = make<LibThread::WorkerPool>(thread_count);
+    }
     auto& ws = WSScreen::the();
 
     auto dirty_rects = move(m_dirty_rects);
+    auto copies = move(m_pending_copies);
 
-    if (dirty_rects.size() == 0) {
+    if (dirty_rects.size() == 0 && copies.is_empty()) {
         // nothing dirtied since the last compose pass.
+        send_frame_callbacks();
         return;
     }
 
+    u64 compose_start_us = current_time_us();
+    m_last_frame_time_us = compose_start_us;
+
     dirty_rects.add(Rect::intersection(m_last_geometry_label_rect, WSScreen::the().rect()));
     dirty_rects.add(Rect::intersection(m_last_cursor_rect, WSScreen::the().rect()));
     dirty_rects.add(Rect::intersection(current_cursor_rect(), WSScreen::the().rect()));
@@ -98,120 +161,169 @@ void WSCompositor::compose()
     dbgprintf("[WM] compose #%u (%u rects)\n", ++m_compose_count, dirty_rects.rects().size());
 #endif
 
-    auto any_dirty_rect_intersects_window = [&dirty_rects](const WSWindow& window) {
-        auto window_frame_rect = window.frame().rect();
-        for (auto& dirty_rect : dirty_rects.rects()) {
-            if (dirty_rect.intersects(window_frame_rect))
-                return true;
-        }
-        return false;
-    };
+    if (m_occlusions_dirty)
+        recompute_occlusions();
 
-    // Paint the wallpaper.
-    for (auto& dirty_rect : dirty_rects.rects()) {
-        if (wm.any_opaque_window_contains_rect(dirty_rect))
-            continue;
+    if (m_wallpaper_mode == WallpaperMode::Scaled && m_wallpaper && !m_scaled_wallpaper) {
+        m_scaled_wallpaper = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, ws.size());
+        Painter painter(*m_scaled_wallpaper);
+        painter.fill_rect(m_scaled_wallpaper->rect(), wm.m_background_color);
+        painter.draw_scaled_bitmap(m_scaled_wallpaper->rect(), *m_wallpaper, m_wallpaper->rect(), Painter::ScalingMode::Smooth);
+    }
+
+    // Whatever was copied is up to date, except where it's dirty and about to
+    // be painted over anyway. It only needs flushing.
+    DisjointRectSet flush_rects;
+    for (auto& copy : copies) {
+        copy_rects_within(*m_back_bitmap, copy.destination_rects, copy.delta);
+        flush_rects.add(copy.destination_rects);
+    }
+    flush_rects.add(dirty_rects);
+
+    // Paint the wallpaper where no opaque window covers it.
+    auto paint_wallpaper = [&](Painter& painter, const Rect& dirty_rect) {
+        // The scaled wallpaper already has the background color under it.
+        if (m_scaled_wallpaper) {
+            painter.blit(dirty_rect.location(), *m_scaled_wallpaper, dirty_rect);
+            return;
+        }
         // FIXME: If the wallpaper is opaque, no need to fill with color!
-        m_back_painter->fill_rect(dirty_rect, wm.m_background_color);
+        painter.fill_rect(dirty_rect, wm.m_background_color);
         if (m_wallpaper) {
             if (m_wallpaper_mode == WallpaperMode::Simple) {
-                m_back_painter->blit(dirty_rect.location(), *m_wallpaper, dirty_rect);
+                painter.blit(dirty_rect.location(), *m_wallpaper, dirty_rect);
             } else if (m_wallpaper_mode == WallpaperMode::Center) {
                 Point offset { ws.size().width() / 2 - m_wallpaper->size().width() / 2,
                     ws.size().height() / 2 - m_wallpaper->size().height() / 2 };
-                m_back_painter->blit_offset(dirty_rect.location(), *m_wallpaper,
+                painter.blit_offset(dirty_rect.location(), *m_wallpaper,
                     dirty_rect, offset);
             } else if (m_wallpaper_mode == WallpaperMode::Tile) {
-                m_back_painter->draw_tiled_bitmap(dirty_rect, *m_wallpaper);
-            } else if (m_wallpaper_mode == WallpaperMode::Scaled) {
-                float hscale = (float)m_wallpaper->size().width() / (float)ws.size().width();
-                float vscale = (float)m_wallpaper->size().height() / (float)ws.size().height();
-
-                m_back_painter->blit_scaled(dirty_rect, *m_wallpaper, dirty_rect, hscale, vscale);
+                painter.draw_tiled_bitmap(dirty_rect, *m_wallpaper);
             } else {
                 ASSERT_NOT_REACHED();
             }
         }
-    }
+    };
 
-    auto compose_window = [&](WSWindow& window) -> IterationDecision {
-        if (!any_dirty_rect_intersects_window(window))
-            return IterationDecision::Continue;
-        PainterStateSaver saver(*m_back_painter);
-        m_back_painter->add_clip_rect(window.frame().rect());
-        RefPtr<GraphicsBitmap> backing_store = window.backing_store();
-        for (auto& dirty_rect : dirty_rects.rects()) {
-            if (wm.any_opaque_window_above_this_one_contains_rect(window, dirty_rect))
-                continue;
-            PainterStateSaver saver(*m_back_painter);
-            m_back_painter->add_clip_rect(dirty_rect);
-            if (!backing_store)
-                m_back_painter->fill_rect(dirty_rect, window.background_color());
-            if (!window.is_fullscreen())
-                window.frame().paint(*m_back_painter);
-            if (!backing_store)
-                continue;
-
-            // Decide where we would paint this window's backing store.
-            // This is subtly different from widow.rect(), because window
-            // size may be different from its backing store size. This
-            // happens when the window has been resized and the client
-            // has not yet attached a new backing store. In this case,
-            // we want to try to blit the backing store at the same place
-            // it was previously, and fill the rest of the window with its
-            // background color.
-            Rect backing_rect;
-            backing_rect.set_size(backing_store->size());
-            switch (WSWindowManager::the().resize_direction_of_window(window)) {
-            case ResizeDirection::None:
-            case ResizeDirection::Right:
-            case ResizeDirection::Down:
-            case ResizeDirection::DownRight:
-                backing_rect.set_location(window.rect().location());
-                break;
-            case ResizeDirection::Left:
-            case ResizeDirection::Up:
-            case ResizeDirection::UpLeft:
-                backing_rect.set_right_without_resize(window.rect().right());
-                backing_rect.set_bottom_without_resize(window.rect().bottom());
-                break;
-            case ResizeDirection::UpRight:
-                backing_rect.set_left(window.rect().left());
-                backing_rect.set_bottom_without_resize(window.rect().bottom());
-                break;
-            case ResizeDirection::DownLeft:
-                backing_rect.set_right_without_resize(window.rect().right());
-                backing_rect.set_top(window.rect().top());
-                break;
-            }
+    // Paints the part of a window within one of its visible rects.
+    auto compose_window_rect = [&](Painter& painter, WSWindow& window, GraphicsBitmap* backing_store, const Rect& dirty_rect) {
+        PainterStateSaver saver(painter);
+        painter.add_clip_rect(dirty_rect);
+        if (!backing_store)
+            painter.fill_rect(dirty_rect, window.background_color());
+        if (!window.is_fullscreen())
+            window.frame().paint(painter);
+        if (!backing_store)
+            return;
+
+        // Decide where we would paint this window's backing store.
+        // This is subtly different from widow.rect(), because window
+        // size may be different from its backing store size. This
+        // happens when the window has been resized and the client
+        // has not yet attached a new backing store. In this case,
+        // we want to try to blit the backing store at the same place
+        // it was previously, and fill the rest of the window with its
+        // background color.
+        Rect backing_rect;
+        backing_rect.set_size(backing_store->size());
+        switch (WSWindowManager::the().resize_direction_of_window(window)) {
+        case ResizeDirection::None:
+        case ResizeDirection::Right:
+        case ResizeDirection::Down:
+        case ResizeDirection::DownRight:
+            backing_rect.set_location(window.rect().location());
+            break;
+        case ResizeDirection::Left:
+        case ResizeDirection::Up:
+        case ResizeDirection::UpLeft:
+            backing_rect.set_right_without_resize(window.rect().right());
+            backing_rect.set_bottom_without_resize(window.rect().bottom());
+            break;
+        case ResizeDirection::UpRight:
+            backing_rect.set_left(window.rect().left());
+            backing_rect.set_bottom_without_resize(window.rect().bottom());
+            break;
+        case ResizeDirection::DownLeft:
+            backing_rect.set_right_without_resize(window.rect().right());
+            backing_rect.set_top(window.rect().top());
+            break;
+        }
 
-            Rect dirty_rect_in_backing_coordinates = dirty_rect
-                                                         .intersected(window.rect())
-                                                         .intersected(backing_rect)
-                                                         .translated(-backing_rect.location());
+        Rect dirty_rect_in_backing_coordinates = dirty_rect
+                                                     .intersected(window.rect())
+                                                     .intersected(backing_rect)
+                                                     .translated(-backing_rect.location());
 
-            if (dirty_rect_in_backing_coordinates.is_empty())
-                continue;
-            auto dst = backing_rect.location().translated(dirty_rect_in_backing_coordinates.location());
+        if (dirty_rect_in_backing_coordinates.is_empty())
+            return;
+        auto dst = backing_rect.location().translated(dirty_rect_in_backing_coordinates.location());
 
-            m_back_painter->blit(dst, *backing_store, dirty_rect_in_backing_coordinates, window.opacity());
-            for (auto background_rect : window.rect().shatter(backing_rect))
-                m_back_painter->fill_rect(background_rect, window.background_color());
-        }
-        return IterationDecision::Continue;
+        painter.blit(dst, *backing_store, dirty_rect_in_backing_coordinates, window.opacity());
+        for (auto background_rect : window.rect().shatter(backing_rect))
+            painter.fill_rect(background_rect, window.background_color());
+    };
+
+    auto compose_window = [&](Painter& painter, const DisjointRectSet& dirty_rects, WSWindow& window) {
+        if (!dirty_rects.intersects(window.frame().rect()))
+            return;
+        auto rects = dirty_rects.intersected(window.visible_rects());
+        if (rects.is_empty())
+            return;
+        PainterStateSaver saver(painter);
+        painter.add_clip_rect(window.frame().rect());
+        // Not a RefPtr: this may run on a worker thread, and reference counts
+        // aren't atomic. The window keeps its backing store alive meanwhile.
+        auto* backing_store = window.backing_store();
+        for (auto& rect : rects.rects())
+            compose_window_rect(painter, window, backing_store, rect);
     };
 
-    // Paint the window stack.
+    Vector<WSWindow*, 32> windows;
     if (auto* fullscreen_window = wm.active_fullscreen_window()) {
-        compose_window(*fullscreen_window);
+        windows.append(fullscreen_window);
     } else {
         wm.for_each_visible_window_from_back_to_front([&](WSWindow& window) {
-            return compose_window(window);
+            windows.append(&window);
+            return IterationDecision::Continue;
         });
+    }
 
-        draw_geometry_label();
+    // Every window only paints where it's visible, so unless there are
+    // translucent windows, each screen pixel is painted exactly once.
+    auto compose_band = [&](Painter& painter, const DisjointRectSet& dirty_rects) {
+        for (auto& rect : dirty_rects.intersected(m_wallpaper_rects).rects())
+            paint_wallpaper(painter, rect);
+        for (auto* window : windows)
+            compose_window(painter, dirty_rects, *window);
+    };
+
+    // Split the screen into bands of rows, and compose and flush those on the
+    // worker threads. Each band has its own painter, so no clip state is shared.
+    // The painters (and their references to the back bitmap) are created and
+    // destroyed on this thread.
+    auto bands = split_into_bands(flush_rects.bounding_rect(), m_workers->thread_count() + 1);
+    Vector<DisjointRectSet> band_dirty_rects;
+    Vector<DisjointRectSet> band_flush_rects;
+    NonnullOwnPtrVector<Painter> band_painters;
+    if (bands.size() > 1) {
+        for (auto& band : bands) {
+            band_dirty_rects.append(dirty_rects.intersected(band));
+            band_flush_rects.append(flush_rects.intersected(band));
+            auto painter = make<Painter>(*m_back_bitmap);
+            painter->add_clip_rect(band);
+            band_painters.append(move(painter));
+        }
+        m_workers->run(bands.size(), [&](int index) {
+            compose_band(band_painters[index], band_dirty_rects[index]);
+        });
+        band_painters.clear();
+    } else {
+        compose_band(*m_back_painter, dirty_rects);
     }
 
+    if (!wm.active_fullscreen_window())
+        draw_geometry_label();
+
     draw_cursor();
 
     if (m_flash_flush) {
@@ -219,11 +331,203 @@ void WSCompositor::compose()
             m_front_painter->fill_rect(rect, Color::Yellow);
     }
 
+    u64 flush_start_us = current_time_us();
+
     if (m_screen_can_set_buffer)
         flip_buffers();
 
-    for (auto& r : dirty_rects.rects())
-        flush(r);
+    if (bands.size() > 1) {
+        m_workers->run(bands.size(), [&](int index) {
+            for (auto& rect : band_flush_rects[index].rects())
+                flush(rect);
+        });
+    } else {
+        for (auto& r : flush_rects.rects())
+            flush(r);
+    }
+
+    FrameTiming timing;
+    timing.compose_us = flush_start_us - compose_start_us;
+    timing.flush_us = current_time_us() - flush_start_us;
+    timing.rect_count = flush_rects.size();
+    m_frame_timings.enqueue(timing);
+    ++m_frame_count;
+
+    send_frame_callbacks();
+}
+
+void WSCompositor::schedule_frame()
+{
+    if (m_compose_timer->is_active())
+        return;
+
+    // Compose as soon as possible, but no sooner than one frame interval
+    // after the last frame. Anything invalidated until then goes into the
+    // same frame.
+    static const u64 frame_interval_us = 1000000 / frame_rate;
+    u64 now_us = current_time_us();
+    u64 next_frame_time_us = m_last_frame_time_us + frame_interval_us;
+    int delay_ms = 0;
+    if (now_us < next_frame_time_us)
+        delay_ms = (next_frame_time_us - now_us + 999) / 1000;
+
+#if defined(COMPOSITOR_DEBUG)
+    dbgprintf("WSCompositor: scheduling frame in %d ms\n", delay_ms);
+#endif
+    m_compose_timer->start(delay_ms);
+}
+
+void WSCompositor::request_frame_callback(const WSWindow& window)
+{
+    if (!window.client())
+        return;
+    FrameCallback callback { window.client()->client_id(), window.window_id() };
+    for (auto& pending_callback : m_frame_callbacks) {
+        if (pending_callback.client_id == callback.client_id && pending_callback.window_id == callback.window_id)
+            return;
+    }
+    m_frame_callbacks.append(callback);
+    schedule_frame();
+}
+
+void WSCompositor::send_frame_callbacks()
+{
+    auto callbacks = move(m_frame_callbacks);
+    for (auto& callback : callbacks) {
+        auto* client = WSClientConnection::from_client_id(callback.client_id);
+        if (!client)
+            continue;
+        WSAPI_ServerMessage message;
+        message.type = WSAPI_ServerMessage::Type::FrameDone;
+        message.window_id = callback.window_id;
+        client->post_message(message);
+    }
+}
+
+void WSCompositor::recompute_occlusions()
+{
+    auto& wm = WSWindowManager::the();
+    auto screen_rect = WSScreen::the().rect();
+
+    wm.for_each_window([](WSWindow& window) {
+        window.set_visible_rects({});
+        return IterationDecision::Continue;
+    });
+
+    Vector<WSWindow*, 32> windows;
+    if (auto* fullscreen_window = wm.active_fullscreen_window()) {
+        windows.append(fullscreen_window);
+    } else {
+        wm.for_each_visible_window_from_back_to_front([&](WSWindow& window) {
+            windows.append(&window);
+            return IterationDecision::Continue;
+        });
+    }
+
+    // Walk the stack front to back. Each window gets whatever part of its
+    // frame the opaque windows in front of it have left uncovered.
+    DisjointRectSet covered_rects;
+    for (int i = windows.size() - 1; i >= 0; --i) {
+        auto& window = *windows[i];
+        auto frame_rect = window.frame().rect().intersected(screen_rect);
+        if (frame_rect.is_empty())
+            continue;
+        DisjointRectSet visible_rects;
+        visible_rects.add(frame_rect);
+        window.set_visible_rects(visible_rects.shatter(covered_rects));
+        if (window.is_opaque())
+            covered_rects.add(frame_rect);
+    }
+
+    DisjointRectSet screen_rects;
+    screen_rects.add(screen_rect);
+    m_wallpaper_rects = screen_rects.shatter(covered_rects);
+    m_occlusions_dirty = false;
+}
+
+// The parts of the screen that show exactly the window's pixels, or will
+// once the pending copies are done and the dirty rects are composed: where
+// it's visible, and no translucent window in front of it is blended with it.
+DisjointRectSet WSCompositor::reusable_rects(WSWindow& window)
+{
+    auto& wm = WSWindowManager::the();
+    if (!window.is_opaque() || wm.active_fullscreen_window())
+        return {};
+    // While resizing, the backing store isn't where the window is.
+    if (wm.resize_direction_of_window(window) != ResizeDirection::None)
+        return {};
+    if (m_occlusions_dirty)
+        recompute_occlusions();
+
+    DisjointRectSet blended_rects;
+    wm.for_each_visible_window_from_front_to_back([&](WSWindow& other) {
+        if (&other == &window)
+            return IterationDecision::Break;
+        if (!other.is_opaque())
+            blended_rects.add(other.frame().rect());
+        return IterationDecision::Continue;
+    });
+    return window.visible_rects().shatter(blended_rects);
+}
+
+// The parts of the source rects whose pixels in the back buffer are not
+// up to date: they're dirty, or the cursor or geometry label is on them.
+DisjointRectSet WSCompositor::stale_rects(const DisjointRectSet& source_rects) const
+{
+    auto rects = source_rects.intersected(m_dirty_rects);
+    rects.add(source_rects.intersected(m_last_cursor_rect));
+    rects.add(source_rects.intersected(m_last_geometry_label_rect));
+    return rects;
+}
+
+void WSCompositor::copy_rects(DisjointRectSet&& destination_rects, const Point& delta)
+{
+    if (destination_rects.is_empty())
+        return;
+    m_pending_copies.append({ move(destination_rects), delta });
+    schedule_frame();
+}
+
+void WSCompositor::move_window(WSWindow& window, const Point& position)
+{
+    if (position == window.position())
+        return;
+    auto delta = position - window.position();
+    auto source_rects = reusable_rects(window);
+    auto stale_source_rects = stale_rects(source_rects);
+
+    // This invalidates both the old and the new frame rect.
+    window.set_position_without_repaint(position);
+    if (source_rects.is_empty())
+        return;
+
+    // But where the window was reusable before and after the move, copying
+    // gives the same pixels composing would. Only the parts that were stale
+    // have to be composed at their new place.
+    auto destination_rects = source_rects.translated(delta).intersected(reusable_rects(window));
+    m_dirty_rects = m_dirty_rects.shatter(destination_rects);
+    m_dirty_rects.add(stale_source_rects.translated(delta).intersected(destination_rects));
+    m_dirty_rects.simplify(max_dirty_rect_count);
+    copy_rects(move(destination_rects), delta);
+}
+
+void WSCompositor::scroll_window_rect(WSWindow& window, const Rect& rect, const Point& delta)
+{
+    auto screen_rect = rect.translated(window.position()).intersected(window.rect());
+    DisjointRectSet source_rects;
+    auto* backing_store = window.backing_store();
+    if (backing_store && backing_store->size() == window.size())
+        source_rects = reusable_rects(window).intersected(screen_rect);
+    auto destination_rects = source_rects.translated(delta).intersected(source_rects);
+
+    auto stale_destination_rects = stale_rects(destination_rects.translated(-delta)).translated(delta);
+    DisjointRectSet uncopied_rects;
+    uncopied_rects.add(screen_rect);
+    uncopied_rects = uncopied_rects.shatter(destination_rects);
+    uncopied_rects.add(stale_destination_rects);
+    copy_rects(move(destination_rects), delta);
+    for (auto& uncopied_rect : uncopied_rects.rects())
+        invalidate(uncopied_rect);
 }
 
 void WSCompositor::flush(const Rect& a_rect)
@@ -278,21 +582,14 @@ void WSCompositor::invalidate(const Rect& a_rect)
         return;
 
     m_dirty_rects.add(rect);
+    // Past a point, repainting a little too much is cheaper than doing
+    // lots of tiny blits and flushes.
+    m_dirty_rects.simplify(max_dirty_rect_count);
 
-    // We delay composition by a timer interval, but to not affect latency too
-    // much, if a pending compose is not already scheduled, we also schedule an
-    // immediate compose the next spin of the event loop.
-    if (!m_compose_timer->is_active()) {
 #if defined(COMPOSITOR_DEBUG)
-        dbgprintf("Invalidated (starting immediate frame): %dx%d %dx%d\n", a_rect.x(), a_rect.y(), a_rect.width(), a_rect.height());
+    dbgprintf("Invalidated: %dx%d %dx%d\n", a_rect.x(), a_rect.y(), a_rect.width(), a_rect.height());
 #endif
-        m_compose_timer->start();
-        m_immediate_compose_timer->start();
-    } else {
-#if defined(COMPOSITOR_DEBUG)
-        dbgprintf("Invalidated (frame callback pending): %dx%d %dx%d\n", a_rect.x(), a_rect.y(), a_rect.width(), a_rect.height());
-#endif
-    }
+    schedule_frame();
 }
 
 bool WSCompositor::set_wallpaper(const String& path, Function<void(bool)>&& callback)
@@ -309,6 +606,7 @@ bool WSCompositor::set_wallpaper(const String& path, Function<void(bool)>&& call
             }
             m_wallpaper_path = path;
             m_wallpaper = move(bitmap);
+            m_scaled_wallpaper = nullptr;
             invalidate();
             callback(true);
         });
@@ -1,14 +1,17 @@
 #pragma once
 
+#include <AK/CircularQueue.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <LibCore/CObject.h>
 #include <LibCore/CTimer.h>
 #include <LibDraw/DisjointRectSet.h>
 #include <LibDraw/GraphicsBitmap.h>
+#include <LibThread/WorkerPool.h>
 
 class Painter;
 class WSCursor;
+class WSWindow;
 
 enum class WallpaperMode {
     Simple,
@@ -35,9 +38,45 @@ public:
     void invalidate_cursor();
     Rect current_cursor_rect() const;
 
+    // Call when anything changes which windows cover which parts of the
+    // screen: geometry, stacking, visibility or opacity.
+    void invalidate_occlusions() { m_occlusions_dirty = true; }
+
+    // Moves a window by copying what's on screen of it to the new place,
+    // and only composing what that doesn't cover.
+    void move_window(WSWindow&, const Point& position);
+
+    // Call when the contents of rect (in window coordinates) have scrolled
+    // by delta in the window's new backing store. What's on screen of them
+    // is copied, and the rest of the rect is invalidated.
+    void scroll_window_rect(WSWindow&, const Rect&, const Point& delta);
+
+    // Frames are composed at most this often, however often things change.
+    static const int frame_rate = 60;
+
+    // Sends the window's client a FrameDone once the next frame is on
+    // screen, so it can pace its painting to the compositor.
+    void request_frame_callback(const WSWindow&);
+
+    struct FrameTiming {
+        unsigned compose_us { 0 };
+        unsigned flush_us { 0 };
+        int rect_count { 0 };
+    };
+
+    unsigned frame_count() const { return m_frame_count; }
+    // The most recent frames, oldest first.
+    const CircularQueue<FrameTiming, 60>& frame_timings() const { return m_frame_timings; }
+
 private:
     WSCompositor();
     void init_bitmaps();
+    void schedule_frame();
+    void send_frame_callbacks();
+    void recompute_occlusions();
+    DisjointRectSet reusable_rects(WSWindow&);
+    DisjointRectSet stale_rects(const DisjointRectSet& source_rects) const;
+    void copy_rects(DisjointRectSet&& destination_rects, const Point& delta);
     void flip_buffers();
     void flush(const Rect&);
     void draw_cursor();
@@ -47,7 +86,15 @@ private:
     unsigned m_compose_count { 0 };
     unsigned m_flush_count { 0 };
     RefPtr<CTimer> m_compose_timer;
-    RefPtr<CTimer> m_immediate_compose_timer;
+    u64 m_last_frame_time_us { 0 };
+    unsigned m_frame_count { 0 };
+    CircularQueue<FrameTiming, 60> m_frame_timings;
+
+    struct FrameCallback {
+        int client_id;
+        int window_id;
+    };
+    Vector<FrameCallback> m_frame_callbacks;
     bool m_flash_flush { false };
     bool m_buffers_are_flipped { false };
     bool m_screen_can_set_buffer { false };
@@ -56,13 +103,29 @@ private:
     RefPtr<GraphicsBitmap> m_back_bitmap;
     OwnPtr<Painter> m_back_painter;
     OwnPtr<Painter> m_front_painter;
+    OwnPtr<LibThread::WorkerPool> m_workers;
 
     DisjointRectSet m_dirty_rects;
 
+    // Pixels to move around in the back buffer before composing the next
+    // frame, in order. Each destination rect is copied from itself minus delta.
+    struct PendingCopy {
+        DisjointRectSet destination_rects;
+        Point delta;
+    };
+    Vector<PendingCopy> m_pending_copies;
+
+    // The parts of the screen that no opaque window covers.
+    DisjointRectSet m_wallpaper_rects;
+    bool m_occlusions_dirty { true };
+
     Rect m_last_cursor_rect;
     Rect m_last_geometry_label_rect;
 
     String m_wallpaper_path;
     WallpaperMode m_wallpaper_mode { WallpaperMode::Unchecked };
     RefPtr<GraphicsBitmap> m_wallpaper;
+    // For WallpaperMode::Scaled: the wallpaper at screen size, made once
+    // rather than scaled again for every frame.
+    RefPtr<GraphicsBitmap> m_scaled_wallpaper;
 };
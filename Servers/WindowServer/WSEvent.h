@@ -61,6 +61,8 @@ public:
         APIGetClipboardContentsRequest,
         APISetWallpaperRequest,
         APIGetWallpaperRequest,
+        APIGetCompositorStatisticsRequest,
+        APIGetSharedImageRequest,
         APISetResolutionRequest,
         APISetWindowOverrideCursorRequest,
         APISetWindowHasAlphaChannelRequest,
@@ -444,6 +446,31 @@ public:
     }
 };
 
+class WSAPIGetCompositorStatisticsRequest final : public WSAPIClientRequest {
+public:
+    explicit WSAPIGetCompositorStatisticsRequest(int client_id)
+        : WSAPIClientRequest(WSEvent::APIGetCompositorStatisticsRequest, client_id)
+    {
+    }
+};
+
+class WSAPIGetSharedImageRequest final : public WSAPIClientRequest {
+public:
+    explicit WSAPIGetSharedImageRequest(int client_id, const String& path, time_t mtime)
+        : WSAPIClientRequest(WSEvent::APIGetSharedImageRequest, client_id)
+        , m_path(path)
+        , m_mtime(mtime)
+    {
+    }
+
+    String path() const { return m_path; }
+    time_t mtime() const { return m_mtime; }
+
+private:
+    String m_path;
+    time_t m_mtime { 0 };
+};
+
 class WSAPISetResolutionRequest final : public WSAPIClientRequest {
 public:
     explicit WSAPISetResolutionRequest(int client_id, int width, int height)
@@ -567,7 +594,7 @@ private:
 
 class WSAPISetWindowBackingStoreRequest final : public WSAPIClientRequest {
 public:
-    explicit WSAPISetWindowBackingStoreRequest(int client_id, int window_id, int shared_buffer_id, const Size& size, size_t bpp, size_t pitch, bool has_alpha_channel, bool flush_immediately)
+    explicit WSAPISetWindowBackingStoreRequest(int client_id, int window_id, int shared_buffer_id, const Size& size, size_t bpp, size_t pitch, bool has_alpha_channel, bool flush_immediately, const Vector<Rect, 32>& dirty_rects, const Rect& scroll_rect, const Point& scroll_delta)
         : WSAPIClientRequest(WSEvent::APISetWindowBackingStoreRequest, client_id)
         , m_window_id(window_id)
         , m_shared_buffer_id(shared_buffer_id)
@@ -576,6 +603,9 @@ public:
         , m_pitch(pitch)
         , m_has_alpha_channel(has_alpha_channel)
         , m_flush_immediately(flush_immediately)
+        , m_dirty_rects(dirty_rects)
+        , m_scroll_rect(scroll_rect)
+        , m_scroll_delta(scroll_delta)
     {
     }
 
@@ -587,6 +617,14 @@ public:
     bool has_alpha_channel() const { return m_has_alpha_channel; }
     bool flush_immediately() const { return m_flush_immediately; }
 
+    // The parts of the new backing store that differ from the old one.
+    const Vector<Rect, 32>& dirty_rects() const { return m_dirty_rects; }
+
+    // The part of the window whose contents moved by scroll_delta, rather than
+    // changed. The dirty rects don't include it.
+    Rect scroll_rect() const { return m_scroll_rect; }
+    Point scroll_delta() const { return m_scroll_delta; }
+
 private:
     int m_window_id { 0 };
     int m_shared_buffer_id { 0 };
@@ -595,6 +633,9 @@ private:
     size_t m_pitch;
     bool m_has_alpha_channel;
     bool m_flush_immediately;
+    Vector<Rect, 32> m_dirty_rects;
+    Rect m_scroll_rect;
+    Point m_scroll_delta;
 };
 
 class WSAPISetWindowRectRequest final : public WSAPIClientRequest {
@@ -0,0 +1,107 @@
+#include <AK/FileSystemPath.h>
+#include <LibDraw/PNGLoader.h>
+#include <WindowServer/WSImageCache.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+//#define IMAGE_CACHE_DEBUG
+
+WSImageCache& WSImageCache::the()
+{
+    static WSImageCache* s_the;
+    if (!s_the)
+        s_the = new WSImageCache;
+    return *s_the;
+}
+
+WSImageCache::WSImageCache()
+{
+}
+
+bool WSImageCache::is_cacheable(const String& path)
+{
+    return path.starts_with("/res/") && canonicalized_path(path) == path;
+}
+
+bool WSImageCache::current_mtime(const String& path, time_t& mtime)
+{
+    struct stat st;
+    if (stat(path.characters(), &st) < 0 || !S_ISREG(st.st_mode))
+        return false;
+    mtime = st.st_mtime;
+    return true;
+}
+
+bool WSImageCache::lookup(const String& path, time_t mtime, Entry& entry)
+{
+    if (!is_cacheable(path))
+        return false;
+
+    const SharedImage* image = nullptr;
+    auto it = m_images.find(path);
+    if (it != m_images.end() && (*it).value.mtime == mtime) {
+        image = &(*it).value;
+    } else {
+        // Either the file has changed since we decoded it, or the client is
+        // confused. Only the file itself can tell us which.
+        time_t real_mtime;
+        if (!current_mtime(path, real_mtime) || real_mtime != mtime)
+            return false;
+        image = decode(path, mtime);
+    }
+
+    if (!image || !image->shared_buffer)
+        return false;
+    entry.shared_buffer_id = image->shared_buffer->shared_buffer_id();
+    entry.format = image->format;
+    entry.size = image->size;
+    return true;
+}
+
+const WSImageCache::SharedImage* WSImageCache::decode(const String& path, time_t mtime)
+{
+    auto it = m_images.find(path);
+    if (it != m_images.end()) {
+        if ((*it).value.shared_buffer)
+            m_total_bytes -= (*it).value.shared_buffer->size();
+        m_images.remove(it);
+    }
+    if (m_images.size() >= max_image_count)
+        return nullptr;
+
+    auto bitmap = load_png(path);
+    if (!bitmap) {
+        m_images.set(path, { mtime, nullptr, GraphicsBitmap::Format::Invalid, {} });
+        return nullptr;
+    }
+
+    RefPtr<SharedBuffer> shared_buffer;
+    if (bitmap->width() * bitmap->height() <= max_shared_pixel_count && m_total_bytes + bitmap->size_in_bytes() <= max_total_bytes)
+        shared_buffer = share(*bitmap);
+
+#ifdef IMAGE_CACHE_DEBUG
+    dbgprintf("WSImageCache: Decoded %s (%dx%d) into shared buffer %d\n", path.characters(), bitmap->width(), bitmap->height(), shared_buffer ? shared_buffer->shared_buffer_id() : -1);
+#endif
+    if (shared_buffer)
+        m_total_bytes += shared_buffer->size();
+    m_images.set(path, { mtime, move(shared_buffer), bitmap->format(), bitmap->size() });
+    return &(*m_images.find(path)).value;
+}
+
+// Copies the bitmap into a shared buffer that any process may map, but none
+// may write to.
+RefPtr<SharedBuffer> WSImageCache::share(const GraphicsBitmap& bitmap)
+{
+    auto shared_buffer = SharedBuffer::create_with_size(bitmap.size_in_bytes());
+    if (!shared_buffer)
+        return nullptr;
+    memcpy(shared_buffer->data(), bitmap.scanline(0), bitmap.size_in_bytes());
+
+    shared_buffer->seal();
+    if (share_buffer_globally(shared_buffer->shared_buffer_id()) < 0) {
+        perror("share_buffer_globally");
+        return nullptr;
+    }
+    return shared_buffer;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/String.h>
+#include <LibDraw/SharedImageCache.h>
+#include <SharedBuffer.h>
+
+// The directory of shared system images. Clients look images up here before
+// decoding them. We decode every image in it ourselves, the first time anyone
+// asks for it, and hold a reference to its buffer, so the images stay mapped
+// for whoever asks next.
+//
+// Clients are trusted with nothing: they can only ask for canonical paths
+// under /res, with the modification time the file really has, and we stop
+// taking new images once the cache is full.
+class WSImageCache final : public SharedImageCache {
+public:
+    static WSImageCache& the();
+
+    virtual bool lookup(const String& path, time_t mtime, Entry&) override;
+
+private:
+    WSImageCache();
+
+    static const int max_image_count = 512;
+    static const size_t max_total_bytes = 16 * MB;
+
+    static bool is_cacheable(const String& path);
+    static bool current_mtime(const String& path, time_t&);
+    static RefPtr<SharedBuffer> share(const GraphicsBitmap&);
+
+    // Images we couldn't decode, or that are too big to share, are remembered
+    // without a buffer, so we don't decode them again for every client that asks.
+    struct SharedImage {
+        time_t mtime { 0 };
+        RefPtr<SharedBuffer> shared_buffer;
+        GraphicsBitmap::Format format { GraphicsBitmap::Format::Invalid };
+        Size size;
+    };
+    const SharedImage* decode(const String& path, time_t mtime);
+
+    HashMap<String, SharedImage> m_images;
+    size_t m_total_bytes { 0 };
+};
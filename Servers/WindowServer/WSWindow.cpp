@@ -1,4 +1,5 @@
 #include "WSWindow.h"
+#include "WSCompositor.h"
 #include "WSEvent.h"
 #include "WSEventLoop.h"
 #include "WSScreen.h"
@@ -60,6 +61,59 @@ void WSWindow::set_title(const String& title)
     WSWindowManager::the().notify_title_changed(*this);
 }
 
+void WSWindow::set_opacity(float opacity)
+{
+    if (m_opacity == opacity)
+        return;
+    m_opacity = opacity;
+    WSCompositor::the().invalidate_occlusions();
+}
+
+void WSWindow::set_has_alpha_channel(bool value)
+{
+    if (m_has_alpha_channel == value)
+        return;
+    m_has_alpha_channel = value;
+    WSCompositor::the().invalidate_occlusions();
+}
+
+static bool bitmap_is_opaque(const GraphicsBitmap& bitmap)
+{
+    for (int y = 0; y < bitmap.height(); ++y) {
+        const RGBA32* scanline = bitmap.scanline(y);
+        RGBA32 alpha = 0xff000000;
+        for (int x = 0; x < bitmap.width(); ++x)
+            alpha &= scanline[x];
+        if (alpha != 0xff000000)
+            return false;
+    }
+    return true;
+}
+
+bool WSWindow::is_opaque() const
+{
+    if (m_opacity < 1.0f)
+        return false;
+    if (!m_has_alpha_channel)
+        return true;
+    if (m_backing_store_opacity_dirty) {
+        // Only trust a backing store that covers the whole window, since we
+        // fill whatever it doesn't reach with the background color.
+        m_backing_store_is_opaque = m_backing_store
+            && m_backing_store->size() == m_rect.size()
+            && bitmap_is_opaque(*m_backing_store);
+        m_backing_store_opacity_dirty = false;
+    }
+    return m_backing_store_is_opaque;
+}
+
+void WSWindow::invalidate_backing_store_opacity()
+{
+    m_backing_store_opacity_dirty = true;
+    if (m_has_alpha_channel)
+        WSCompositor::the().invalidate_occlusions();
+}
+
 void WSWindow::set_rect(const Rect& rect)
 {
     Rect old_rect;
@@ -150,6 +204,7 @@ void WSWindow::set_minimized(bool minimized)
     if (m_minimized == minimized)
         return;
     m_minimized = minimized;
+    WSCompositor::the().invalidate_occlusions();
     if (!minimized)
         request_update({ {}, size() });
     invalidate();
@@ -290,6 +345,7 @@ void WSWindow::set_visible(bool b)
     if (m_visible == b)
         return;
     m_visible = b;
+    WSCompositor::the().invalidate_occlusions();
     invalidate();
 }
 
@@ -61,11 +61,11 @@ public:
     WSWindowType type() const { return m_type; }
     int window_id() const { return m_window_id; }
 
-    String title() const { return m_title; }
+    const String& title() const { return m_title; }
     void set_title(const String&);
 
     float opacity() const { return m_opacity; }
-    void set_opacity(float opacity) { m_opacity = opacity; }
+    void set_opacity(float);
 
     int x() const { return m_rect.x(); }
     int y() const { return m_rect.y(); }
@@ -113,10 +113,12 @@ public:
     {
         m_last_backing_store = move(m_backing_store);
         m_backing_store = move(backing_store);
+        invalidate_backing_store_opacity();
     }
     void swap_backing_stores()
     {
         swap(m_backing_store, m_last_backing_store);
+        invalidate_backing_store_opacity();
     }
 
     GraphicsBitmap* last_backing_store() { return m_last_backing_store.ptr(); }
@@ -126,7 +128,17 @@ public:
     bool global_cursor_tracking() const { return m_global_cursor_tracking_enabled || m_automatic_cursor_tracking_enabled; }
 
     bool has_alpha_channel() const { return m_has_alpha_channel; }
-    void set_has_alpha_channel(bool value) { m_has_alpha_channel = value; }
+    void set_has_alpha_channel(bool);
+
+    // Whether the window hides everything behind its frame rect. A window with
+    // an alpha channel does so only while its backing store is fully opaque.
+    bool is_opaque() const;
+    void invalidate_backing_store_opacity();
+
+    // The parts of the frame rect that are on screen and not behind an opaque
+    // window. Kept up to date by WSCompositor.
+    const DisjointRectSet& visible_rects() const { return m_visible_rects; }
+    void set_visible_rects(DisjointRectSet&& rects) { m_visible_rects = move(rects); }
 
     Size size_increment() const { return m_size_increment; }
     void set_size_increment(const Size& increment) { m_size_increment = increment; }
@@ -171,6 +183,9 @@ private:
     bool m_show_titlebar { true };
     RefPtr<GraphicsBitmap> m_backing_store;
     RefPtr<GraphicsBitmap> m_last_backing_store;
+    mutable bool m_backing_store_opacity_dirty { true };
+    mutable bool m_backing_store_is_opaque { false };
+    DisjointRectSet m_visible_rects;
     int m_window_id { -1 };
     float m_opacity { 1 };
     Size m_size_increment;
@@ -14,7 +14,6 @@
 #include <LibCore/CTimer.h>
 #include <LibDraw/CharacterBitmap.h>
 #include <LibDraw/Font.h>
-#include <LibDraw/PNGLoader.h>
 #include <LibDraw/Painter.h>
 #include <LibDraw/StylePainter.h>
 #include <WindowServer/WSAPITypes.h>
@@ -95,13 +94,13 @@ WSWindowManager::WSWindowManager()
     int app_identifier = 1;
     for (const auto& app : m_apps) {
         auto parent_menu = m_app_category_menus.get(app.category).value_or(*m_system_menu);
-        parent_menu->add_item(make<WSMenuItem>(*m_system_menu, app_identifier++, app.name, String(), true, false, false, load_png(app.icon_path)));
+        parent_menu->add_item(make<WSMenuItem>(*m_system_menu, app_identifier++, app.name, String(), true, false, false, GraphicsBitmap::load_from_file(app.icon_path)));
     }
 
     m_system_menu->add_item(make<WSMenuItem>(*m_system_menu, WSMenuItem::Separator));
     m_system_menu->add_item(make<WSMenuItem>(*m_system_menu, 100, "Reload WM Config File"));
     m_system_menu->add_item(make<WSMenuItem>(*m_system_menu, WSMenuItem::Separator));
-    m_system_menu->add_item(make<WSMenuItem>(*m_system_menu, 200, "About...", String(), true, false, false, load_png("/res/icons/16x16/ladybug.png")));
+    m_system_menu->add_item(make<WSMenuItem>(*m_system_menu, 200, "About...", String(), true, false, false, GraphicsBitmap::load_from_file("/res/icons/16x16/ladybug.png")));
     m_system_menu->add_item(make<WSMenuItem>(*m_system_menu, WSMenuItem::Separator));
     m_system_menu->add_item(make<WSMenuItem>(*m_system_menu, 300, "Shutdown..."));
     m_system_menu->on_item_activation = [this](WSMenuItem& item) {
@@ -272,6 +271,7 @@ void WSWindowManager::set_current_menubar(WSMenuBar* menubar)
 void WSWindowManager::add_window(WSWindow& window)
 {
     m_windows_in_order.append(&window);
+    WSCompositor::the().invalidate_occlusions();
 
     if (window.is_fullscreen()) {
         CEventLoop::current().post_event(window, make<WSResizeEvent>(window.rect(), WSScreen::the().rect()));
@@ -304,6 +304,7 @@ void WSWindowManager::move_to_front_and_make_active(WSWindow& window)
         invalidate(window);
     m_windows_in_order.remove(&window);
     m_windows_in_order.append(&window);
+    WSCompositor::the().invalidate_occlusions();
 
     set_active_window(&window);
 }
@@ -312,6 +313,7 @@ void WSWindowManager::remove_window(WSWindow& window)
 {
     invalidate(window);
     m_windows_in_order.remove(&window);
+    WSCompositor::the().invalidate_occlusions();
     if (window.is_active())
         pick_new_active_window();
     if (m_switcher.is_visible() && window.type() != WSWindowType::WindowSwitcher)
@@ -396,6 +398,7 @@ void WSWindowManager::notify_rect_changed(WSWindow& window, const Rect& old_rect
     if (m_switcher.is_visible() && window.type() != WSWindowType::WindowSwitcher)
         m_switcher.refresh();
     tell_wm_listeners_window_rect_changed(window);
+    WSCompositor::the().invalidate_occlusions();
 }
 
 void WSWindowManager::notify_minimization_state_changed(WSWindow& window)
@@ -507,7 +510,7 @@ bool WSWindowManager::process_ongoing_window_drag(WSMouseEvent& event, WSWindow*
             }
         } else {
             Point pos = m_drag_window_origin.translated(event.position() - m_drag_origin);
-            m_drag_window->set_position_without_repaint(pos);
+            WSCompositor::the().move_window(*m_drag_window, pos);
             if (m_drag_window->rect().contains(event.position()))
                 hovered_window = m_drag_window;
             return true;
@@ -871,58 +874,6 @@ void WSWindowManager::clear_resize_candidate()
     m_resize_candidate = nullptr;
 }
 
-bool WSWindowManager::any_opaque_window_contains_rect(const Rect& rect)
-{
-    bool found_containing_window = false;
-    for_each_window([&](WSWindow& window) {
-        if (!window.is_visible())
-            return IterationDecision::Continue;
-        if (window.is_minimized())
-            return IterationDecision::Continue;
-        if (window.opacity() < 1.0f)
-            return IterationDecision::Continue;
-        if (window.has_alpha_channel()) {
-            // FIXME: Just because the window has an alpha channel doesn't mean it's not opaque.
-            //        Maybe there's some way we could know this?
-            return IterationDecision::Continue;
-        }
-        if (window.frame().rect().contains(rect)) {
-            found_containing_window = true;
-            return IterationDecision::Break;
-        }
-        return IterationDecision::Continue;
-    });
-    return found_containing_window;
-};
-
-bool WSWindowManager::any_opaque_window_above_this_one_contains_rect(const WSWindow& a_window, const Rect& rect)
-{
-    bool found_containing_window = false;
-    bool checking = false;
-    for_each_visible_window_from_back_to_front([&](WSWindow& window) {
-        if (&window == &a_window) {
-            checking = true;
-            return IterationDecision::Continue;
-        }
-        if (!checking)
-            return IterationDecision::Continue;
-        if (!window.is_visible())
-            return IterationDecision::Continue;
-        if (window.is_minimized())
-            return IterationDecision::Continue;
-        if (window.opacity() < 1.0f)
-            return IterationDecision::Continue;
-        if (window.has_alpha_channel())
-            return IterationDecision::Continue;
-        if (window.frame().rect().contains(rect)) {
-            found_containing_window = true;
-            return IterationDecision::Break;
-        }
-        return IterationDecision::Continue;
-    });
-    return found_containing_window;
-};
-
 Rect WSWindowManager::menubar_rect() const
 {
     if (active_fullscreen_window())
@@ -970,6 +921,7 @@ void WSWindowManager::set_highlight_window(WSWindow* window)
     if (auto* previous_highlight_window = m_highlight_window.ptr())
         invalidate(*previous_highlight_window);
     m_highlight_window = window ? window->make_weak_ptr() : nullptr;
+    WSCompositor::the().invalidate_occlusions();
     if (m_highlight_window)
         invalidate(*m_highlight_window);
 }
@@ -991,6 +943,8 @@ void WSWindowManager::set_active_window(WSWindow* window)
         invalidate(*previously_active_window);
     }
     m_active_window = window->make_weak_ptr();
+    // Only the active window is shown in fullscreen.
+    WSCompositor::the().invalidate_occlusions();
     if (m_active_window) {
         CEventLoop::current().post_event(*m_active_window, make<WSEvent>(WSEvent::WindowActivated));
         invalidate(*m_active_window);
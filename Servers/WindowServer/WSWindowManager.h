@@ -125,9 +125,6 @@ public:
     void clear_resize_candidate();
     ResizeDirection resize_direction_of_window(const WSWindow&);
 
-    bool any_opaque_window_contains_rect(const Rect&);
-    bool any_opaque_window_above_this_one_contains_rect(const WSWindow&, const Rect&);
-
     void tell_wm_listeners_window_state_changed(WSWindow&);
     void tell_wm_listeners_window_icon_changed(WSWindow&);
     void tell_wm_listeners_window_rect_changed(WSWindow&);
@@ -1,6 +1,7 @@
 #include <LibCore/CConfigFile.h>
 #include <WindowServer/WSCompositor.h>
 #include <WindowServer/WSEventLoop.h>
+#include <WindowServer/WSImageCache.h>
 #include <WindowServer/WSScreen.h>
 #include <WindowServer/WSWindowManager.h>
 #include <signal.h>
@@ -19,6 +20,7 @@ int main(int, char**)
     }
 
     WSEventLoop loop;
+    SharedImageCache::install(WSImageCache::the());
 
     auto wm_config = CConfigFile::get_for_app("WindowManager");
     WSScreen screen(wm_config->read_num_entry("Screen", "Width", 1024),
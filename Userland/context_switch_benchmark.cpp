@@ -0,0 +1,107 @@
+#include <LibCore/CElapsedTimer.h>
+#include <getopt.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+void exit_with_usage(int rc)
+{
+    fprintf(stderr, "Usage: context_switch_benchmark [-h] [-n round_trips]\n");
+    exit(rc);
+}
+
+// Two processes bounce a byte back and forth over a pair of pipes, so every
+// round trip costs two blocking reads and two context switches.
+static int benchmark_pipe_ping_pong(int round_trips)
+{
+    int ping[2];
+    int pong[2];
+    if (pipe(ping) < 0 || pipe(pong) < 0) {
+        perror("pipe");
+        return 1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+
+    char byte = 0;
+    if (pid == 0) {
+        for (int i = 0; i < round_trips; ++i) {
+            if (read(ping[0], &byte, 1) != 1 || write(pong[1], &byte, 1) != 1)
+                _exit(1);
+        }
+        _exit(0);
+    }
+
+    CElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < round_trips; ++i) {
+        if (write(ping[1], &byte, 1) != 1 || read(pong[0], &byte, 1) != 1) {
+            perror("ping-pong");
+            return 1;
+        }
+    }
+    int elapsed_ms = timer.elapsed();
+    waitpid(pid, nullptr, 0);
+
+    int switches = round_trips * 2;
+    printf("pipe ping-pong: %d switches in %d ms, %d ns/switch\n", switches, elapsed_ms, elapsed_ms ? (int)((long long)elapsed_ms * 1000000 / switches) : 0);
+    return 0;
+}
+
+// Two processes yield to each other in a loop. This measures the scheduler
+// and switch path without any I/O blocking in between.
+static int benchmark_yield(int iterations)
+{
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (pid == 0) {
+        for (int i = 0; i < iterations; ++i)
+            sched_yield();
+        _exit(0);
+    }
+
+    CElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        sched_yield();
+    int elapsed_ms = timer.elapsed();
+    waitpid(pid, nullptr, 0);
+
+    printf("sched_yield: %d yields in %d ms, %d ns/yield\n", iterations, elapsed_ms, elapsed_ms ? (int)((long long)elapsed_ms * 1000000 / iterations) : 0);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    int round_trips = 100000;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:")) != -1) {
+        switch (opt) {
+        case 'h':
+            exit_with_usage(0);
+            break;
+        case 'n':
+            round_trips = atoi(optarg);
+            break;
+        default:
+            exit_with_usage(1);
+        }
+    }
+
+    if (round_trips <= 0)
+        exit_with_usage(1);
+
+    if (benchmark_pipe_ping_pong(round_trips))
+        return 1;
+    return benchmark_yield(round_trips);
+}
@@ -0,0 +1,115 @@
+#include <LibCore/CElapsedTimer.h>
+#include <LibDraw/GraphicsBitmap.h>
+#include <LibDraw/Painter.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void exit_with_usage(int rc)
+{
+    fprintf(stderr, "Usage: draw_benchmark [-h] [-s size] [-n iterations]\n");
+    exit(rc);
+}
+
+// A source with a bit of everything: fully opaque and fully transparent runs,
+// like most icons and shadows have, and translucent gradients in between.
+static NonnullRefPtr<GraphicsBitmap> create_source(int size)
+{
+    auto bitmap = GraphicsBitmap::create(GraphicsBitmap::Format::RGBA32, { size, size });
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            u8 alpha;
+            if (y < size / 3)
+                alpha = 255;
+            else if (y < 2 * size / 3)
+                alpha = x * 255 / size;
+            else
+                alpha = x < size / 2 ? 0 : 128;
+            bitmap->scanline(y)[x] = Color(x * 255 / size, y * 255 / size, 128, alpha).value();
+        }
+    }
+    return bitmap;
+}
+
+template<typename Callback>
+static void benchmark(const char* name, int size, int iterations, Callback callback)
+{
+    CElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        callback();
+    int elapsed_ms = timer.elapsed();
+
+    u64 pixels = (u64)size * size * iterations;
+    printf("%-20s %6d ms  %6u Mpixels/s\n", name, elapsed_ms, elapsed_ms ? (u32)(pixels / 1000 / elapsed_ms) : 0);
+}
+
+int main(int argc, char** argv)
+{
+    int size = 512;
+    int iterations = 100;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hs:n:")) != -1) {
+        switch (opt) {
+        case 'h':
+            exit_with_usage(0);
+            break;
+        case 's':
+            size = atoi(optarg);
+            break;
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        default:
+            exit_with_usage(1);
+        }
+    }
+
+    if (size <= 0 || iterations <= 0)
+        exit_with_usage(1);
+
+    auto target = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, { size, size });
+    target->fill(Color::from_rgb(0x336699));
+    auto source = create_source(size);
+    auto opaque_source = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, { size, size });
+    opaque_source->fill(Color::from_rgb(0xcc8844));
+    Painter painter(*target);
+
+    printf("Blitting %dx%d pixels %d times\n", size, size, iterations);
+    benchmark("blit", size, iterations, [&] {
+        painter.blit({}, *opaque_source, opaque_source->rect());
+    });
+    benchmark("blit with alpha", size, iterations, [&] {
+        painter.blit({}, *source, source->rect());
+    });
+    benchmark("blit with opacity", size, iterations, [&] {
+        painter.blit({}, *opaque_source, opaque_source->rect(), 0.5f);
+    });
+    benchmark("blit dimmed", size, iterations, [&] {
+        painter.blit_dimmed({}, *source, source->rect());
+    });
+
+    // Not by a whole factor, which has its own nearest neighbor path.
+    auto small_source = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, { max(1, size * 2 / 3), max(1, size * 2 / 3) });
+    small_source->fill(Color::from_rgb(0x88cc44));
+    auto large_source = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, { size * 5 / 2, size * 5 / 2 });
+    large_source->fill(Color::from_rgb(0x4488cc));
+    printf("\nScaling to %dx%d pixels %d times\n", size, size, iterations);
+    benchmark("enlarge", size, iterations, [&] {
+        painter.draw_scaled_bitmap(target->rect(), *small_source, small_source->rect());
+    });
+    benchmark("enlarge smooth", size, iterations, [&] {
+        painter.draw_scaled_bitmap(target->rect(), *small_source, small_source->rect(), Painter::ScalingMode::Smooth);
+    });
+    benchmark("shrink", size, iterations, [&] {
+        painter.draw_scaled_bitmap(target->rect(), *large_source, large_source->rect());
+    });
+    benchmark("shrink smooth", size, iterations, [&] {
+        painter.draw_scaled_bitmap(target->rect(), *large_source, large_source->rect(), Painter::ScalingMode::Smooth);
+    });
+    benchmark("smooth with alpha", size, iterations, [&] {
+        painter.draw_scaled_bitmap(target->rect(), *source, small_source->rect(), Painter::ScalingMode::Smooth);
+    });
+    return 0;
+}
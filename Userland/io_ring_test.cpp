@@ -0,0 +1,90 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/io_ring.h>
+#include <unistd.h>
+
+// Pushes a message through a pipe and back out again with one io_ring batch,
+// then checks that a read from the now empty, non-blocking pipe completes with
+// EAGAIN instead of holding up the entries queued behind it.
+
+static const unsigned entry_count = 8;
+
+static io_ring* create_ring()
+{
+    auto* ring = (io_ring*)calloc(1, IO_RING_SIZE(entry_count));
+    ring->entry_count = entry_count;
+    return ring;
+}
+
+static void submit(io_ring* ring, unsigned opcode, unsigned user_data, int fd, void* buffer, size_t length)
+{
+    auto& submission = io_ring_submissions(ring)[ring->submission_tail & (entry_count - 1)];
+    memset(&submission, 0, sizeof(submission));
+    submission.opcode = opcode;
+    submission.user_data = user_data;
+    submission.fd = fd;
+    submission.buffer = buffer;
+    submission.length = length;
+    ++ring->submission_tail;
+}
+
+static bool expect_completion(io_ring* ring, unsigned user_data, int result)
+{
+    if (ring->completion_head == ring->completion_tail) {
+        fprintf(stderr, "FAIL: no completion for entry %u\n", user_data);
+        return false;
+    }
+    auto& completion = io_ring_completions(ring)[ring->completion_head & (entry_count - 1)];
+    ++ring->completion_head;
+    if (completion.user_data != user_data || completion.result != result) {
+        fprintf(stderr, "FAIL: entry %u completed with %d, expected entry %u with %d\n", completion.user_data, completion.result, user_data, result);
+        return false;
+    }
+    return true;
+}
+
+int main(int, char**)
+{
+    int fds[2];
+    if (pipe(fds) < 0) {
+        perror("pipe");
+        return 1;
+    }
+    if (fcntl(fds[0], F_SETFL, O_NONBLOCK) < 0) {
+        perror("fcntl");
+        return 1;
+    }
+
+    auto* ring = create_ring();
+    const char message[] = "Hello through the ring!";
+    char received[sizeof(message)] = {};
+
+    submit(ring, IORING_OP_WRITE, 1, fds[1], const_cast<char*>(message), sizeof(message));
+    submit(ring, IORING_OP_READ, 2, fds[0], received, sizeof(received));
+    submit(ring, IORING_OP_READ, 3, fds[0], received, sizeof(received));
+    submit(ring, IORING_OP_NOP, 4, -1, nullptr, 0);
+
+    int submitted = io_ring_enter(ring, 4);
+    if (submitted != 4) {
+        fprintf(stderr, "FAIL: io_ring_enter consumed %d entries, expected 4\n", submitted);
+        return 1;
+    }
+
+    bool ok = expect_completion(ring, 1, sizeof(message));
+    ok = expect_completion(ring, 2, sizeof(message)) && ok;
+    ok = expect_completion(ring, 3, -EAGAIN) && ok;
+    ok = expect_completion(ring, 4, 0) && ok;
+    if (memcmp(message, received, sizeof(message))) {
+        fprintf(stderr, "FAIL: read back '%s', expected '%s'\n", received, message);
+        ok = false;
+    }
+
+    free(ring);
+    if (!ok)
+        return 1;
+    printf("PASS\n");
+    return 0;
+}
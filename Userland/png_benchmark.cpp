@@ -0,0 +1,112 @@
+#include <AK/FileSystemPath.h>
+#include <AK/MappedFile.h>
+#include <AK/NonnullOwnPtrVector.h>
+#include <LibCore/CDirIterator.h>
+#include <LibCore/CElapsedTimer.h>
+#include <LibDraw/PNGLoader.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+void exit_with_usage(int rc)
+{
+    fprintf(stderr, "Usage: png_benchmark [-h] [-v] [-n iterations] [path]\n");
+    exit(rc);
+}
+
+struct PNGFile {
+    explicit PNGFile(const String& path)
+        : path(path)
+        , file(path)
+    {
+    }
+
+    String path;
+    MappedFile file;
+};
+
+static void find_pngs(const String& path, NonnullOwnPtrVector<PNGFile>& files)
+{
+    struct stat st;
+    if (stat(path.characters(), &st) < 0) {
+        perror(path.characters());
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        if (path.ends_with(".png")) {
+            auto file = make<PNGFile>(path);
+            if (file->file.is_valid())
+                files.append(move(file));
+        }
+        return;
+    }
+    CDirIterator iterator(path, CDirIterator::SkipDots);
+    while (iterator.has_next())
+        find_pngs(FileSystemPath(String::format("%s/%s", path.characters(), iterator.next_path().characters())).string(), files);
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 10;
+    bool verbose = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hvn:")) != -1) {
+        switch (opt) {
+        case 'h':
+            exit_with_usage(0);
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        case 'n':
+            iterations = atoi(optarg);
+            break;
+        default:
+            exit_with_usage(1);
+        }
+    }
+
+    if (iterations <= 0 || argc - optind > 1)
+        exit_with_usage(1);
+    String root = optind < argc ? argv[optind] : "/res";
+
+    // Map every file up front, so only decoding gets timed.
+    NonnullOwnPtrVector<PNGFile> files;
+    find_pngs(root, files);
+    if (files.is_empty()) {
+        fprintf(stderr, "No PNGs found in %s\n", root.characters());
+        return 1;
+    }
+
+    printf("Decoding %d PNGs from %s %d times\n", files.size(), root.characters(), iterations);
+    u64 total_pixels = 0;
+    u64 total_bytes = 0;
+    int total_ms = 0;
+    int failures = 0;
+    for (auto& png : files) {
+        CElapsedTimer timer;
+        timer.start();
+        RefPtr<GraphicsBitmap> bitmap;
+        for (int i = 0; i < iterations; ++i)
+            bitmap = load_png_from_memory((const u8*)png.file.data(), png.file.size());
+        int elapsed_ms = timer.elapsed();
+
+        if (!bitmap) {
+            fprintf(stderr, "Failed to decode %s\n", png.path.characters());
+            ++failures;
+            continue;
+        }
+        total_ms += elapsed_ms;
+        total_pixels += (u64)bitmap->width() * bitmap->height() * iterations;
+        total_bytes += (u64)png.file.size() * iterations;
+        if (verbose)
+            printf("%6d ms  %4dx%-4d  %s\n", elapsed_ms, bitmap->width(), bitmap->height(), png.path.characters());
+    }
+
+    printf("%d ms in total, %u Mpixels/s, %u KB/s of PNG data\n", total_ms,
+        total_ms ? (u32)(total_pixels / 1000 / total_ms) : 0,
+        total_ms ? (u32)(total_bytes / total_ms) : 0);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/QuickSort.h>
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibCore/CArgsParser.h>
+#include <LibCore/CFile.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct FunctionStatistics {
+    String name;
+    u32 self_count { 0 };
+    u32 total_count { 0 };
+};
+
+struct CallTreeNode {
+    String name;
+    u32 count { 0 };
+    HashMap<String, NonnullOwnPtr<CallTreeNode>> children;
+
+    CallTreeNode& child(const String& child_name)
+    {
+        auto it = children.find(child_name);
+        if (it != children.end())
+            return *it->value;
+        auto node = make<CallTreeNode>();
+        node->name = child_name;
+        auto& node_ref = *node;
+        children.set(child_name, move(node));
+        return node_ref;
+    }
+};
+
+// Symbols come as "name +offset". We only care about which function it is.
+static String function_name(const String& symbol)
+{
+    for (int i = 0; i < symbol.length(); ++i) {
+        if (symbol[i] == ' ')
+            return symbol.substring(0, i);
+    }
+    return symbol;
+}
+
+// LibC's printf can't do fractions, so print tenths of a percent by hand.
+static void print_percentage(u32 count, u32 total)
+{
+    u32 permille = count * 1000 / total;
+    printf("%3u.%u%%", permille / 10, permille % 10);
+}
+
+static void print_call_tree(const CallTreeNode& node, u32 sample_count, int depth, u32 threshold_percent)
+{
+    Vector<const CallTreeNode*> children;
+    for (auto& it : node.children)
+        children.append(it.value.ptr());
+    quick_sort(children.begin(), children.end(), [](auto* a, auto* b) {
+        return a->count > b->count;
+    });
+
+    for (auto* child : children) {
+        if (child->count * 100 < threshold_percent * sample_count)
+            continue;
+        print_percentage(child->count, sample_count);
+        printf("  ");
+        for (int i = 0; i < depth; ++i)
+            printf("  ");
+        printf("%s\n", child->name.characters());
+        print_call_tree(*child, sample_count, depth + 1, threshold_percent);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    CArgsParser args_parser("profile");
+    args_parser.add_arg("t", "seconds", "How long to sample for (default: 5)");
+    args_parser.add_arg("n", "count", "How many functions to list (default: 30)");
+    args_parser.add_arg("g", "Also print a call graph");
+    args_parser.add_required_single_value("pid");
+
+    CArgsParserResult args = args_parser.parse(argc, argv);
+    Vector<String> values = args.get_single_values();
+    if (values.size() != 1) {
+        args_parser.print_usage();
+        return 1;
+    }
+
+    bool ok = false;
+    pid_t pid = values[0].to_uint(ok);
+    if (!ok) {
+        args_parser.print_usage();
+        return 1;
+    }
+
+    unsigned seconds = 5;
+    if (args.is_present("t")) {
+        seconds = args.get("t").to_uint(ok);
+        if (!ok) {
+            args_parser.print_usage();
+            return 1;
+        }
+    }
+
+    int function_count = 30;
+    if (args.is_present("n")) {
+        function_count = args.get("n").to_uint(ok);
+        if (!ok) {
+            args_parser.print_usage();
+            return 1;
+        }
+    }
+
+    if (profiling_enable(pid) < 0) {
+        perror("profiling_enable");
+        return 1;
+    }
+    fprintf(stderr, "Profiling pid %d for %u seconds...\n", pid, seconds);
+    sleep(seconds);
+    if (profiling_disable(pid) < 0) {
+        perror("profiling_disable");
+        return 1;
+    }
+
+    auto file = CFile::construct(String::format("/proc/%d/profile", pid));
+    if (!file->open(CIODevice::ReadOnly)) {
+        fprintf(stderr, "Failed to open %s: %s\n", file->filename().characters(), file->error_string());
+        return 1;
+    }
+    auto json = JsonValue::from_string(file->read_all());
+    if (!json.is_object()) {
+        fprintf(stderr, "Failed to parse %s\n", file->filename().characters());
+        return 1;
+    }
+    auto& profile = json.as_object();
+
+    HashMap<u32, String> function_names;
+    profile.get("symbols").as_object().for_each_member([&](auto& address, auto& symbol) {
+        bool ok;
+        function_names.set(address.to_uint(ok), function_name(symbol.as_string()));
+    });
+
+    HashMap<String, FunctionStatistics> statistics;
+    CallTreeNode root;
+    u32 sample_count = 0;
+
+    profile.get("samples").as_array().for_each([&](auto& sample_value) {
+        auto frames_value = sample_value.as_object().get("frames");
+        auto& frames = frames_value.as_array();
+        if (frames.is_empty())
+            return;
+        ++sample_count;
+
+        Vector<String> stack;
+        for (int i = 0; i < frames.size(); ++i) {
+            auto it = function_names.find(frames.at(i).to_u32());
+            stack.append(it != function_names.end() ? it->value : String("??"));
+        }
+
+        auto& leaf = statistics.ensure(stack.first());
+        leaf.name = stack.first();
+        ++leaf.self_count;
+
+        // Recursive functions appear more than once, but only count once.
+        HashTable<String> seen;
+        for (auto& name : stack) {
+            if (seen.contains(name))
+                continue;
+            seen.set(name);
+            auto& function = statistics.ensure(name);
+            function.name = name;
+            ++function.total_count;
+        }
+
+        auto* node = &root;
+        for (int i = stack.size() - 1; i >= 0; --i) {
+            node = &node->child(stack[i]);
+            ++node->count;
+        }
+    });
+
+    printf("%u samples", sample_count);
+    if (auto dropped = profile.get("dropped_samples").to_u32())
+        printf(" (%u older samples dropped)", dropped);
+    printf("\n\n");
+    if (!sample_count)
+        return 0;
+
+    Vector<FunctionStatistics> functions;
+    for (auto& it : statistics)
+        functions.append(it.value);
+    quick_sort(functions.begin(), functions.end(), [](auto& a, auto& b) {
+        if (a.self_count != b.self_count)
+            return a.self_count > b.self_count;
+        return a.total_count > b.total_count;
+    });
+
+    printf(" Self   Total   Function\n");
+    for (int i = 0; i < functions.size() && i < function_count; ++i) {
+        auto& function = functions[i];
+        print_percentage(function.self_count, sample_count);
+        printf("  ");
+        print_percentage(function.total_count, sample_count);
+        printf("  %s\n", function.name.characters());
+    }
+
+    if (args.is_present("g")) {
+        printf("\nCall graph (callers above callees, at least 1%% of samples):\n");
+        print_call_tree(root, sample_count, 0, 1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include <LibGUI/GApplication.h>
+#include <LibGUI/GWindowServerConnection.h>
+#include <stdio.h>
+
+// LibC's printf can't do fractions, so print milliseconds with three decimals by hand.
+static void print_duration(const char* name, unsigned microseconds)
+{
+    printf("  %-8s %3u.%03u ms", name, microseconds / 1000, microseconds % 1000);
+}
+
+int main(int argc, char** argv)
+{
+    GApplication app(argc, argv);
+
+    WSAPI_ClientMessage request;
+    request.type = WSAPI_ClientMessage::Type::GetCompositorStatistics;
+    auto response = GWindowServerConnection::the().sync_request(request, WSAPI_ServerMessage::Type::DidGetCompositorStatistics);
+    auto& stats = response.compositor;
+
+    printf("%u frames composed, at most %u per second\n", stats.frame_count, stats.frame_rate);
+    if (!stats.frame_sample_count)
+        return 0;
+
+    printf("\nLast frame (%u rects):\n", stats.last_rect_count);
+    print_duration("compose", stats.last_compose_us);
+    print_duration("flush", stats.last_flush_us);
+    printf("\n\nLast %u frames:\n", stats.frame_sample_count);
+    print_duration("compose", stats.average_compose_us);
+    print_duration("flush", stats.average_flush_us);
+    printf("  (average)\n");
+    print_duration("compose", stats.max_compose_us);
+    print_duration("flush", stats.max_flush_us);
+    printf("  (worst)\n");
+    return 0;
+}